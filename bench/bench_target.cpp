@@ -0,0 +1,47 @@
+// Injection target for window_mod_bench: one small visible top-level window
+// and a message loop.  Exits on WM_CLOSE, or after ten minutes so that an
+// aborted benchmark run leaves nothing behind.
+//
+//   bench_target            (spawned by window_mod_bench; no arguments)
+
+#include <windows.h>
+
+static const wchar_t* const TARGET_CLASS = L"WindowModBenchTarget";
+static const UINT_PTR       IDT_EXIT     = 1;
+
+static LRESULT CALLBACK TargetWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    switch (msg) {
+    case WM_TIMER:
+        if (wParam == IDT_EXIT) DestroyWindow(hwnd);
+        return 0;
+    case WM_DESTROY:
+        PostQuitMessage(0);
+        return 0;
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+int main()
+{
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc   = TargetWndProc;
+    wc.hInstance     = GetModuleHandleW(nullptr);
+    wc.hbrBackground = reinterpret_cast<HBRUSH>(COLOR_WINDOW + 1);
+    wc.lpszClassName = TARGET_CLASS;
+    if (!RegisterClassW(&wc)) return 1;
+
+    HWND hwnd = CreateWindowExW(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, TARGET_CLASS,
+        L"window_mod_bench target", WS_OVERLAPPED | WS_CAPTION,
+        0, 0, 240, 120, nullptr, nullptr, wc.hInstance, nullptr);
+    if (!hwnd) return 1;
+    ShowWindow(hwnd, SW_SHOWNOACTIVATE);
+    SetTimer(hwnd, IDT_EXIT, 10 * 60 * 1000, nullptr);
+
+    MSG msg;
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+// Timing helpers shared by the benches.  Each returns the median of its
+// samples, so one preempted run does not skew a result.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Wall time of one call of fn, in milliseconds.
+template<typename F>
+static double TimeMs(F&& fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+// Median of v (reordered).
+static inline double Median(std::vector<double>& v)
+{
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+// Median wall time of `iterations` calls of fn, in milliseconds.
+template<typename F>
+static double MedianMs(int iterations, F&& fn)
+{
+    fn();   // warm-up: page in buffers, grow scratch
+    std::vector<double> ms;
+    ms.reserve(iterations);
+    for (int i = 0; i < iterations; ++i)
+        ms.push_back(TimeMs(fn));
+    return Median(ms);
+}
+
+// Median wall time of `iterations` calls of fn, in microseconds.
+template<typename F>
+static double MedianUs(int iterations, F&& fn)
+{
+    return MedianMs(iterations, fn) * 1e3;
+}
+
+// Median of 5 runs of fn(), which returns seconds; reported as ns per item.
+template<typename F>
+static double MedianNs(size_t items, F&& fn)
+{
+    std::vector<double> ns;
+    for (int i = 0; i < 5; ++i)
+        ns.push_back(fn() * 1e9 / static_cast<double>(items));
+    return Median(ns);
+}
+
+// Median of 5 runs of fn(), which returns seconds; reported as M items/s.
+template<typename F>
+static double MedianRate(size_t items, F&& fn)
+{
+    std::vector<double> rates;
+    for (int i = 0; i < 5; ++i)
+        rates.push_back(static_cast<double>(items) / fn() / 1e6);
+    return Median(rates);
+}
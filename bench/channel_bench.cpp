@@ -0,0 +1,121 @@
+// Micro-benchmark: the worker channels and the preview frame handoff.
+//
+//   Channel<T> (mutex + condvar + deque) vs MpscChannel<T, N> (lock-free ring)
+//   with 1, 2 and 4 producers feeding one consumer that blocks in recv(), and
+//   a mutex-protected pointer vs LatestSlot<T> for "latest frame wins".
+//
+//   channel_bench [messages]      default 1000000 per case; prints the median
+//                                 of 5 runs in million messages per second
+
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bench_timing.h"
+#include "channel.h"
+
+// Same size as InjectorEvent.
+struct Event {
+    int   type     = 0;
+    HWND  hwnd     = nullptr;
+    DWORD winEvent = 0;
+};
+
+// `producers` threads send messages / producers events each; the calling
+// thread receives all of them.  Returns the elapsed seconds.
+template<typename Ch>
+static double RunChannel(Ch& ch, int producers, size_t messages)
+{
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    const size_t perProducer = messages / producers;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ch, &go, perProducer, p] {
+            while (!go.load(std::memory_order_acquire)) {}
+            Event e;
+            e.type = p;
+            for (size_t i = 0; i < perProducer; ++i) {
+                e.winEvent = static_cast<DWORD>(i);
+                ch.send(e);
+            }
+        });
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    Event e;
+    for (size_t n = perProducer * producers; n > 0; --n)
+        ch.recv(e);
+    auto t1 = std::chrono::steady_clock::now();
+    for (auto& t : threads) t.join();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+// The old preview handoff: a pointer under a mutex.
+struct MutexSlot {
+    std::mutex mtx;
+    int*       ptr = nullptr;
+    int* publish(int* v) { std::lock_guard<std::mutex> lk(mtx); int* old = ptr; ptr = v; return old; }
+    int* take()          { std::lock_guard<std::mutex> lk(mtx); int* old = ptr; ptr = nullptr; return old; }
+};
+
+// One producer publishes `messages` values while the consumer keeps taking
+// until it has seen the last one.  Returns the elapsed seconds.
+template<typename Slot>
+static double RunSlot(Slot& slot, size_t messages)
+{
+    std::vector<int> values(messages);
+    for (size_t i = 0; i < messages; ++i) values[i] = static_cast<int>(i);
+    std::atomic<bool> go{false};
+    auto t0 = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        while (!go.load(std::memory_order_acquire)) {}
+        for (size_t i = 0; i < messages; ++i) slot.publish(&values[i]);
+    });
+    go.store(true, std::memory_order_release);
+    const int* lastValue = &values[messages - 1];
+    for (;;) {
+        int* v = slot.take();
+        if (v == lastValue) break;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    producer.join();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char** argv)
+{
+    size_t messages = (argc > 1) ? static_cast<size_t>((std::max)(1000, atoi(argv[1]))) : 1000000;
+
+    printf("%zu messages per case, median of 5 runs, million messages per second\n\n", messages);
+    printf("%-10s  %-28s %10s\n", "producers", "channel", "Mmsg/s");
+
+    static MpscChannel<Event, 4096> ring;   // INJECTOR_QUEUE_SIZE
+    for (int producers : { 1, 2, 4 }) {
+        double rate = MedianRate(messages, [&] {
+            Channel<Event> ch;
+            return RunChannel(ch, producers, messages);
+        });
+        printf("%-10d  %-28s %10.2f\n", producers, "Channel (mutex+condvar)", rate);
+        rate = MedianRate(messages, [&] { return RunChannel(ring, producers, messages); });
+        printf("%-10d  %-28s %10.2f\n", producers, "MpscChannel<4096>", rate);
+    }
+
+    printf("\n%-10s  %-28s %10s\n", "", "preview slot", "Mpub/s");
+    {
+        MutexSlot slot;
+        printf("%-10s  %-28s %10.2f\n", "1",  "mutex + pointer",
+               MedianRate(messages, [&] { return RunSlot(slot, messages); }));
+    }
+    {
+        LatestSlot<int> slot;
+        printf("%-10s  %-28s %10.2f\n", "1", "LatestSlot",
+               MedianRate(messages, [&] { return RunSlot(slot, messages); }));
+    }
+    return 0;
+}
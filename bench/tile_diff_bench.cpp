@@ -0,0 +1,65 @@
+// Micro-benchmark: CountDifferentTiles (the capture-leak check comparison)
+// with every kernel available on this CPU, on a typical check grab
+// (512 x 288) and on full 1080p / 4K frames, half of whose tiles differ.
+//
+//   tile_diff_bench [iterations]      default 200; prints the median per call
+
+#include <windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_timing.h"
+#include "tile_diff.h"
+
+int main(int argc, char** argv)
+{
+    int iterations = (argc > 1) ? std::max(1, atoi(argv[1])) : 200;
+
+    struct Case { const char* name; int w, h; };
+    static const Case cases[] = {
+        { "check",  512,  288 },
+        { "1080p", 1920, 1080 },
+        { "4K",    3840, 2160 },
+    };
+    static const char* const impls[] = { "scalar", "sse2", "avx2" };
+    const char* detected = TileDiffImplName();
+
+    printf("detected kernel: %s, %d iterations, median us per call\n\n", detected, iterations);
+    printf("%-6s  %10s  %10s  %10s\n", "size", impls[0], impls[1], impls[2]);
+
+    for (const Case& c : cases) {
+        const size_t stride = static_cast<size_t>(c.w) * 4;
+        std::vector<uint8_t> a(stride * c.h), b;
+        for (size_t i = 0; i < a.size(); ++i)
+            a[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+        b = a;
+        // Every other tile column gets a different picture.
+        for (int y = 0; y < c.h; ++y)
+            for (int x = 0; x < c.w; ++x)
+                if ((x / TILE_DIFF_SIZE) % 2 == 0)
+                    b[y * stride + x * 4] ^= 0x80;
+
+        const size_t expected = static_cast<size_t>(TileDiffRows(c.h))
+                              * ((TileDiffCols(c.w) + 1) / 2);
+        printf("%-6s", c.name);
+        for (const char* impl : impls) {
+            if (!TileDiffSelectImpl(impl)) {
+                printf("  %10s", "n/a");
+                continue;
+            }
+            size_t found = 0;
+            double us = MedianUs(iterations, [&] {
+                found = CountDifferentTiles(a.data(), b.data(), c.w, c.h, stride);
+            });
+            printf("  %10.1f", us);
+            if (found != expected)
+                printf(" (%zu tiles, expected %zu - kernel is broken)", found, expected);
+        }
+        printf("\n");
+    }
+    TileDiffSelectImpl(detected);
+    return 0;
+}
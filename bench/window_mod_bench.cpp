@@ -0,0 +1,558 @@
+// Benchmark suite for window_mod's hot paths, without the dialog.  Results
+// are written as JSON so runs can be compared between releases.
+//
+//   enumerate_windows   EnumerateWindows() with N extra dummy top-level windows
+//   inject_same_arch    InjectWDASetAffinity round trips into bench_target.exe,
+//                       auto-unload and resident-agent modes
+//   inject_cross_arch   the same against an opposite-arch bench_target.exe
+//                       (--cross-target; needs wda_inject_<arch>.dll and
+//                       wda_launcher_<arch>.exe of that arch next to this exe)
+//   capture_bitblt      the capture worker's BitBlt frame path: BitBlt, tile
+//                       hash and downscale to the preview, at several sizes
+//   window_list         the virtual window list's resize + repaint
+//                       (SyncWindowListCount) with 100 / 1000 rows
+//
+//   window_mod_bench [--iterations N] [--windows N,N,...] [--cross-target PATH]
+//                    [--out FILE] [--verbose]
+//
+// Injection and window-list cases show windows briefly at the top-left of
+// the primary monitor; the capture case reads whatever is on screen.
+
+#include <windows.h>
+#include <commctrl.h>
+#include <shellapi.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_sinks.h>
+
+#include "bench_timing.h"
+#include "capture_frame.h"
+#include "dib_pool.h"
+#include "injector.h"
+#include "stats.h"
+#include "tile_hash.h"
+#include "window_list.h"
+#include "window_ops.h"
+#include "window_row.h"
+
+// ---------------------------------------------------------------------------
+// Results
+
+struct Result {
+    std::string         name;
+    std::string         params;     // JSON object members, e.g. "\"windows\": 100"
+    std::vector<double> ms;         // one sample per iteration
+    int                 failures = 0;
+    std::string         skipped;    // reason, if the case did not run
+};
+
+static std::vector<Result> g_results;
+
+static std::string JsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for (char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+static std::string Utf8(const std::wstring& ws)
+{
+    if (ws.empty()) return {};
+    int n = WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, nullptr, 0, nullptr, nullptr);
+    std::string s(static_cast<size_t>(n > 0 ? n - 1 : 0), '\0');
+    if (n > 1) WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, &s[0], n, nullptr, nullptr);
+    return s;
+}
+
+// main's argv[index] as UTF-16.  argv went through the ANSI code page, which
+// may have lost characters of a path, so the wide command line is read
+// again; the ANSI string is only the fallback.
+static std::wstring WideArg(int index, const char* arg)
+{
+    std::wstring ws;
+    int     argc  = 0;
+    LPWSTR* wargv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (wargv && index < argc) {
+        ws = wargv[index];
+    } else {
+        int n = MultiByteToWideChar(CP_ACP, 0, arg, -1, nullptr, 0);
+        ws.assign(static_cast<size_t>(n > 0 ? n - 1 : 0), L'\0');
+        if (n > 1) MultiByteToWideChar(CP_ACP, 0, arg, -1, &ws[0], n);
+    }
+    if (wargv) LocalFree(wargv);
+    return ws;
+}
+
+// Keep our own windows responsive between cases.
+static void PumpMessages()
+{
+    MSG msg;
+    while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+}
+
+static std::wstring ExeDir()
+{
+    wchar_t buf[MAX_PATH] = {};
+    GetModuleFileNameW(nullptr, buf, MAX_PATH);
+    std::wstring dir(buf);
+    size_t slash = dir.find_last_of(L"\\/");
+    return slash == std::wstring::npos ? L"." : dir.substr(0, slash);
+}
+
+// ---------------------------------------------------------------------------
+// enumerate_windows
+
+static const wchar_t* const DUMMY_CLASS = L"WindowModBenchDummy";
+
+static void BenchEnumerate(int iterations, const std::vector<int>& counts)
+{
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc   = DefWindowProcW;
+    wc.hInstance     = GetModuleHandleW(nullptr);
+    wc.lpszClassName = DUMMY_CLASS;
+    RegisterClassW(&wc);
+
+    std::vector<HWND> dummies;
+    for (int target : counts) {
+        // Tool windows: visible to EnumerateWindows, no taskbar buttons.
+        // Placed off-screen so nothing is painted.
+        while (static_cast<int>(dummies.size()) < target) {
+            std::wstring title = L"bench dummy " + std::to_wstring(dummies.size());
+            HWND h = CreateWindowExW(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, DUMMY_CLASS,
+                title.c_str(), WS_POPUP | WS_VISIBLE, -32000, -32000, 64, 64,
+                nullptr, nullptr, wc.hInstance, nullptr);
+            if (!h) break;
+            dummies.push_back(h);
+        }
+        PumpMessages();
+
+        Result r;
+        r.name = "enumerate_windows";
+        size_t found = 0;
+        EnumerateWindows();   // warm-up: process cache, icons
+        for (int i = 0; i < iterations; ++i)
+            r.ms.push_back(TimeMs([&] { found = EnumerateWindows().size(); }));
+        r.params = "\"dummy_windows\": " + std::to_string(dummies.size())
+                 + ", \"found\": " + std::to_string(found);
+        g_results.push_back(std::move(r));
+    }
+
+    for (HWND h : dummies) DestroyWindow(h);
+    PumpMessages();
+    UnregisterClassW(DUMMY_CLASS, wc.hInstance);
+}
+
+// ---------------------------------------------------------------------------
+// inject_same_arch / inject_cross_arch
+
+struct Target {
+    PROCESS_INFORMATION pi   = {};
+    HWND                hwnd = nullptr;
+};
+
+struct FindTarget {
+    DWORD pid;
+    HWND  hwnd;
+};
+
+static BOOL CALLBACK FindTargetProc(HWND hwnd, LPARAM lParam)
+{
+    auto* f = reinterpret_cast<FindTarget*>(lParam);
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    if (pid != f->pid || !IsWindowVisible(hwnd)) return TRUE;
+    f->hwnd = hwnd;
+    return FALSE;
+}
+
+static bool SpawnTarget(const std::wstring& path, Target& t, std::string& error)
+{
+    if (GetFileAttributesW(path.c_str()) == INVALID_FILE_ATTRIBUTES) {
+        error = Utf8(path) + " not found";
+        return false;
+    }
+    std::wstring cmd = L"\"" + path + L"\"";
+    STARTUPINFOW si = {};
+    si.cb = sizeof(si);
+    if (!CreateProcessW(nullptr, &cmd[0], nullptr, nullptr, FALSE, CREATE_NO_WINDOW,
+                        nullptr, nullptr, &si, &t.pi)) {
+        error = "CreateProcessW failed (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    WaitForInputIdle(t.pi.hProcess, 5000);
+
+    // The target's window, by PID.
+    FindTarget find = { t.pi.dwProcessId, nullptr };
+    for (int tries = 0; tries < 100 && !find.hwnd; ++tries) {
+        EnumWindows(FindTargetProc, reinterpret_cast<LPARAM>(&find));
+        if (!find.hwnd) Sleep(50);
+    }
+    t.hwnd = find.hwnd;
+    if (!t.hwnd) {
+        error = "bench_target window did not appear";
+        return false;
+    }
+    return true;
+}
+
+static void CloseTarget(Target& t)
+{
+    if (t.hwnd) PostMessageW(t.hwnd, WM_CLOSE, 0, 0);
+    if (t.pi.hProcess) {
+        if (WaitForSingleObject(t.pi.hProcess, 3000) != WAIT_OBJECT_0)
+            TerminateProcess(t.pi.hProcess, 1);
+        CloseHandle(t.pi.hProcess);
+        CloseHandle(t.pi.hThread);
+    }
+    t = Target{};
+}
+
+static void BenchInject(const char* name, const std::wstring& targetPath, int iterations)
+{
+    for (bool resident : { false, true }) {
+        Result r;
+        r.name   = name;
+        r.params = std::string("\"mode\": ") + (resident ? "\"resident\"" : "\"auto_unload\"");
+
+        Target t;
+        if (!SpawnTarget(targetPath, t, r.skipped)) {
+            CloseTarget(t);
+            g_results.push_back(std::move(r));
+            continue;
+        }
+        SetResidentAgentMode(resident);
+
+        // Warm-up: loads the DLL from disk, starts the cross-arch broker or
+        // (resident mode) leaves the agent behind for the timed calls.
+        InjectWDASetAffinity(t.hwnd, WDA_NONE, true);
+        for (int i = 0; i < iterations; ++i) {
+            DWORD affinity = (i % 2 == 0) ? WDA_EXCLUDEFROMCAPTURE : WDA_NONE;
+            bool ok = false;
+            r.ms.push_back(TimeMs([&] { ok = InjectWDASetAffinity(t.hwnd, affinity, true); }));
+            if (!ok) ++r.failures;
+        }
+
+        if (resident) ShutdownResidentAgents();
+        SetResidentAgentMode(false);
+        CloseTarget(t);
+        g_results.push_back(std::move(r));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// capture_bitblt
+
+static void BenchCapture(int iterations)
+{
+    struct Size { int w, h; };
+    static const Size sizes[] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+    const int boxW = 480, boxH = 270;   // preview at the default dialog size
+
+    int vx = GetSystemMetrics(SM_XVIRTUALSCREEN), vy = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    int vw = GetSystemMetrics(SM_CXVIRTUALSCREEN), vh = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+
+    HDC hFrameDC = CreateCompatibleDC(nullptr);
+    for (const Size& s : sizes) {
+        // Screen area beyond the desktop reads back as black, which is not
+        // representative; clip to the virtual screen and report what ran.
+        int w = (std::min)(s.w, vw), h = (std::min)(s.h, vh);
+        int fitW = boxW, fitH = MulDiv(boxW, h, w);
+        if (fitH > boxH) { fitH = boxH; fitW = MulDiv(boxH, w, h); }
+
+        DibPool screenPool(1), framePool(1);
+        screenPool.Resize(w, h);
+        framePool.Resize(fitW, fitH);
+        PooledDib* screen = screenPool.Acquire();
+        PooledDib* frame  = framePool.Acquire();
+        std::string params = "\"requested\": \"" + std::to_string(s.w) + "x" + std::to_string(s.h)
+                           + "\", \"width\": " + std::to_string(w)
+                           + ", \"height\": " + std::to_string(h)
+                           + ", \"preview_width\": " + std::to_string(fitW)
+                           + ", \"preview_height\": " + std::to_string(fitH);
+        Result total, blit, hash, scale;
+        total.name = blit.name = hash.name = scale.name = "capture_bitblt";
+        total.params = params + ", \"phase\": \"total\"";
+        blit.params  = params + ", \"phase\": \"bitblt\"";
+        hash.params  = params + ", \"phase\": \"tile_hash\"";
+        scale.params = params + ", \"phase\": \"downscale\"";
+        if (!screen || !frame) {
+            total.skipped = "CreateDIBSection failed";
+            g_results.push_back(std::move(total));
+            continue;
+        }
+
+        // One frame as CaptureWorkerProc takes it (BitBltFrame), always
+        // downscaled (the cost while the screen is changing).
+        const RECT src = { vx, vy, vx + w, vy + h };
+        TileHasher tiles;
+        BitBltFrameTimes t;
+        BitBltFrame(hFrameDC, src, *screen, tiles, *frame, true, &t);   // warm-up
+        for (int i = 0; i < iterations; ++i) {
+            BitBltFrame(hFrameDC, src, *screen, tiles, *frame, true, &t);
+            blit.ms.push_back(t.blit);
+            hash.ms.push_back(t.hash);
+            scale.ms.push_back(t.scale);
+            total.ms.push_back(t.blit + t.hash + t.scale);
+        }
+
+        for (Result* r : { &total, &blit, &hash, &scale })
+            g_results.push_back(std::move(*r));
+        screenPool.Release(screen);
+        framePool.Release(frame);
+    }
+    DeleteDC(hFrameDC);
+}
+
+// ---------------------------------------------------------------------------
+// window_list
+
+static const wchar_t* const LIST_HOST_CLASS = L"WindowModBenchListHost";
+
+static std::vector<WindowInfo> g_rows;
+
+// The Capture column's text for some rows, as the capture-leak check leaves it.
+static const wchar_t* BenchCaptureText(HWND hwnd)
+{
+    return (reinterpret_cast<UINT_PTR>(hwnd) % 5 == 0) ? L"\u2713" : L"";
+}
+
+// LVN_GETDISPINFO as in the dialog (window_row.h), without icons.
+static LRESULT CALLBACK ListHostProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    if (msg == WM_NOTIFY) {
+        auto* hdr = reinterpret_cast<LPNMHDR>(lParam);
+        if (hdr->code == LVN_GETDISPINFOW) {
+            static const WindowRowLookups lookups = { BenchCaptureText, nullptr };
+            LVITEMW& item = reinterpret_cast<NMLVDISPINFOW*>(lParam)->item;
+            if (item.iItem < 0 || item.iItem >= static_cast<int>(g_rows.size())) return 0;
+            FillWindowRowDispInfo(item, g_rows[item.iItem], lookups);
+            return 0;
+        }
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+static void BenchWindowList(int iterations)
+{
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc   = ListHostProc;
+    wc.hInstance     = GetModuleHandleW(nullptr);
+    wc.lpszClassName = LIST_HOST_CLASS;
+    RegisterClassW(&wc);
+
+    // Must be visible on screen, or nothing is painted.
+    HWND hHost = CreateWindowExW(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, LIST_HOST_CLASS,
+        L"window_mod_bench list", WS_POPUP | WS_VISIBLE, 0, 0, 440, 640,
+        nullptr, nullptr, wc.hInstance, nullptr);
+    HWND hList = CreateWindowExW(0, WC_LISTVIEWW, nullptr,
+        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_OWNERDATA | LVS_SINGLESEL | LVS_SHOWSELALWAYS,
+        0, 0, 440, 640, hHost, nullptr, wc.hInstance, nullptr);
+    if (!hHost || !hList) {
+        Result r;
+        r.name    = "window_list";
+        r.skipped = "could not create the list view";
+        g_results.push_back(std::move(r));
+        if (hHost) DestroyWindow(hHost);
+        UnregisterClassW(LIST_HOST_CLASS, wc.hInstance);
+        return;
+    }
+    ListView_SetExtendedListViewStyle(hList,
+        LVS_EX_FULLROWSELECT | LVS_EX_CHECKBOXES | LVS_EX_DOUBLEBUFFER);
+    ListView_SetCallbackMask(hList, LVIS_STATEIMAGEMASK);
+    InitWindowListColumns(hList);
+    PumpMessages();
+
+    for (int rows : { 100, 1000 }) {
+        g_rows.clear();
+        for (int i = 0; i < rows; ++i) {
+            WindowInfo w;
+            w.hwnd        = reinterpret_cast<HWND>(static_cast<UINT_PTR>(i + 1));
+            w.title       = L"Window " + std::to_wstring(i) + L" - some document title";
+            w.processName = L"process" + std::to_wstring(i % 37) + L".exe";
+            w.isTopMost   = i % 11 == 0;
+            w.isHidden    = i % 17 == 0;
+            w.isExcluded  = i % 7 == 0;
+            g_rows.push_back(std::move(w));
+        }
+
+        Result r;
+        r.name   = "window_list";
+        r.params = "\"rows\": " + std::to_string(rows);
+        ListView_SetItemCountEx(hList, 0, 0);
+        for (int i = -1; i < iterations; ++i) {   // i == -1: warm-up
+            double ms = TimeMs([&] {
+                // SyncWindowListCount(hDlg, 0), then paint what it invalidated.
+                int n = static_cast<int>(g_rows.size());
+                ListView_SetItemCountEx(hList, n, LVSICF_NOSCROLL | LVSICF_NOINVALIDATEALL);
+                ListView_RedrawItems(hList, 0, n - 1);
+                UpdateWindow(hList);
+            });
+            if (i >= 0) r.ms.push_back(ms);
+            PumpMessages();
+        }
+        g_results.push_back(std::move(r));
+    }
+
+    DestroyWindow(hHost);
+    PumpMessages();
+    UnregisterClassW(LIST_HOST_CLASS, wc.hInstance);
+    g_rows.clear();
+}
+
+// ---------------------------------------------------------------------------
+// JSON
+
+static std::string ResultJson(const Result& r)
+{
+    std::string out = "    { \"name\": " + JsonString(r.name);
+    out += ", \"params\": { " + r.params + " }";
+    if (!r.skipped.empty())
+        return out + ", \"skipped\": " + JsonString(r.skipped) + " }";
+
+    std::vector<double> v = r.ms;
+    std::sort(v.begin(), v.end());
+    auto pct = [&](double p) {
+        if (v.empty()) return 0.0;
+        size_t idx = static_cast<size_t>(p * (v.size() - 1) + 0.5);
+        return v[idx];
+    };
+    double sum = 0;
+    for (double x : v) sum += x;
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             ", \"samples\": %zu, \"failures\": %d, \"mean_ms\": %.4f, \"min_ms\": %.4f, "
+             "\"median_ms\": %.4f, \"p95_ms\": %.4f, \"max_ms\": %.4f }",
+             v.size(), r.failures, v.empty() ? 0.0 : sum / v.size(),
+             v.empty() ? 0.0 : v.front(), pct(0.5), pct(0.95), v.empty() ? 0.0 : v.back());
+    return out + buf;
+}
+
+// In-process histograms (stats.h) accumulated over the whole run, e.g. the
+// injection phases behind the inject_* round trips.
+static std::string StatsJson()
+{
+    std::string out;
+    for (int i = 0; i < static_cast<int>(Stat::Count); ++i) {
+        StatSummary s = StatsGet(static_cast<Stat>(i));
+        if (!s.count) continue;
+        std::string name = StatName(static_cast<Stat>(i));
+        name.erase(0, name.find_first_not_of(' '));
+        char buf[192];
+        snprintf(buf, sizeof(buf),
+                 "\"count\": %llu, \"p50_us\": %llu, \"p95_us\": %llu, \"p99_us\": %llu, "
+                 "\"max_us\": %llu",
+                 static_cast<unsigned long long>(s.count), static_cast<unsigned long long>(s.p50),
+                 static_cast<unsigned long long>(s.p95), static_cast<unsigned long long>(s.p99),
+                 static_cast<unsigned long long>(s.max));
+        if (!out.empty()) out += ",\n";
+        out += "    " + JsonString(name) + ": { " + buf + " }";
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    int              iterations = 20;
+    std::vector<int> windowCounts = { 0, 100, 1000 };
+    std::wstring     crossTarget;
+    const char*      outPath = nullptr;
+    bool             verbose = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--iterations" && hasValue) {
+            iterations = (std::max)(1, atoi(argv[++i]));
+        } else if (a == "--windows" && hasValue) {
+            windowCounts.clear();
+            for (const char* p = argv[++i]; *p; ) {
+                windowCounts.push_back((std::max)(0, atoi(p)));
+                const char* comma = strchr(p, ',');
+                if (!comma) break;
+                p = comma + 1;
+            }
+            std::sort(windowCounts.begin(), windowCounts.end());
+        } else if (a == "--cross-target" && hasValue) {
+            ++i;
+            crossTarget = WideArg(i, argv[i]);
+        } else if (a == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (a == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr,
+                    "usage: window_mod_bench [--iterations N] [--windows N,N,...]\n"
+                    "                        [--cross-target PATH] [--out FILE] [--verbose]\n");
+            return 2;
+        }
+    }
+
+    // The injector logs through spdlog; keep stdout for the JSON.
+    auto logger = spdlog::stderr_logger_mt("bench");
+    logger->set_level(verbose ? spdlog::level::debug : spdlog::level::off);
+    spdlog::set_default_logger(logger);
+
+    SetProcessDPIAware();   // physical pixels, as the capture worker uses
+    INITCOMMONCONTROLSEX icc = { sizeof(icc), ICC_LISTVIEW_CLASSES };
+    InitCommonControlsEx(&icc);
+
+    BenchEnumerate(iterations, windowCounts);
+    BenchInject("inject_same_arch", ExeDir() + L"\\bench_target.exe", iterations);
+    if (!crossTarget.empty()) {
+        BenchInject("inject_cross_arch", crossTarget, iterations);
+    } else {
+        Result r;
+        r.name    = "inject_cross_arch";
+        r.skipped = "no --cross-target given";
+        g_results.push_back(std::move(r));
+    }
+    BenchCapture(iterations);
+    BenchWindowList(iterations);
+
+#ifdef _WIN64
+    const char* arch = "x64";
+#else
+    const char* arch = "x86";
+#endif
+    std::string json = "{\n  \"tool\": \"window_mod_bench\",\n  \"schema\": 1,\n";
+    json += std::string("  \"arch\": \"") + arch + "\",\n";
+    json += "  \"iterations\": " + std::to_string(iterations) + ",\n";
+    json += "  \"results\": [\n";
+    for (size_t i = 0; i < g_results.size(); ++i)
+        json += ResultJson(g_results[i]) + (i + 1 < g_results.size() ? ",\n" : "\n");
+    json += "  ],\n  \"stats\": {\n" + StatsJson() + "\n  }\n}\n";
+
+    FILE* out = outPath ? fopen(outPath, "wb") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot open %s\n", outPath);
+        return 1;
+    }
+    fputs(json.c_str(), out);
+    if (out != stdout) fclose(out);
+    return 0;
+}
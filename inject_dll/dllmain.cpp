@@ -2,19 +2,23 @@
  * dllmain.cpp  –  wda_inject.dll
  *
  * This DLL is injected into a target process by window_mod.exe.
- * On DLL_PROCESS_ATTACH it reads the target HWND and desired affinity from a
- * named shared-memory object (written by the injector before injection), then
- * calls SetWindowDisplayAffinity(hwnd, affinity) from within the target process
- * (the only process that is allowed to make this call for its own windows).
+ * On DLL_PROCESS_ATTACH it reads a batch of {HWND, affinity} entries from a
+ * per-PID shared-memory object (written by the injector before injection), then
+ * calls SetWindowDisplayAffinity(hwnd, affinity) for each of them from within
+ * the target process (the only process that is allowed to make this call for
+ * its own windows) and writes the per-entry result back.
+ *
+ * When the injector sets WDA_FLAG_RESIDENT, the DLL additionally starts a
+ * "resident agent" thread that stays loaded and serves further affinity
+ * commands over a per-PID named pipe (see wda_protocol.h).  The agent unloads
+ * the DLL itself when it receives WDA_AGENT_CMD_SHUTDOWN.
  *
  * Requires Windows 10 version 2004 (build 19041) or later for
  * WDA_EXCLUDEFROMCAPTURE.
  */
 
 #include <windows.h>
-
-// Same name as in src/injector.cpp
-#define WDA_SHARED_MEM_NAME  L"Local\\WdaInjectHwnd_WindowMod"
+#include "wda_protocol.h"
 
 #ifndef WDA_NONE
 #define WDA_NONE 0x00000000
@@ -23,57 +27,233 @@
 #define WDA_EXCLUDEFROMCAPTURE 0x00000011
 #endif
 
-// Layout of the shared-memory block (must match src/injector.cpp).
-// Use fixed-width UINT64 for the HWND field so the struct has identical layout
-// in 32-bit and 64-bit builds (HWND is 4 bytes in 32-bit, 8 in 64-bit).
-#pragma pack(push, 1)
-struct WdaSharedData {
-    UINT64 hwnd;     // HWND stored as fixed 64-bit; upper 32 bits = 0
-    DWORD  affinity;
+static HMODULE g_hSelf = nullptr;
+
+// ---------------------------------------------------------------------------
+// Apply the affinity and return ERROR_SUCCESS or the Win32 error code.
+static DWORD ApplyAffinity(HWND hwnd, DWORD affinity)
+{
+    if (!hwnd || !IsWindow(hwnd)) {
+        OutputDebugStringA("wda_inject: HWND is invalid.\n");
+        return ERROR_INVALID_WINDOW_HANDLE;
+    }
+
+    if (SetWindowDisplayAffinity(hwnd, affinity)) {
+        OutputDebugStringA("wda_inject: SetWindowDisplayAffinity succeeded.\n");
+        return ERROR_SUCCESS;
+    }
+
+    DWORD err = GetLastError();
+    char buf[128];
+    wsprintfA(buf, "wda_inject: SetWindowDisplayAffinity failed (error %lu).\n", err);
+    OutputDebugStringA(buf);
+    return err ? err : ERROR_GEN_FAILURE;
+}
+
+// ---------------------------------------------------------------------------
+// Resident agent: one request / one reply per pipe connection.
+// Runs outside the loader lock, so it may freely call into user32.
+// lpParam is the pipe handle created in DllMain.
+static DWORD WINAPI AgentThreadProc(LPVOID lpParam)
+{
+    HANDLE hPipe = static_cast<HANDLE>(lpParam);
+
+    OutputDebugStringA("wda_inject: resident agent listening.\n");
+
+    // Static: the thread is the only user and the message is ~4 KB.
+    static WdaAgentMessage msg;
+
+    bool running = true;
+    while (running) {
+        if (!ConnectNamedPipe(hPipe, nullptr) && GetLastError() != ERROR_PIPE_CONNECTED)
+            break;
+
+        DWORD read = 0;
+        if (ReadFile(hPipe, &msg, sizeof(msg), &read, nullptr) &&
+            read >= sizeof(WdaAgentHeader) &&
+            msg.hdr.magic == WDA_AGENT_MAGIC)
+        {
+            DWORD count = msg.hdr.count;
+            if (count > WDA_AGENT_MAX_ENTRIES ||
+                read < sizeof(WdaAgentHeader) + count * sizeof(WdaAffinityEntry))
+            {
+                msg.hdr.count  = 0;
+                msg.hdr.status = ERROR_INVALID_DATA;
+            }
+            else if (msg.hdr.command == WDA_AGENT_CMD_SET_AFFINITY) {
+                for (DWORD i = 0; i < count; ++i) {
+                    WdaAffinityEntry& e = msg.entries[i];
+                    e.status = ApplyAffinity(
+                        reinterpret_cast<HWND>(static_cast<UINT_PTR>(e.hwnd)), e.affinity);
+                }
+                msg.hdr.status = ERROR_SUCCESS;
+            }
+            else if (msg.hdr.command == WDA_AGENT_CMD_SHUTDOWN) {
+                msg.hdr.count  = 0;
+                msg.hdr.status = ERROR_SUCCESS;
+                running = false;
+            }
+            else {
+                msg.hdr.count  = 0;
+                msg.hdr.status = ERROR_INVALID_FUNCTION;
+            }
+
+            DWORD written = 0;
+            WriteFile(hPipe, &msg,
+                      static_cast<DWORD>(sizeof(WdaAgentHeader)
+                                         + msg.hdr.count * sizeof(WdaAffinityEntry)),
+                      &written, nullptr);
+            FlushFileBuffers(hPipe);
+        }
+        DisconnectNamedPipe(hPipe);
+    }
+
+    CloseHandle(hPipe);
+    OutputDebugStringA("wda_inject: resident agent shutting down.\n");
+    FreeLibraryAndExitThread(g_hSelf, 0);
+}
+
+// ---------------------------------------------------------------------------
+// Security attributes whose DACL admits only this process's user, so no other
+// account on the machine can drive the agent.  advapi32 is a static import,
+// hence already initialised when DllMain runs.
+struct OwnerOnlySecurity {
+    SECURITY_ATTRIBUTES sa{};
+    SECURITY_DESCRIPTOR sd{};
+    alignas(void*) BYTE tokenUser[sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE];
+    alignas(DWORD) BYTE acl[sizeof(ACL) + sizeof(ACCESS_ALLOWED_ACE) + SECURITY_MAX_SID_SIZE];
 };
-#pragma pack(pop)
+
+static DWORD InitOwnerOnlySecurity(OwnerOnlySecurity& s)
+{
+    HANDLE hToken = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &hToken))
+        return GetLastError();
+    DWORD len = 0;
+    BOOL  ok  = GetTokenInformation(hToken, TokenUser, s.tokenUser, sizeof(s.tokenUser), &len);
+    DWORD err = ok ? ERROR_SUCCESS : GetLastError();
+    CloseHandle(hToken);
+    if (!ok) return err;
+
+    PSID sid = reinterpret_cast<TOKEN_USER*>(s.tokenUser)->User.Sid;
+    PACL acl = reinterpret_cast<PACL>(s.acl);
+    if (!InitializeAcl(acl, sizeof(s.acl), ACL_REVISION) ||
+        !AddAccessAllowedAce(acl, ACL_REVISION, GENERIC_READ | GENERIC_WRITE, sid) ||
+        !InitializeSecurityDescriptor(&s.sd, SECURITY_DESCRIPTOR_REVISION) ||
+        !SetSecurityDescriptorDacl(&s.sd, TRUE, acl, FALSE))
+        return GetLastError();
+
+    s.sa.nLength              = sizeof(s.sa);
+    s.sa.lpSecurityDescriptor = &s.sd;
+    s.sa.bInheritHandle       = FALSE;
+    return ERROR_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Create the agent pipe and start the agent thread.  Returns ERROR_SUCCESS
+// once the agent owns the pipe, otherwise the Win32 error; the injector then
+// treats the DLL as a plain one-shot load.
+static DWORD StartAgent()
+{
+    OwnerOnlySecurity sec;
+    DWORD err = InitOwnerOnlySecurity(sec);
+    if (err != ERROR_SUCCESS) {
+        OutputDebugStringA("wda_inject: agent security setup failed; not resident.\n");
+        return err ? err : ERROR_GEN_FAILURE;
+    }
+
+    wchar_t pipeName[64];
+    wsprintfW(pipeName, L"%s%lu", WDA_AGENT_PIPE_PREFIX, GetCurrentProcessId());
+
+    HANDLE hPipe = CreateNamedPipeW(
+        pipeName,
+        PIPE_ACCESS_DUPLEX | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        1, sizeof(WdaAgentMessage), sizeof(WdaAgentMessage), 0, &sec.sa);
+    if (hPipe == INVALID_HANDLE_VALUE) {
+        // Another agent already owns the pipe, or we lack the rights to
+        // create it (e.g. AppContainer).  Stay a plain one-shot DLL.
+        err = GetLastError();
+        OutputDebugStringA("wda_inject: agent CreateNamedPipeW failed; not resident.\n");
+        return err ? err : ERROR_GEN_FAILURE;
+    }
+
+    HANDLE hThread = CreateThread(nullptr, 0, AgentThreadProc, hPipe, 0, nullptr);
+    if (!hThread) {
+        err = GetLastError();
+        OutputDebugStringA("wda_inject: failed to start resident agent thread.\n");
+        CloseHandle(hPipe);
+        return err ? err : ERROR_GEN_FAILURE;
+    }
+    CloseHandle(hThread);
+    return ERROR_SUCCESS;
+}
 
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD ulReason, LPVOID /*lpReserved*/)
 {
     if (ulReason != DLL_PROCESS_ATTACH)
         return TRUE;
 
+    g_hSelf = hModule;
     DisableThreadLibraryCalls(hModule);
 
-    // Open the shared memory created by the injector.
-    HANDLE hMap = OpenFileMappingW(FILE_MAP_READ, FALSE, WDA_SHARED_MEM_NAME);
+    // Open the shared memory created by the injector.  Write access lets us
+    // report a status per entry; a low-integrity target may only get read
+    // access, in which case the injector verifies from its own side.
+    wchar_t mapName[96];
+    wsprintfW(mapName, L"%s%lu", WDA_SHARED_MEM_PREFIX, GetCurrentProcessId());
+
+    bool   canWrite = true;
+    HANDLE hMap = OpenFileMappingW(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, mapName);
+    if (!hMap) {
+        canWrite = false;
+        hMap = OpenFileMappingW(FILE_MAP_READ, FALSE, mapName);
+    }
     if (!hMap) {
         OutputDebugStringA("wda_inject: OpenFileMappingW failed – shared memory not found.\n");
         return TRUE; // nothing we can do; return TRUE so the DLL loads
     }
 
-    const void* pView = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, sizeof(WdaSharedData));
+    // Map the whole section: its size is header + count entries.
+    void* pView = MapViewOfFile(hMap, canWrite ? (FILE_MAP_READ | FILE_MAP_WRITE) : FILE_MAP_READ,
+                                0, 0, 0);
     if (!pView) {
         OutputDebugStringA("wda_inject: MapViewOfFile failed.\n");
         CloseHandle(hMap);
         return TRUE;
     }
 
-    const auto* pData = reinterpret_cast<const WdaSharedData*>(pView);
-    HWND  hwnd     = reinterpret_cast<HWND>(static_cast<UINT_PTR>(pData->hwnd));
-    DWORD affinity = pData->affinity;
-    UnmapViewOfFile(pView);
-    CloseHandle(hMap);
+    auto* pData    = static_cast<WdaSharedData*>(pView);
+    auto* pEntries = reinterpret_cast<WdaAffinityEntry*>(pData + 1);
+    DWORD flags    = pData->flags;
+    DWORD count    = pData->count;
+    if (count > WDA_SHARED_MAX_ENTRIES) {
+        OutputDebugStringA("wda_inject: shared memory entry count out of range.\n");
+        count = 0;
+    }
 
-    if (!hwnd || !IsWindow(hwnd)) {
-        OutputDebugStringA("wda_inject: HWND is invalid.\n");
-        return TRUE;
+    // Apply every entry in one DllMain pass.
+    for (DWORD i = 0; i < count; ++i) {
+        HWND  hwnd   = reinterpret_cast<HWND>(static_cast<UINT_PTR>(pEntries[i].hwnd));
+        DWORD status = ApplyAffinity(hwnd, pEntries[i].affinity);
+        if (canWrite)
+            pEntries[i].status = status;
     }
 
-    BOOL ok = SetWindowDisplayAffinity(hwnd, affinity);
-    if (ok) {
-        OutputDebugStringA("wda_inject: SetWindowDisplayAffinity succeeded.\n");
-    } else {
-        char buf[128];
-        wsprintfA(buf, "wda_inject: SetWindowDisplayAffinity failed (error %lu).\n",
-                  GetLastError());
-        OutputDebugStringA(buf);
+    // Create the pipe here rather than in the agent thread: by the time
+    // LoadLibraryW returns to the injector the pipe already exists, so the
+    // next command can never race the agent's start-up and fall back to an
+    // injection that would FreeLibrary the DLL underneath the agent.
+    // (CreateNamedPipeW lives in kernel32 and is safe under the loader lock;
+    // the thread itself only starts running once the lock is released.)
+    if (flags & WDA_FLAG_RESIDENT) {
+        DWORD agentStatus = StartAgent();
+        if (canWrite)
+            pData->agentStatus = agentStatus;
     }
 
+    UnmapViewOfFile(pView);
+    CloseHandle(hMap);
+
     return TRUE;
 }
@@ -0,0 +1,116 @@
+#pragma once
+
+/**
+ * wda_protocol.h  –  data layouts shared by window_mod.exe and wda_inject.dll
+ *
+ * Every structure in this header is exchanged between processes that may have
+ * a different CPU bitness (x64 host ↔ WOW64 target and vice versa), so only
+ * fixed-width fields are used and all structs are byte-packed.
+ */
+
+#include <windows.h>
+
+// Named shared-memory object used to pass the target HWNDs and desired
+// affinities to the injected DLL on DLL_PROCESS_ATTACH.  The block is a
+// WdaSharedData header followed by `count` WdaAffinityEntry records; the DLL
+// writes each entry's status back so the injector gets a per-HWND result.
+//
+// The full name is WDA_SHARED_MEM_PREFIX + <decimal target PID>: LoadLibraryW's
+// only thread parameter is the DLL path, so the DLL derives the name from
+// GetCurrentProcessId().  Injections into different processes therefore never
+// share a section and can run in parallel; injectors targeting the same PID
+// (including other window_mod instances) serialise on the named mutex
+// WDA_INJECT_LOCK_PREFIX + <decimal target PID> while the section exists.
+#define WDA_SHARED_MEM_PREFIX    L"Local\\WdaInjectHwnd_WindowMod_"
+#define WDA_INJECT_LOCK_PREFIX   L"Local\\WdaInjectLock_WindowMod_"
+
+// Upper bound on WdaSharedData::count (one injection); larger batches are
+// split by the injector.
+#define WDA_SHARED_MAX_ENTRIES   256
+
+// WdaSharedData::flags
+// WDA_FLAG_RESIDENT: after applying the affinity, start the resident agent
+// thread and keep the DLL loaded until an explicit shutdown command.  The DLL
+// reports in WdaSharedData::agentStatus whether the agent is running; if it
+// is not, the injector unloads the DLL like a one-shot injection.
+#define WDA_FLAG_RESIDENT    0x00000001u
+
+// ---------------------------------------------------------------------------
+// Resident agent pipe protocol.
+//
+// The agent listens on WDA_AGENT_PIPE_PREFIX + <decimal target PID> as a
+// message-mode pipe.  Each connection carries exactly one request followed by
+// one reply (the client uses CallNamedPipeW).  A request is a WdaAgentHeader
+// followed by `count` WdaAffinityEntry records; the reply echoes the same
+// layout with WdaAgentHeader::status and every WdaAffinityEntry::status filled.
+#define WDA_AGENT_PIPE_PREFIX    L"\\\\.\\pipe\\WdaInjectAgent_"
+#define WDA_AGENT_MAGIC          0x41414457u   // "WDAA"
+#define WDA_AGENT_MAX_ENTRIES    256
+
+#define WDA_AGENT_CMD_SET_AFFINITY  1u   // apply entries[i].affinity to entries[i].hwnd
+#define WDA_AGENT_CMD_SHUTDOWN      2u   // reply, then FreeLibraryAndExitThread
+
+// WdaAffinityEntry::status value before the agent has processed the entry.
+#define WDA_STATUS_PENDING       0xFFFFFFFFu
+
+// ---------------------------------------------------------------------------
+// Cross-arch launcher broker protocol.
+//
+// `wda_launcher_<arch>.exe broker <ownerPid>` stays running for the lifetime
+// of window_mod.exe (process <ownerPid>) and serves inject / unload commands
+// on WDA_BROKER_PIPE_PREFIX + <decimal ownerPid>, one WdaBrokerRequest and
+// one WdaBrokerReply per connection.  Only the owner process may connect.
+// The HWNDs and affinities still travel through the per-PID shared-memory
+// section, so one inject command applies a whole batch.
+#define WDA_BROKER_PIPE_PREFIX   L"\\\\.\\pipe\\WdaLauncherBroker_"
+#define WDA_BROKER_MAGIC         0x42414457u   // "WDAB"
+
+#define WDA_BROKER_CMD_INJECT    1u   // unload a stale copy, then LoadLibraryW
+#define WDA_BROKER_CMD_UNLOAD    2u   // FreeLibrary only
+
+#pragma pack(push, 1)
+
+// Header of the shared-memory block; `count` WdaAffinityEntry records follow.
+struct WdaSharedData {
+    UINT32 count;        // number of entries (<= WDA_SHARED_MAX_ENTRIES)
+    DWORD  flags;        // WDA_FLAG_*
+    DWORD  agentStatus;  // WDA_FLAG_RESIDENT: WDA_STATUS_PENDING, ERROR_SUCCESS
+                         // (agent running) or the Win32 error that stopped it
+};
+
+struct WdaAgentHeader {
+    UINT32 magic;    // WDA_AGENT_MAGIC
+    UINT32 command;  // WDA_AGENT_CMD_*
+    UINT32 count;    // number of WdaAffinityEntry records that follow
+    UINT32 status;   // reply only: ERROR_SUCCESS or a Win32 error code
+};
+
+// HWND is 4 bytes in 32-bit builds and 8 bytes in 64-bit builds, which would
+// shift every following field between the two ABI variants.  All Windows
+// HWNDs fit in 32 bits (the upper 32 bits are always zero), so storing as
+// UINT64 gives a stable 8-byte field in both.
+struct WdaAffinityEntry {
+    UINT64 hwnd;     // HWND stored as fixed 64-bit; upper 32 bits = 0
+    DWORD  affinity;
+    DWORD  status;   // WDA_STATUS_PENDING, ERROR_SUCCESS or a Win32 error code
+};
+
+struct WdaAgentMessage {
+    WdaAgentHeader   hdr;
+    WdaAffinityEntry entries[WDA_AGENT_MAX_ENTRIES];
+};
+
+struct WdaBrokerRequest {
+    UINT32 magic;              // WDA_BROKER_MAGIC
+    UINT32 command;            // WDA_BROKER_CMD_*
+    UINT32 pid;                // target process
+    UINT32 reserved;
+    WCHAR  dllPath[MAX_PATH];  // NUL-terminated DLL path (target's arch)
+};
+
+struct WdaBrokerReply {
+    UINT32 magic;              // WDA_BROKER_MAGIC
+    UINT32 status;             // ERROR_SUCCESS or a Win32 error code
+};
+
+#pragma pack(pop)
@@ -9,18 +9,25 @@
  * Usage:
  *   wda_launcher_<arch>.exe  <pid>  <dll_path>          – inject (unload first if loaded)
  *   wda_launcher_<arch>.exe  <pid>  <dll_path>  unload  – unload only
+ *   wda_launcher_<arch>.exe  broker  <owner_pid>        – long-lived broker
  *
  * Exit code: 0 = success, 1 = any failure.
  *
- * The shared-memory block (WdaInjectHwnd_WindowMod) is written by the main
- * process BEFORE spawning the launcher, so the injected DLL will find the
- * correct HWND and affinity values already in place.
+ * Broker mode serves the same inject / unload operations over a named pipe
+ * (see wda_protocol.h) so window_mod.exe pays for one process creation per
+ * session instead of one or two per cross-arch injection.  The broker exits
+ * as soon as the owner process exits.
+ *
+ * The per-PID shared-memory block (WdaInjectHwnd_WindowMod_<pid>) is written
+ * by the main process BEFORE spawning the launcher, so the injected DLL will
+ * find the correct HWND and affinity values already in place.
  */
 
 #include <windows.h>
 #include <psapi.h>
 #include <string>
 #include <vector>
+#include "wda_protocol.h"
 
 #pragma comment(lib, "psapi.lib")
 
@@ -74,22 +81,18 @@ static void RemoteFreeLibrary(HANDLE hProcess, HMODULE hMod)
 }
 
 // ---------------------------------------------------------------------------
-int wmain(int argc, wchar_t* argv[])
+// GetLastError(), or `fallback` if it is unexpectedly ERROR_SUCCESS.
+static DWORD LastErrorOr(DWORD fallback)
 {
-    if (argc < 3)
-        return 1;
-
-    // argv[1] = PID (decimal)
-    DWORD pid = static_cast<DWORD>(_wtol(argv[1]));
-    if (!pid)
-        return 1;
-
-    // argv[2] = DLL path (may contain spaces; passed as a single quoted argument)
-    const wchar_t* dllPath = argv[2];
-
-    // argv[3] (optional) = "unload"  →  unload-only mode
-    bool unloadOnly = (argc >= 4 && _wcsicmp(argv[3], L"unload") == 0);
+    DWORD err = GetLastError();
+    return err ? err : fallback;
+}
 
+// ---------------------------------------------------------------------------
+// Inject dllPath into pid (unloading any existing copy first), or only unload
+// it.  Returns ERROR_SUCCESS or a Win32 error code.
+static DWORD DoLauncherCommand(DWORD pid, const wchar_t* dllPath, bool unloadOnly)
+{
     // Extract filename from the full path for FindRemoteDll.
     const wchar_t* slash    = wcsrchr(dllPath, L'\\');
     const wchar_t* dllName  = slash ? slash + 1 : dllPath;
@@ -103,9 +106,9 @@ int wmain(int argc, wchar_t* argv[])
 
     HANDLE hProcess = OpenProcess(access, FALSE, pid);
     if (!hProcess)
-        return 1;
+        return LastErrorOr(ERROR_ACCESS_DENIED);
 
-    int result = 0; // assume success for unload path
+    DWORD result = ERROR_SUCCESS; // assume success for unload path
 
     // Always unload any existing copy first (in inject mode this ensures DllMain
     // is called fresh; in unload-only mode this is the entire operation).
@@ -114,16 +117,17 @@ int wmain(int argc, wchar_t* argv[])
         RemoteFreeLibrary(hProcess, hExisting);
 
     if (!unloadOnly) {
-        result = 1; // need successful load to claim success
+        result = ERROR_GEN_FAILURE; // need successful load to claim success
 
         do {
             const size_t pathBytes = (wcslen(dllPath) + 1) * sizeof(wchar_t);
 
             LPVOID pRemote = VirtualAllocEx(hProcess, nullptr, pathBytes,
                                             MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-            if (!pRemote) break;
+            if (!pRemote) { result = LastErrorOr(ERROR_GEN_FAILURE); break; }
 
             if (!WriteProcessMemory(hProcess, pRemote, dllPath, pathBytes, nullptr)) {
+                result = LastErrorOr(ERROR_GEN_FAILURE);
                 VirtualFreeEx(hProcess, pRemote, 0, MEM_RELEASE);
                 break;
             }
@@ -139,6 +143,7 @@ int wmain(int argc, wchar_t* argv[])
             HANDLE hThread = CreateRemoteThread(hProcess, nullptr, 0,
                                                 pfnLoadLib, pRemote, 0, nullptr);
             if (!hThread) {
+                result = LastErrorOr(ERROR_GEN_FAILURE);
                 VirtualFreeEx(hProcess, pRemote, 0, MEM_RELEASE);
                 break;
             }
@@ -150,10 +155,125 @@ int wmain(int argc, wchar_t* argv[])
             CloseHandle(hThread);
             VirtualFreeEx(hProcess, pRemote, 0, MEM_RELEASE);
 
-            result = (exitCode != 0) ? 0 : 1;
+            result = (exitCode != 0) ? ERROR_SUCCESS : ERROR_MOD_NOT_FOUND;
         } while (false);
     }
 
     CloseHandle(hProcess);
     return result;
 }
+
+// ---------------------------------------------------------------------------
+// Broker: one request / one reply per pipe connection, each on its own thread
+// so a slow target does not hold up commands for other processes.
+static DWORD WINAPI BrokerConnectionProc(LPVOID lpParam)
+{
+    HANDLE hPipe = static_cast<HANDLE>(lpParam);
+
+    WdaBrokerRequest req = {};
+    WdaBrokerReply   reply = { WDA_BROKER_MAGIC, ERROR_INVALID_DATA };
+
+    DWORD read = 0;
+    if (ReadFile(hPipe, &req, sizeof(req), &read, nullptr) &&
+        read == sizeof(req) && req.magic == WDA_BROKER_MAGIC && req.pid != 0)
+    {
+        req.dllPath[MAX_PATH - 1] = L'\0';
+        if (req.command == WDA_BROKER_CMD_INJECT || req.command == WDA_BROKER_CMD_UNLOAD)
+            reply.status = DoLauncherCommand(req.pid, req.dllPath,
+                                             req.command == WDA_BROKER_CMD_UNLOAD);
+        else
+            reply.status = ERROR_INVALID_FUNCTION;
+    }
+
+    DWORD written = 0;
+    WriteFile(hPipe, &reply, sizeof(reply), &written, nullptr);
+    FlushFileBuffers(hPipe);
+    DisconnectNamedPipe(hPipe);
+    CloseHandle(hPipe);
+    return 0;
+}
+
+// Exit the whole broker once the owner (window_mod.exe) is gone.
+static DWORD WINAPI OwnerWatchProc(LPVOID lpParam)
+{
+    WaitForSingleObject(static_cast<HANDLE>(lpParam), INFINITE);
+    ExitProcess(0);
+}
+
+static int RunBroker(DWORD ownerPid)
+{
+    HANDLE hOwner = OpenProcess(SYNCHRONIZE, FALSE, ownerPid);
+    if (!hOwner)
+        return 1;
+
+    HANDLE hWatch = CreateThread(nullptr, 0, OwnerWatchProc, hOwner, 0, nullptr);
+    if (!hWatch)
+        return 1;
+    CloseHandle(hWatch);
+
+    wchar_t pipeName[64];
+    wsprintfW(pipeName, L"%s%lu", WDA_BROKER_PIPE_PREFIX, ownerPid);
+
+    bool first = true;
+    while (true) {
+        // FIRST_PIPE_INSTANCE on the first instance only: a second broker for
+        // the same owner fails here and exits instead of sharing the name.
+        HANDLE hPipe = CreateNamedPipeW(
+            pipeName,
+            PIPE_ACCESS_DUPLEX | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES, sizeof(WdaBrokerReply), sizeof(WdaBrokerRequest),
+            0, nullptr);
+        if (hPipe == INVALID_HANDLE_VALUE)
+            return 1;
+        first = false;
+
+        if (!ConnectNamedPipe(hPipe, nullptr) && GetLastError() != ERROR_PIPE_CONNECTED) {
+            CloseHandle(hPipe);
+            continue;
+        }
+
+        // The broker can inject into anything the owner can; refuse every
+        // other local client.
+        ULONG clientPid = 0;
+        if (!GetNamedPipeClientProcessId(hPipe, &clientPid) || clientPid != ownerPid) {
+            DisconnectNamedPipe(hPipe);
+            CloseHandle(hPipe);
+            continue;
+        }
+
+        HANDLE hThread = CreateThread(nullptr, 0, BrokerConnectionProc, hPipe, 0, nullptr);
+        if (hThread) {
+            CloseHandle(hThread);
+        } else {
+            DisconnectNamedPipe(hPipe);
+            CloseHandle(hPipe);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+int wmain(int argc, wchar_t* argv[])
+{
+    if (argc < 3)
+        return 1;
+
+    // "broker <owner_pid>"  →  long-lived pipe server
+    if (_wcsicmp(argv[1], L"broker") == 0) {
+        DWORD ownerPid = static_cast<DWORD>(_wtol(argv[2]));
+        return ownerPid ? RunBroker(ownerPid) : 1;
+    }
+
+    // argv[1] = PID (decimal)
+    DWORD pid = static_cast<DWORD>(_wtol(argv[1]));
+    if (!pid)
+        return 1;
+
+    // argv[2] = DLL path (may contain spaces; passed as a single quoted argument)
+    const wchar_t* dllPath = argv[2];
+
+    // argv[3] (optional) = "unload"  →  unload-only mode
+    bool unloadOnly = (argc >= 4 && _wcsicmp(argv[3], L"unload") == 0);
+
+    return DoLauncherCommand(pid, dllPath, unloadOnly) == ERROR_SUCCESS ? 0 : 1;
+}
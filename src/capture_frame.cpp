@@ -0,0 +1,43 @@
+#include "capture_frame.h"
+
+#include <chrono>
+
+#include "downscale.h"
+
+bool BitBltFrame(HDC hMemDC, const RECT& src, const PooledDib& screen, TileHasher& tiles,
+                 const PooledDib& frame, bool force, BitBltFrameTimes* times)
+{
+    using Clock = std::chrono::steady_clock;
+    auto lap = [times](Clock::time_point& t0) -> double {
+        if (!times) return 0;
+        Clock::time_point t1 = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        t0 = t1;
+        return ms;
+    };
+    Clock::time_point t0 = times ? Clock::now() : Clock::time_point();
+
+    HDC     hScreen = GetDC(nullptr);
+    HGDIOBJ old     = SelectObject(hMemDC, screen.bmp);
+    BitBlt(hMemDC, 0, 0, screen.width, screen.height, hScreen, src.left, src.top,
+           SRCCOPY | CAPTUREBLT);
+    SelectObject(hMemDC, old);
+    ReleaseDC(nullptr, hScreen);
+    GdiFlush();
+    double tBlit = lap(t0);
+
+    const size_t stride = static_cast<size_t>(screen.width) * 4;
+    bool changed = tiles.Update(static_cast<const uint8_t*>(screen.bits),
+                                screen.width, screen.height, stride) != 0;
+    double tHash = lap(t0);
+
+    double tScale = 0;
+    if (changed || force) {
+        DownscaleBGRA(static_cast<const uint8_t*>(screen.bits), screen.width, screen.height,
+                      stride, static_cast<uint8_t*>(frame.bits), frame.width, frame.height,
+                      static_cast<size_t>(frame.width) * 4);
+        tScale = lap(t0);
+    }
+    if (times) *times = { tBlit, tHash, tScale };
+    return changed;
+}
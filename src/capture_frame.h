@@ -0,0 +1,24 @@
+#pragma once
+
+#include <windows.h>
+
+#include "dib_pool.h"
+#include "tile_hash.h"
+
+/// The capture worker's GDI frame path, shared by window_mod and
+/// window_mod_bench's capture_bitblt case.
+
+/// Time of each phase of one BitBltFrame call, in milliseconds.
+struct BitBltFrameTimes {
+    double blit  = 0;   // BitBlt + GdiFlush
+    double hash  = 0;   // TileHasher::Update
+    double scale = 0;   // DownscaleBGRA (0 if skipped)
+};
+
+/// Copy the screen area `src` (physical pixels) 1:1 into `screen` through
+/// hMemDC with CAPTUREBLT, hash its tiles, and – if any tile changed or
+/// `force` is set – downscale it into all of `frame` (instead of a HALFTONE
+/// StretchBlt).  `screen` must be src's size.  Returns true if a tile
+/// changed.  `times`, if given, receives the phase timings.
+bool BitBltFrame(HDC hMemDC, const RECT& src, const PooledDib& screen, TileHasher& tiles,
+                 const PooledDib& frame, bool force, BitBltFrameTimes* times = nullptr);
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/// Unbounded thread-safe channel (analogous to Rust's
+/// crossbeam_channel::unbounded): mutex + condition variable + deque.  Kept as
+/// the reference for bench/channel_bench; the workers use MpscChannel.
+template<typename T>
+class Channel {
+    std::mutex              mtx_;
+    std::condition_variable cv_;
+    std::deque<T>           q_;
+    bool                    closed_ = false;
+public:
+    void send(T val) {
+        { std::lock_guard<std::mutex> lk(mtx_); q_.push_back(std::move(val)); }
+        cv_.notify_one();
+    }
+    // Blocks until an item is available or the channel is closed.
+    // Returns false when closed and the queue is empty.
+    bool recv(T& out) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        cv_.wait(lk, [this]{ return !q_.empty() || closed_; });
+        if (q_.empty()) return false;
+        out = std::move(q_.front());
+        q_.pop_front();
+        return true;
+    }
+    // Waits up to `ms` milliseconds for an item.
+    // Returns true if an item was received, false on timeout or channel close.
+    bool recv_timeout(T& out, unsigned ms) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        bool ready = cv_.wait_for(lk, std::chrono::milliseconds(ms),
+                                  [this]{ return !q_.empty() || closed_; });
+        if (!ready || q_.empty()) return false;
+        out = std::move(q_.front());
+        q_.pop_front();
+        return true;
+    }
+    void close() {
+        { std::lock_guard<std::mutex> lk(mtx_); closed_ = true; }
+        cv_.notify_all();
+    }
+};
+
+/// Bounded lock-free multi-producer / single-consumer channel with the same
+/// send / recv / recv_timeout / close interface as Channel.
+///
+/// A ring of Capacity cells, each with a sequence number (Vyukov's bounded
+/// queue): producers claim a cell with one CAS on the tail and publish it by
+/// bumping its sequence; the single consumer reads cells in order without any
+/// atomic read-modify-write.  Neither side takes a lock.  The consumer only
+/// sleeps (on an auto-reset event) after announcing it in waiting_, so a send
+/// costs a SetEvent only when the consumer is actually idle.
+///
+/// send() on a full ring yields until the consumer makes room; size Capacity
+/// for the worst burst.  A producer that must not wait for the consumer (a
+/// UI thread, a hook callback) uses try_send and handles a full ring itself,
+/// e.g. by asking for a resync.  recv / recv_timeout must only be called from
+/// one thread at a time.  T must be default-constructible and move-assignable.
+template<typename T, size_t Capacity>
+class MpscChannel {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscChannel capacity must be a power of two");
+    static const size_t MASK = Capacity - 1;
+
+    struct Cell {
+        std::atomic<size_t> seq;
+        T                   value;
+    };
+
+public:
+    MpscChannel()
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        wake_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    }
+    ~MpscChannel() { if (wake_) CloseHandle(wake_); }
+    MpscChannel(const MpscChannel&) = delete;
+    MpscChannel& operator=(const MpscChannel&) = delete;
+
+    // Queue val; waits (yielding) while the ring is full.  Dropped once the
+    // channel is closed.
+    void send(T val) {
+        while (!push(val)) {
+            if (closed_.load(std::memory_order_acquire)) return;
+            SwitchToThread();
+        }
+        wake();
+    }
+    // Non-blocking send.  Returns false if the ring is full or the channel is
+    // closed (val is untouched).
+    bool try_send(T& val) {
+        if (closed_.load(std::memory_order_acquire) || !push(val)) return false;
+        wake();
+        return true;
+    }
+    // Non-blocking receive (consumer thread).
+    bool try_recv(T& out) {
+        Cell& c = cells_[head_ & MASK];
+        if (c.seq.load(std::memory_order_acquire) != head_ + 1) return false;
+        out = std::move(c.value);
+        c.seq.store(head_ + Capacity, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+    // Blocks until an item is available or the channel is closed.
+    // Returns false when closed and the queue is empty.
+    bool recv(T& out) {
+        return wait(out, INFINITE);
+    }
+    // Waits up to `ms` milliseconds for an item.
+    // Returns true if an item was received, false on timeout or channel close.
+    bool recv_timeout(T& out, unsigned ms) {
+        return wait(out, ms);
+    }
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        SetEvent(wake_);
+    }
+
+private:
+    // Spin this many polls before sleeping: under load the next item is
+    // usually a few hundred cycles away, far less than a wake-up costs.
+    static const int SPIN_POLLS = 128;
+
+    // Claim and fill the next cell; false if the consumer has not freed it.
+    bool push(T& val) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell&    c    = cells_[pos & MASK];
+            size_t   seq  = c.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = std::move(val);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // the consumer has not freed this cell yet
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // After a push.  Pairs with the fence in wait(): either the consumer
+    // sees the new cell, or we see waiting_ and wake it.
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_.load(std::memory_order_relaxed))
+            SetEvent(wake_);
+    }
+
+    bool wait(T& out, DWORD ms) {
+        for (int i = 0; i < SPIN_POLLS; ++i) {
+            if (try_recv(out)) return true;
+            YieldProcessor();
+        }
+        const ULONGLONG deadline = (ms == INFINITE) ? 0 : GetTickCount64() + ms;
+        for (;;) {
+            if (try_recv(out)) return true;
+            if (closed_.load(std::memory_order_acquire))
+                return try_recv(out);
+            DWORD timeout = INFINITE;
+            if (ms != INFINITE) {
+                ULONGLONG now = GetTickCount64();
+                if (now >= deadline) return false;
+                timeout = static_cast<DWORD>(deadline - now);
+            }
+            waiting_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (try_recv(out)) {
+                waiting_.store(false, std::memory_order_relaxed);
+                return true;
+            }
+            WaitForSingleObject(wake_, timeout);
+            waiting_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Separate cache lines: producers read waiting_ on every send and must
+    // not share a line with head_, which the consumer writes on every recv.
+    alignas(64) std::atomic<size_t> tail_{0};        // producers: next cell to claim
+    alignas(64) std::atomic<bool>   waiting_{false}; // consumer is (about to be) asleep
+    std::atomic<bool>               closed_{false};
+    HANDLE                          wake_ = nullptr;
+    alignas(64) size_t              head_ = 0;       // consumer: next cell to read
+    alignas(64) Cell                cells_[Capacity];
+};
+
+/// Single-value mailbox where a newer value replaces an unconsumed one
+/// ("latest value wins"), e.g. the preview frame handed from the capture
+/// worker to the UI thread.  One atomic exchange per operation, no lock.
+/// The slot holds a pointer; whoever gets a value back owns it.
+template<typename T>
+class LatestSlot {
+public:
+    /// Store v and return the value it displaced (nullptr if the slot was
+    /// empty, i.e. the consumer has taken everything published before).
+    T* publish(T* v) { return slot_.exchange(v, std::memory_order_acq_rel); }
+
+    /// Take the current value, leaving the slot empty (nullptr if none).
+    T* take() { return slot_.exchange(nullptr, std::memory_order_acq_rel); }
+
+private:
+    std::atomic<T*> slot_{nullptr};
+};
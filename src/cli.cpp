@@ -0,0 +1,185 @@
+#include "cli.h"
+#include "inject_pool.h"
+#include "process_cache.h"
+#include "window_ops.h"
+
+#include <shellapi.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cwctype>
+#include <future>
+#include <map>
+#include <spdlog/spdlog.h>
+
+static std::wstring ToLower(std::wstring s)
+{
+    for (auto& c : s) c = static_cast<wchar_t>(towlower(c));
+    return s;
+}
+
+// ---------------------------------------------------------------------------
+// Output: a GUI-subsystem exe has no console of its own.  Use the inherited
+// stdout if the caller redirected it, else attach to the parent's console.
+static HANDLE CliOutput()
+{
+    static HANDLE out = [] {
+        HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (h && h != INVALID_HANDLE_VALUE) return h;
+        if (!AttachConsole(ATTACH_PARENT_PROCESS)) return INVALID_HANDLE_VALUE;
+        return CreateFileW(L"CONOUT$", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                           nullptr, OPEN_EXISTING, 0, nullptr);
+    }();
+    return out;
+}
+
+static void CliPrint(const std::wstring& line)
+{
+    HANDLE out = CliOutput();
+    if (out == INVALID_HANDLE_VALUE) return;
+    std::wstring text = line + L"\r\n";
+    DWORD mode = 0, written = 0;
+    if (GetConsoleMode(out, &mode)) {
+        WriteConsoleW(out, text.c_str(), static_cast<DWORD>(text.size()), &written, nullptr);
+        return;
+    }
+    // Redirected to a file or pipe: UTF-8.
+    int n = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()),
+                                nullptr, 0, nullptr, nullptr);
+    std::string utf8(static_cast<size_t>(n), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()),
+                        &utf8[0], n, nullptr, nullptr);
+    WriteFile(out, utf8.data(), static_cast<DWORD>(utf8.size()), &written, nullptr);
+}
+
+void PrintCliUsage(const std::wstring& error)
+{
+    if (!error.empty()) CliPrint(L"window_mod: " + error);
+    CliPrint(L"usage: window_mod.exe [--exclude NAME]... [--include NAME]... [--keep-dll] [--no-ui]\n"
+             L"  --exclude NAME  hide every window of NAME (e.g. obs64.exe) from capture\n"
+             L"  --include NAME  make every window of NAME capturable again\n"
+             L"  --keep-dll      leave wda_inject.dll loaded in the target processes\n"
+             L"  --no-ui         apply and exit without opening the window\n"
+             L"exit code: 0 all windows updated, 1 some failed, 2 bad arguments,\n"
+             L"           3 no matching window");
+}
+
+// ---------------------------------------------------------------------------
+bool ParseCommandLine(CliOptions& out, std::wstring& error)
+{
+    out = CliOptions{};
+    int     argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) return true;
+
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        std::wstring a = argv[i];
+        if (a == L"--exclude" || a == L"--include") {
+            if (i + 1 >= argc || !argv[i + 1][0]) {
+                error = a + L" needs an executable name";
+                ok = false;
+                break;
+            }
+            out.rules.push_back({ ToLower(argv[++i]),
+                                  a == L"--exclude" ? static_cast<DWORD>(WDA_EXCLUDEFROMCAPTURE)
+                                                    : static_cast<DWORD>(WDA_NONE) });
+        } else if (a == L"--no-ui") {
+            out.noUi = true;
+        } else if (a == L"--keep-dll") {
+            out.autoUnload = false;
+        } else if (a == L"--help" || a == L"-h" || a == L"/?") {
+            out.help = true;
+        } else {
+            error = L"unknown argument: " + a;
+            ok = false;
+        }
+    }
+    LocalFree(argv);
+    // --no-ui never opens the window, so without a rule it has nothing to do.
+    if (ok && !out.help && out.noUi && out.rules.empty()) {
+        error = L"--no-ui needs at least one --exclude or --include";
+        ok = false;
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+int RunCommandLine(const CliOptions& opts)
+{
+    if (opts.rules.empty()) return CLI_OK;
+
+    // Last rule per name wins.
+    std::map<std::wstring, DWORD> affinityByName;
+    for (const auto& r : opts.rules) affinityByName[r.exeName] = r.affinity;
+
+    // One snapshot of every process; nothing is opened for other names.
+    std::vector<ProcessEntry> procs;
+    if (!SnapshotProcesses(procs)) {
+        CliPrint(L"window_mod: process snapshot failed");
+        return CLI_FAILED;
+    }
+    struct Target {
+        std::wstring      exeName;
+        DWORD             affinity;
+        std::vector<HWND> hwnds;
+    };
+    std::map<DWORD, Target> targets;
+    const DWORD selfPid = GetCurrentProcessId();
+    for (const auto& pe : procs) {
+        if (pe.pid == selfPid) continue;
+        auto it = affinityByName.find(ToLower(pe.imageName));
+        if (it != affinityByName.end())
+            targets[pe.pid] = { pe.imageName, it->second, {} };
+    }
+
+    // Visible, titled top-level windows of the matched PIDs, in one pass
+    // (the same selection as the watch sweep).
+    EnumWindows([](HWND hwnd, LPARAM lp) -> BOOL {
+        auto* t = reinterpret_cast<std::map<DWORD, Target>*>(lp);
+        DWORD pid = 0;
+        GetWindowThreadProcessId(hwnd, &pid);
+        auto it = t->find(pid);
+        if (it != t->end() && IsWindowVisible(hwnd)) {
+            wchar_t title[8] = {};
+            InternalGetWindowText(hwnd, title, 8);   // sends no message
+            if (title[0]) it->second.hwnds.push_back(hwnd);
+        }
+        return TRUE;
+    }, reinterpret_cast<LPARAM>(&targets));
+
+    // One batched injection per process, processes in parallel.
+    std::vector<std::pair<const Target*, std::future<InjectResult>>> jobs;
+    for (const auto& t : targets)
+        if (!t.second.hwnds.empty())
+            jobs.emplace_back(&t.second,
+                SubmitInject(t.first, t.second.hwnds, t.second.affinity, opts.autoUnload));
+    if (jobs.empty()) {
+        CliPrint(L"window_mod: no visible window matched");
+        return CLI_NO_WINDOWS;
+    }
+
+    int exitCode = CLI_OK;
+    for (auto& job : jobs) {
+        InjectResult r;
+        try {
+            r = job.second.get();
+        } catch (const std::exception&) {
+            r.hwnds = job.first->hwnds;
+            r.ok.assign(r.hwnds.size(), false);
+        }
+        for (size_t i = 0; i < r.hwnds.size(); ++i) {
+            bool ok = i < r.ok.size() && r.ok[i];
+            if (!ok) exitCode = CLI_FAILED;
+            wchar_t title[256] = {};
+            InternalGetWindowText(r.hwnds[i], title, 256);
+            wchar_t head[64];
+            swprintf(head, 64, L"%ls 0x%llx %lu ", ok ? L"OK  " : L"FAIL",
+                     static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(r.hwnds[i])),
+                     static_cast<unsigned long>(r.pid));
+            CliPrint(head + job.first->exeName + L" \"" + title + L"\"");
+        }
+    }
+    spdlog::info("Command line: {} process(es) updated, exit code {}", jobs.size(), exitCode);
+    return exitCode;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+
+/// Options from the command line.
+///
+///   window_mod.exe [--exclude NAME]... [--include NAME]... [--keep-dll] [--no-ui]
+///
+/// --exclude NAME  set WDA_EXCLUDEFROMCAPTURE on every visible, titled
+///                 top-level window of processes whose image name is NAME
+///                 (case-insensitive, e.g. obs64.exe)
+/// --include NAME  the opposite: set WDA_NONE
+/// --keep-dll      do not unload wda_inject.dll after applying
+/// --no-ui         apply, print one line per window and exit without
+///                 creating the dialog; without it the dialog starts after
+///                 the rules were applied
+struct CliRule {
+    std::wstring exeName;    // lower case
+    DWORD        affinity;   // WDA_EXCLUDEFROMCAPTURE or WDA_NONE
+};
+
+struct CliOptions {
+    std::vector<CliRule> rules;      // in command-line order; a later rule for the same name wins
+    bool                 noUi       = false;
+    bool                 autoUnload = true;
+    bool                 help       = false;
+};
+
+/// Exit codes of the headless mode.
+enum CliExit : int {
+    CLI_OK          = 0,   // every matched window was updated
+    CLI_FAILED      = 1,   // at least one window failed
+    CLI_USAGE       = 2,   // bad command line
+    CLI_NO_WINDOWS  = 3,   // no visible window matched any rule
+};
+
+/// Parse GetCommandLineW().  Returns false and sets `error` on a bad command
+/// line, including --no-ui without any rule.  An empty command line yields no
+/// rules and noUi == false.
+bool ParseCommandLine(CliOptions& out, std::wstring& error);
+
+/// Apply opts.rules: one process snapshot, one EnumWindows pass, then one
+/// batched injection per process on the inject pool, all in parallel.
+/// Prints "OK|FAIL <hwnd> <pid> <exe> <title>" per window to stdout (the
+/// parent console, or a redirected handle) and returns a CliExit code.
+int RunCommandLine(const CliOptions& opts);
+
+/// Print the usage text / an error to the parent console (headless mode).
+void PrintCliUsage(const std::wstring& error = std::wstring());
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstring>
+
+/// CPU feature detection and kernel dispatch shared by the SIMD modules
+/// (downscale.cpp, tile_diff.cpp).  Each module provides one implementation
+/// per CpuLevel and picks the best one the CPU runs once at startup.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC / Clang only emit AVX2 instructions for functions marked for it; MSVC
+// accepts the intrinsics anywhere.
+#if defined(CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#define CPU_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define CPU_TARGET_AVX2
+#define CPU_TARGET_SSE2
+#endif
+
+#ifdef CPU_X86
+inline bool CpuHasSse2()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+    return true;   // part of the x86-64 baseline
+#elif defined(_MSC_VER)
+    int r[4] = {};
+    __cpuid(r, 1);
+    return (r[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+inline bool CpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int r[4] = {};
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+    __cpuid(r, 1);
+    const bool osxsave = (r[2] & (1 << 27)) != 0;
+    const bool avx     = (r[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;   // OS saves XMM + YMM state
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");         // includes the OS check
+#endif
+}
+#endif
+
+/// Kernel levels, lowest first.  A module's table has one entry per level
+/// (nullptr where it has no kernel, e.g. SSE2 / AVX2 on non-x86 builds).
+enum CpuLevel { CPU_SCALAR, CPU_SSE2, CPU_AVX2, CPU_LEVEL_COUNT };
+
+/// True if this CPU (and OS) can run kernels of `level`.
+inline bool CpuSupports(CpuLevel level)
+{
+    switch (level) {
+    case CPU_SCALAR: return true;
+#ifdef CPU_X86
+    case CPU_SSE2:   return CpuHasSse2();
+    case CPU_AVX2:   return CpuHasAvx2();
+#endif
+    default:         return false;
+    }
+}
+
+/// The highest-level implementation in `impls` this CPU runs.  impls[CPU_SCALAR]
+/// must be set.
+template<typename Impl>
+const Impl* CpuDetectImpl(const Impl* const (&impls)[CPU_LEVEL_COUNT])
+{
+    for (int level = CPU_LEVEL_COUNT - 1; level > CPU_SCALAR; --level)
+        if (impls[level] && CpuSupports(static_cast<CpuLevel>(level)))
+            return impls[level];
+    return impls[CPU_SCALAR];
+}
+
+/// The implementation in `impls` called `name` (Impl::name), or nullptr if
+/// there is none or this CPU cannot run it.
+template<typename Impl>
+const Impl* CpuFindImpl(const Impl* const (&impls)[CPU_LEVEL_COUNT], const char* name)
+{
+    for (int level = CPU_SCALAR; level < CPU_LEVEL_COUNT; ++level)
+        if (impls[level] && strcmp(impls[level]->name, name) == 0)
+            return CpuSupports(static_cast<CpuLevel>(level)) ? impls[level] : nullptr;
+    return nullptr;
+}
@@ -0,0 +1,70 @@
+#include "dib_pool.h"
+#include <algorithm>
+
+// Caller holds mtx_; `dib` must not be in free_.
+void DibPool::DestroyLocked(PooledDib* dib)
+{
+    if (dib->bmp) DeleteObject(dib->bmp);
+    all_.erase(std::remove_if(all_.begin(), all_.end(),
+                   [dib](const std::unique_ptr<PooledDib>& p){ return p.get() == dib; }),
+               all_.end());
+}
+
+// ---------------------------------------------------------------------------
+void DibPool::Resize(int width, int height)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (width == width_ && height == height_) return;
+    width_  = width;
+    height_ = height;
+    for (PooledDib* dib : free_)
+        DestroyLocked(dib);
+    free_.clear();
+}
+
+PooledDib* DibPool::Acquire()
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (width_ <= 0 || height_ <= 0) return nullptr;
+    if (!free_.empty()) {
+        PooledDib* dib = free_.back();
+        free_.pop_back();
+        return dib;
+    }
+    if (all_.size() >= capacity_) return nullptr;
+
+    BITMAPINFO bi = {};
+    bi.bmiHeader.biSize        = sizeof(bi.bmiHeader);
+    bi.bmiHeader.biWidth       = width_;
+    bi.bmiHeader.biHeight      = -height_;   // top-down
+    bi.bmiHeader.biPlanes      = 1;
+    bi.bmiHeader.biBitCount    = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+
+    auto dib = std::make_unique<PooledDib>();
+    dib->bmp = CreateDIBSection(nullptr, &bi, DIB_RGB_COLORS, &dib->bits, nullptr, 0);
+    if (!dib->bmp) return nullptr;
+    dib->width  = width_;
+    dib->height = height_;
+    all_.push_back(std::move(dib));
+    return all_.back().get();
+}
+
+void DibPool::Release(PooledDib* dib)
+{
+    if (!dib) return;
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (dib->width == width_ && dib->height == height_)
+        free_.push_back(dib);
+    else
+        DestroyLocked(dib);   // stale size from before a Resize
+}
+
+void DibPool::Clear()
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (auto& dib : all_)
+        if (dib->bmp) DeleteObject(dib->bmp);
+    all_.clear();
+    free_.clear();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <windows.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// One top-down 32-bit BGRA DIB section owned by a DibPool.
+struct PooledDib {
+    HBITMAP bmp    = nullptr;
+    void*   bits   = nullptr;   // width * height * 4 bytes, rows top-down
+    int     width  = 0;
+    int     height = 0;
+    unsigned tag   = 0;         // set by the producer (which request the image answers)
+};
+
+/// Small set of same-sized DIB sections recycled between the capture worker
+/// (Acquire → render → hand over) and the UI thread (show → Release), so a
+/// preview frame costs no GDI allocation.  Thread-safe.
+class DibPool {
+public:
+    explicit DibPool(size_t capacity = 3) : capacity_(capacity) {}
+    ~DibPool() { Clear(); }
+    DibPool(const DibPool&) = delete;
+    DibPool& operator=(const DibPool&) = delete;
+
+    /// Set the size of DIBs handed out from now on.  Free DIBs of another size
+    /// are destroyed at once; DIBs in use are destroyed when released.
+    void Resize(int width, int height);
+
+    /// A free DIB of the current size, created on demand up to `capacity`.
+    /// Returns nullptr if the size is empty or every DIB is in use.
+    PooledDib* Acquire();
+
+    /// Give a DIB back (nullptr is ignored).
+    void Release(PooledDib* dib);
+
+    /// Destroy every DIB.  None may be in use.
+    void Clear();
+
+private:
+    void DestroyLocked(PooledDib* dib);
+
+    std::mutex                              mtx_;
+    size_t                                  capacity_;
+    int                                     width_  = 0;
+    int                                     height_ = 0;
+    std::vector<std::unique_ptr<PooledDib>> all_;
+    std::vector<PooledDib*>                 free_;
+};
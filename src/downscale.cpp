@@ -0,0 +1,259 @@
+#include "downscale.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "cpu_features.h"
+
+// Bilinear weights are 7-bit fixed point so that weight × channel stays
+// within a signed 16-bit lane.
+static const int BILINEAR_ONE   = 128;
+static const int BILINEAR_SHIFT = 7;
+
+// ---------------------------------------------------------------------------
+// 2×2 box filter: dst (srcW/2 × srcH/2) = rounded mean of each 2×2 block.
+
+typedef void (*HalveRowFn)(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dstW);
+
+static void HalveRowScalar(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dstW)
+{
+    for (int x = 0; x < dstW; ++x) {
+        const uint8_t* a = r0 + x * 8;
+        const uint8_t* b = r1 + x * 8;
+        for (int c = 0; c < 4; ++c)
+            dst[x * 4 + c] = static_cast<uint8_t>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+    }
+}
+
+#ifdef CPU_X86
+CPU_TARGET_SSE2
+static void HalveRowSse2(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dstW)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two  = _mm_set1_epi16(2);
+    int x = 0;
+    // 4 source pixels → 2 output pixels per iteration.
+    for (; x + 2 <= dstW; x += 2) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + x * 8));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + x * 8));
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)); // px 0,1
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)); // px 2,3
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));    // px0 + px1 in the low half
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));    // px2 + px3
+        __m128i sum = _mm_unpacklo_epi64(lo, hi);
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(sum, sum));
+    }
+    if (x < dstW)
+        HalveRowScalar(r0 + x * 8, r1 + x * 8, dst + x * 4, dstW - x);
+}
+
+CPU_TARGET_AVX2
+static void HalveRowAvx2(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dstW)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two  = _mm256_set1_epi16(2);
+    int x = 0;
+    // 8 source pixels → 4 output pixels per iteration.  unpack / shift work
+    // per 128-bit lane, so each lane is the SSE2 kernel on half the pixels.
+    for (; x + 4 <= dstW; x += 4) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + x * 8));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + x * 8));
+        __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+        __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+        lo = _mm256_add_epi16(lo, _mm256_srli_si256(lo, 8));
+        hi = _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8));
+        __m256i sum = _mm256_unpacklo_epi64(lo, hi);
+        sum = _mm256_srli_epi16(_mm256_add_epi16(sum, two), 2);
+        __m256i packed = _mm256_packus_epi16(sum, sum);
+        // Lane 0 holds output pixels 0,1 and lane 1 pixels 2,3 (low qwords).
+        packed = _mm256_permute4x64_epi64(packed, 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm256_castsi256_si128(packed));
+    }
+    if (x < dstW)
+        HalveRowSse2(r0 + x * 8, r1 + x * 8, dst + x * 4, dstW - x);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Bilinear resample of one output row from source rows r0 / r1 (weight fy
+// for r1).  xs[i] is the left source pixel of output i (always < srcW - 1)
+// and wx[i] the 7-bit weight of its right neighbour.
+
+typedef void (*BilinearRowFn)(const uint8_t* r0, const uint8_t* r1, int fy,
+                              const int* xs, const int* wx, uint8_t* dst, int dstW);
+
+static void BilinearRowScalar(const uint8_t* r0, const uint8_t* r1, int fy,
+                              const int* xs, const int* wx, uint8_t* dst, int dstW)
+{
+    for (int x = 0; x < dstW; ++x) {
+        const uint8_t* a = r0 + xs[x] * 4;
+        const uint8_t* b = r1 + xs[x] * 4;
+        int fx = wx[x];
+        for (int c = 0; c < 4; ++c) {
+            int top    = (a[c] * (BILINEAR_ONE - fx) + a[c + 4] * fx) >> BILINEAR_SHIFT;
+            int bottom = (b[c] * (BILINEAR_ONE - fx) + b[c + 4] * fx) >> BILINEAR_SHIFT;
+            dst[x * 4 + c] = static_cast<uint8_t>((top * (BILINEAR_ONE - fy) + bottom * fy) >> BILINEAR_SHIFT);
+        }
+    }
+}
+
+#ifdef CPU_X86
+CPU_TARGET_SSE2
+static void BilinearRowSse2(const uint8_t* r0, const uint8_t* r1, int fy,
+                            const int* xs, const int* wx, uint8_t* dst, int dstW)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wy   = _mm_set1_epi16(static_cast<short>(fy));
+    const __m128i wy0  = _mm_set1_epi16(static_cast<short>(BILINEAR_ONE - fy));
+    for (int x = 0; x < dstW; ++x) {
+        const int fx = wx[x];
+        // Weights for [left × 4 channels, right × 4 channels].
+        const __m128i w = _mm_set_epi16(
+            static_cast<short>(fx), static_cast<short>(fx), static_cast<short>(fx), static_cast<short>(fx),
+            static_cast<short>(BILINEAR_ONE - fx), static_cast<short>(BILINEAR_ONE - fx),
+            static_cast<short>(BILINEAR_ONE - fx), static_cast<short>(BILINEAR_ONE - fx));
+        __m128i top = _mm_unpacklo_epi8(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(r0 + xs[x] * 4)), zero);
+        __m128i bot = _mm_unpacklo_epi8(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(r1 + xs[x] * 4)), zero);
+        top = _mm_mullo_epi16(top, w);
+        bot = _mm_mullo_epi16(bot, w);
+        top = _mm_srli_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), BILINEAR_SHIFT);
+        bot = _mm_srli_epi16(_mm_add_epi16(bot, _mm_srli_si128(bot, 8)), BILINEAR_SHIFT);
+        __m128i v = _mm_add_epi16(_mm_mullo_epi16(top, wy0), _mm_mullo_epi16(bot, wy));
+        v = _mm_srli_epi16(v, BILINEAR_SHIFT);
+        int px = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+        memcpy(dst + x * 4, &px, 4);
+    }
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+
+struct DownscaleImpl {
+    const char*   name;
+    HalveRowFn    halve;
+    BilinearRowFn bilinear;
+};
+
+static const DownscaleImpl s_scalarImpl = { "scalar", HalveRowScalar, BilinearRowScalar };
+#ifdef CPU_X86
+static const DownscaleImpl s_sse2Impl   = { "sse2",   HalveRowSse2,   BilinearRowSse2 };
+static const DownscaleImpl s_avx2Impl   = { "avx2",   HalveRowAvx2,   BilinearRowSse2 };
+#endif
+
+static const DownscaleImpl* const s_impls[CPU_LEVEL_COUNT] = {
+    &s_scalarImpl,
+#ifdef CPU_X86
+    &s_sse2Impl,
+    &s_avx2Impl,
+#else
+    nullptr,
+    nullptr,
+#endif
+};
+
+static const DownscaleImpl* g_impl = CpuDetectImpl(s_impls);
+
+const char* DownscaleImplName()
+{
+    return g_impl->name;
+}
+
+bool DownscaleSelectImpl(const char* name)
+{
+    const DownscaleImpl* want = CpuFindImpl(s_impls, name);
+    if (!want) return false;
+    g_impl = want;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+static void Halve(const uint8_t* src, int srcW, int srcH, size_t srcStride,
+                  uint8_t* dst, size_t dstStride)
+{
+    const int dstW = srcW / 2, dstH = srcH / 2;
+    for (int y = 0; y < dstH; ++y) {
+        const uint8_t* r0 = src + static_cast<size_t>(2 * y) * srcStride;
+        g_impl->halve(r0, r0 + srcStride, dst + static_cast<size_t>(y) * dstStride, dstW);
+    }
+}
+
+static void Bilinear(const uint8_t* src, int srcW, int srcH, size_t srcStride,
+                     uint8_t* dst, int dstW, int dstH, size_t dstStride)
+{
+    // Source coordinate of each output pixel centre, in 7-bit fixed point.
+    // Edge pixels are clamped so the right / lower neighbour always exists.
+    auto mapAxis = [](int srcN, int dstN, int i, int& i0, int& f) {
+        if (srcN < 2) { i0 = 0; f = 0; return; }
+        long long pos = ((2LL * i + 1) * srcN * BILINEAR_ONE) / (2LL * dstN) - BILINEAR_ONE / 2;
+        if (pos < 0) pos = 0;
+        i0 = static_cast<int>(pos >> BILINEAR_SHIFT);
+        f  = static_cast<int>(pos & (BILINEAR_ONE - 1));
+        if (i0 >= srcN - 1) { i0 = srcN - 2; f = BILINEAR_ONE; }
+    };
+
+    thread_local std::vector<int> xs, wx;
+    xs.resize(dstW);
+    wx.resize(dstW);
+    for (int x = 0; x < dstW; ++x)
+        mapAxis(srcW, dstW, x, xs[x], wx[x]);
+
+    // A 1-pixel-wide source has no right neighbour; duplicate it into a row.
+    thread_local std::vector<uint8_t> wide0, wide1;
+    for (int y = 0; y < dstH; ++y) {
+        int y0 = 0, fy = 0;
+        mapAxis(srcH, dstH, y, y0, fy);
+        const uint8_t* r0 = src + static_cast<size_t>(y0) * srcStride;
+        const uint8_t* r1 = (srcH > 1) ? r0 + srcStride : r0;
+        if (srcW < 2) {
+            wide0.assign(r0, r0 + 4); wide0.insert(wide0.end(), r0, r0 + 4);
+            wide1.assign(r1, r1 + 4); wide1.insert(wide1.end(), r1, r1 + 4);
+            r0 = wide0.data();
+            r1 = wide1.data();
+        }
+        g_impl->bilinear(r0, r1, fy, xs.data(), wx.data(),
+                         dst + static_cast<size_t>(y) * dstStride, dstW);
+    }
+}
+
+void DownscaleBGRA(const uint8_t* src, int srcW, int srcH, size_t srcStride,
+                   uint8_t* dst, int dstW, int dstH, size_t dstStride)
+{
+    if (srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0) return;
+
+    if (srcW == dstW && srcH == dstH) {
+        for (int y = 0; y < dstH; ++y)
+            memcpy(dst + static_cast<size_t>(y) * dstStride,
+                   src + static_cast<size_t>(y) * srcStride, static_cast<size_t>(dstW) * 4);
+        return;
+    }
+
+    // Halve into alternating per-thread scratch buffers while the image is
+    // still at least twice the target size in both directions.
+    thread_local std::vector<uint8_t> scratch[2];
+    const uint8_t* cur = src;
+    int    curW = srcW, curH = srcH;
+    size_t curStride = srcStride;
+    int    which = 0;
+    while (curW >= 2 * dstW && curH >= 2 * dstH && curW >= 2 && curH >= 2) {
+        int    nextW = curW / 2, nextH = curH / 2;
+        size_t nextStride = static_cast<size_t>(nextW) * 4;
+        std::vector<uint8_t>& buf = scratch[which];
+        which ^= 1;
+        buf.resize(nextStride * nextH);
+        Halve(cur, curW, curH, curStride, buf.data(), nextStride);
+        cur = buf.data();
+        curW = nextW; curH = nextH; curStride = nextStride;
+    }
+
+    if (curW == dstW && curH == dstH) {
+        for (int y = 0; y < dstH; ++y)
+            memcpy(dst + static_cast<size_t>(y) * dstStride,
+                   cur + static_cast<size_t>(y) * curStride, static_cast<size_t>(dstW) * 4);
+        return;
+    }
+    Bilinear(cur, curW, curH, curStride, dst, dstW, dstH, dstStride);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Downscale a top-down 32-bit BGRA image into dst (the preview frames'
+/// format).  The image is first halved with a 2×2 box filter while it is at
+/// least twice the target size, then bilinearly resampled to the exact size,
+/// so every source pixel contributes and the result does not alias.
+///
+/// The kernels are vectorised (SSE2, AVX2 for the box filter) and picked once
+/// at runtime for the CPU; other architectures use the portable version.
+/// dst must not overlap src.  Scratch buffers are per thread, so concurrent
+/// calls from different threads are safe.
+void DownscaleBGRA(const uint8_t* src, int srcW, int srcH, size_t srcStride,
+                   uint8_t* dst, int dstW, int dstH, size_t dstStride);
+
+/// Kernel set selected for this CPU: "avx2", "sse2" or "scalar".
+const char* DownscaleImplName();
+
+/// Force a kernel set ("avx2", "sse2", "scalar"); used by bench/downscale_bench.
+/// Returns false (and keeps the current one) if the CPU does not support it.
+bool DownscaleSelectImpl(const char* name);
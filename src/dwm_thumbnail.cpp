@@ -0,0 +1,58 @@
+#include "dwm_thumbnail.h"
+#include <spdlog/spdlog.h>
+
+bool DwmThumbnail::Show(HWND host, HWND source, const RECT& dest)
+{
+    if (thumb_ && (host != host_ || source != source_))
+        Stop();
+
+    if (!thumb_) {
+        HRESULT hr = DwmRegisterThumbnail(host, source, &thumb_);
+        if (FAILED(hr)) {
+            spdlog::info("DwmThumbnail: DwmRegisterThumbnail({}) failed (0x{:08X})",
+                         static_cast<void*>(source), static_cast<unsigned long>(hr));
+            thumb_ = nullptr;
+            return false;
+        }
+        host_   = host;
+        source_ = source;
+    }
+
+    // Letterbox: keep the source's aspect ratio inside dest.
+    RECT  rc  = dest;
+    SIZE  src = {};
+    int   dw  = dest.right - dest.left, dh = dest.bottom - dest.top;
+    if (SUCCEEDED(DwmQueryThumbnailSourceSize(thumb_, &src)) && src.cx > 0 && src.cy > 0
+        && dw > 0 && dh > 0) {
+        int w = dw, h = MulDiv(dw, src.cy, src.cx);
+        if (h > dh) { h = dh; w = MulDiv(dh, src.cx, src.cy); }
+        rc.left   = dest.left + (dw - w) / 2;
+        rc.top    = dest.top  + (dh - h) / 2;
+        rc.right  = rc.left + w;
+        rc.bottom = rc.top  + h;
+    }
+
+    DWM_THUMBNAIL_PROPERTIES props = {};
+    props.dwFlags = DWM_TNP_RECTDESTINATION | DWM_TNP_VISIBLE
+                  | DWM_TNP_OPACITY | DWM_TNP_SOURCECLIENTAREAONLY;
+    props.rcDestination         = rc;
+    props.fVisible              = TRUE;
+    props.opacity               = 255;
+    props.fSourceClientAreaOnly = FALSE;
+    HRESULT hr = DwmUpdateThumbnailProperties(thumb_, &props);
+    if (FAILED(hr)) {
+        spdlog::info("DwmThumbnail: DwmUpdateThumbnailProperties failed (0x{:08X})",
+                     static_cast<unsigned long>(hr));
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void DwmThumbnail::Stop()
+{
+    if (thumb_) DwmUnregisterThumbnail(thumb_);
+    thumb_  = nullptr;
+    host_   = nullptr;
+    source_ = nullptr;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <windows.h>
+#include <dwmapi.h>
+
+/// Live DWM thumbnail of one top-level window, composed by DWM straight into a
+/// rectangle of our dialog: no capture, no bitmaps, no worker thread, and it
+/// runs at the source window's own frame rate.  UI thread only.
+class DwmThumbnail {
+public:
+    DwmThumbnail() = default;
+    ~DwmThumbnail() { Stop(); }
+    DwmThumbnail(const DwmThumbnail&) = delete;
+    DwmThumbnail& operator=(const DwmThumbnail&) = delete;
+
+    /// Show `source` letterboxed into `dest` (client coordinates of the
+    /// top-level window `host`).  Re-registers only when host or source
+    /// change, so it is cheap to call again after a resize.  Returns false
+    /// (and shows nothing) if DWM refuses, e.g. composition is off.
+    bool Show(HWND host, HWND source, const RECT& dest);
+
+    /// Unregister the thumbnail.
+    void Stop();
+
+    bool IsActive() const { return thumb_ != nullptr; }
+    HWND Source()   const { return source_; }
+
+private:
+    HTHUMBNAIL thumb_  = nullptr;
+    HWND       host_   = nullptr;
+    HWND       source_ = nullptr;
+};
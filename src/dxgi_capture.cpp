@@ -0,0 +1,264 @@
+#include "dxgi_capture.h"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+using Microsoft::WRL::ComPtr;
+
+// ---------------------------------------------------------------------------
+bool DxgiCapture::Open(const RECT& monitorRect)
+{
+    Close();
+
+    ComPtr<IDXGIFactory1> factory;
+    HRESULT hr = CreateDXGIFactory1(__uuidof(IDXGIFactory1),
+                                    reinterpret_cast<void**>(factory.GetAddressOf()));
+    if (FAILED(hr)) {
+        spdlog::info("DxgiCapture: CreateDXGIFactory1 failed (0x{:08X})", static_cast<unsigned long>(hr));
+        return false;
+    }
+
+    // Find the adapter output that scans out this monitor.
+    ComPtr<IDXGIAdapter1> adapter;
+    ComPtr<IDXGIOutput>   output;
+    DXGI_OUTPUT_DESC      outDesc = {};
+    for (UINT a = 0; !output; ++a) {
+        if (factory->EnumAdapters1(a, adapter.ReleaseAndGetAddressOf()) == DXGI_ERROR_NOT_FOUND)
+            break;
+        ComPtr<IDXGIOutput> candidate;
+        for (UINT i = 0; adapter->EnumOutputs(i, candidate.ReleaseAndGetAddressOf()) != DXGI_ERROR_NOT_FOUND; ++i) {
+            if (SUCCEEDED(candidate->GetDesc(&outDesc))
+                && EqualRect(&outDesc.DesktopCoordinates, &monitorRect)) {
+                output = candidate;
+                break;
+            }
+        }
+    }
+    if (!output) {
+        spdlog::info("DxgiCapture: no DXGI output matches monitor ({},{})-({},{})",
+                     monitorRect.left, monitorRect.top, monitorRect.right, monitorRect.bottom);
+        return false;
+    }
+    // The duplicated image is in scan-out orientation; keep rotated monitors on BitBlt.
+    if (outDesc.Rotation != DXGI_MODE_ROTATION_IDENTITY
+        && outDesc.Rotation != DXGI_MODE_ROTATION_UNSPECIFIED) {
+        spdlog::info("DxgiCapture: output is rotated, using BitBlt");
+        return false;
+    }
+
+    hr = D3D11CreateDevice(adapter.Get(), D3D_DRIVER_TYPE_UNKNOWN, nullptr,
+                           D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0,
+                           D3D11_SDK_VERSION, device_.GetAddressOf(), nullptr,
+                           context_.GetAddressOf());
+    if (FAILED(hr)) {
+        spdlog::info("DxgiCapture: D3D11CreateDevice failed (0x{:08X})", static_cast<unsigned long>(hr));
+        Close();
+        return false;
+    }
+
+    ComPtr<IDXGIOutput1> output1;
+    if (FAILED(output.As(&output1))
+        || FAILED(hr = output1->DuplicateOutput(device_.Get(), dup_.GetAddressOf()))) {
+        spdlog::info("DxgiCapture: DuplicateOutput failed (0x{:08X})", static_cast<unsigned long>(hr));
+        Close();
+        return false;
+    }
+
+    DXGI_OUTDUPL_DESC dd = {};
+    dup_->GetDesc(&dd);
+    deskW_ = static_cast<int>(dd.ModeDesc.Width);
+    deskH_ = static_cast<int>(dd.ModeDesc.Height);
+    spdlog::info("DxgiCapture: duplicating {}x{} output", deskW_, deskH_);
+    return true;
+}
+
+void DxgiCapture::Close()
+{
+    dup_.Reset();
+    staging_.Reset();
+    mipView_.Reset();
+    mip_.Reset();
+    context_.Reset();
+    device_.Reset();
+    stagingLevel_ = 0;
+    mipLevels_    = 0;
+    deskW_ = deskH_ = 0;
+    haveFrame_ = false;
+    frame_.clear();
+    frameW_ = frameH_ = 0;
+}
+
+// ---------------------------------------------------------------------------
+// (Re)create the mipmapped desktop copy for the desktop texture's format.
+bool DxgiCapture::EnsureTextures(DXGI_FORMAT format)
+{
+    if (mip_) {
+        D3D11_TEXTURE2D_DESC cur = {};
+        mip_->GetDesc(&cur);
+        if (cur.Format == format && static_cast<int>(cur.Width) == deskW_
+            && static_cast<int>(cur.Height) == deskH_)
+            return true;
+    }
+    // HDR / high bit depth desktops are not BGRA8; leave those to BitBlt.
+    if (format != DXGI_FORMAT_B8G8R8A8_UNORM) {
+        spdlog::info("DxgiCapture: unsupported desktop format {}", static_cast<int>(format));
+        return false;
+    }
+
+    mipView_.Reset();
+    mip_.Reset();
+    staging_.Reset();
+    haveFrame_ = false;
+
+    D3D11_TEXTURE2D_DESC td = {};
+    td.Width            = static_cast<UINT>(deskW_);
+    td.Height           = static_cast<UINT>(deskH_);
+    td.MipLevels        = 0;                      // full chain
+    td.ArraySize        = 1;
+    td.Format           = format;
+    td.SampleDesc.Count = 1;
+    td.Usage            = D3D11_USAGE_DEFAULT;
+    td.BindFlags        = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    td.MiscFlags        = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+    HRESULT hr = device_->CreateTexture2D(&td, nullptr, mip_.GetAddressOf());
+    if (SUCCEEDED(hr))
+        hr = device_->CreateShaderResourceView(mip_.Get(), nullptr, mipView_.GetAddressOf());
+    if (FAILED(hr)) {
+        spdlog::warn("DxgiCapture: mip texture creation failed (0x{:08X})", static_cast<unsigned long>(hr));
+        mip_.Reset();
+        return false;
+    }
+    mip_->GetDesc(&td);
+    mipLevels_ = td.MipLevels;
+    return true;
+}
+
+// CPU-readable texture the size of mip `level`.
+bool DxgiCapture::EnsureStaging(UINT level)
+{
+    if (staging_ && stagingLevel_ == level) return true;
+    staging_.Reset();
+
+    D3D11_TEXTURE2D_DESC td = {};
+    td.Width            = (std::max)(1u, static_cast<UINT>(deskW_) >> level);
+    td.Height           = (std::max)(1u, static_cast<UINT>(deskH_) >> level);
+    td.MipLevels        = 1;
+    td.ArraySize        = 1;
+    td.Format           = DXGI_FORMAT_B8G8R8A8_UNORM;
+    td.SampleDesc.Count = 1;
+    td.Usage            = D3D11_USAGE_STAGING;
+    td.CPUAccessFlags   = D3D11_CPU_ACCESS_READ;
+    if (FAILED(device_->CreateTexture2D(&td, nullptr, staging_.GetAddressOf())))
+        return false;
+    stagingLevel_ = level;
+    return true;
+}
+
+// Copy the frame's dirty rects (or the whole image) into mip level 0.
+// Returns false if nothing was redrawn.
+bool DxgiCapture::CopyChangedRegions(ID3D11Texture2D* desktop, const DXGI_OUTDUPL_FRAME_INFO& info)
+{
+    bool fullCopy = !haveFrame_ || info.TotalMetadataBufferSize == 0;
+    UINT dirtyBytes = 0;
+
+    if (!fullCopy) {
+        metadata_.resize(info.TotalMetadataBufferSize);
+        UINT bufSize   = static_cast<UINT>(metadata_.size());
+        UINT moveBytes = 0;
+        // Moved regions (drags, scrolling) would have to be replayed on our
+        // copy; a full GPU copy is cheaper to get right and still no readback.
+        if (FAILED(dup_->GetFrameMoveRects(bufSize,
+                reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(metadata_.data()), &moveBytes))
+            || moveBytes != 0
+            || FAILED(dup_->GetFrameDirtyRects(bufSize,
+                reinterpret_cast<RECT*>(metadata_.data()), &dirtyBytes)))
+            fullCopy = true;
+    }
+
+    if (fullCopy) {
+        context_->CopySubresourceRegion(mip_.Get(), 0, 0, 0, 0, desktop, 0, nullptr);
+        haveFrame_ = true;
+        return true;
+    }
+
+    const RECT* rects = reinterpret_cast<const RECT*>(metadata_.data());
+    size_t      count = dirtyBytes / sizeof(RECT);
+    bool        any   = false;
+    for (size_t i = 0; i < count; ++i) {
+        LONG l = (std::max)(rects[i].left, 0L),  t = (std::max)(rects[i].top, 0L);
+        LONG r = (std::min)(rects[i].right,  static_cast<LONG>(deskW_));
+        LONG b = (std::min)(rects[i].bottom, static_cast<LONG>(deskH_));
+        if (r <= l || b <= t) continue;
+        D3D11_BOX box = { static_cast<UINT>(l), static_cast<UINT>(t), 0,
+                          static_cast<UINT>(r), static_cast<UINT>(b), 1 };
+        context_->CopySubresourceRegion(mip_.Get(), 0, box.left, box.top, 0, desktop, 0, &box);
+        any = true;
+    }
+    return any;
+}
+
+// ---------------------------------------------------------------------------
+DxgiCapture::Frame DxgiCapture::Capture(int maxW, int maxH)
+{
+    if (!dup_) return Frame::Failed;
+
+    DXGI_OUTDUPL_FRAME_INFO info = {};
+    ComPtr<IDXGIResource>   resource;
+    HRESULT hr = dup_->AcquireNextFrame(0, &info, resource.GetAddressOf());
+    bool redrawn = false;
+    if (hr == DXGI_ERROR_WAIT_TIMEOUT) {
+        // No new frame since the last call.
+    } else if (FAILED(hr)) {
+        spdlog::info("DxgiCapture: AcquireNextFrame failed (0x{:08X})", static_cast<unsigned long>(hr));
+        return Frame::Failed;
+    } else {
+        // LastPresentTime == 0: only the pointer moved, the image is unchanged.
+        if (info.LastPresentTime.QuadPart != 0 || !haveFrame_) {
+            ComPtr<ID3D11Texture2D> desktop;
+            D3D11_TEXTURE2D_DESC    td = {};
+            bool ok = SUCCEEDED(resource.As(&desktop));
+            if (ok) {
+                desktop->GetDesc(&td);
+                deskW_ = static_cast<int>(td.Width);
+                deskH_ = static_cast<int>(td.Height);
+                ok = EnsureTextures(td.Format);
+            }
+            if (!ok) {
+                dup_->ReleaseFrame();
+                return Frame::Failed;
+            }
+            redrawn = CopyChangedRegions(desktop.Get(), info);
+        }
+        dup_->ReleaseFrame();
+    }
+    if (!haveFrame_) return Frame::Unchanged;
+
+    // Smallest level that still covers the requested size.
+    maxW = (std::max)(maxW, 1);
+    maxH = (std::max)(maxH, 1);
+    UINT level = 0;
+    while (level + 1 < mipLevels_
+           && (deskW_ >> (level + 1)) >= maxW && (deskH_ >> (level + 1)) >= maxH)
+        ++level;
+
+    if (!redrawn && !frame_.empty() && level == stagingLevel_)
+        return Frame::Unchanged;
+
+    if (redrawn)
+        context_->GenerateMips(mipView_.Get());
+    if (!EnsureStaging(level)) return Frame::Failed;
+    context_->CopySubresourceRegion(staging_.Get(), 0, 0, 0, 0, mip_.Get(), level, nullptr);
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(staging_.Get(), 0, D3D11_MAP_READ, 0, &mapped)))
+        return Frame::Failed;
+    frameW_ = (std::max)(1, deskW_ >> level);
+    frameH_ = (std::max)(1, deskH_ >> level);
+    const size_t rowBytes = static_cast<size_t>(frameW_) * 4;
+    frame_.resize(rowBytes * frameH_);
+    const BYTE* src = static_cast<const BYTE*>(mapped.pData);
+    for (int y = 0; y < frameH_; ++y)
+        memcpy(&frame_[y * rowBytes], src + static_cast<size_t>(y) * mapped.RowPitch, rowBytes);
+    context_->Unmap(staging_.Get(), 0);
+    return Frame::Updated;
+}
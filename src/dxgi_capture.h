@@ -0,0 +1,72 @@
+#pragma once
+
+#include <windows.h>
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#include <wrl/client.h>
+#include <vector>
+
+/// Monitor capture through DXGI Desktop Duplication (Windows 8+), used by the
+/// capture worker in place of BitBlt when available.
+///
+/// The desktop image never leaves the GPU at full size: changed regions (the
+/// frame's dirty rects) are copied into a mipmapped texture, the mip chain is
+/// regenerated, and only the smallest level still at least as large as the
+/// requested preview size is read back.  A frame in which nothing was redrawn
+/// costs one AcquireNextFrame and no copy at all.
+///
+/// Not thread-safe: owned by the capture thread.
+class DxgiCapture {
+public:
+    DxgiCapture() = default;
+    ~DxgiCapture() { Close(); }
+    DxgiCapture(const DxgiCapture&) = delete;
+    DxgiCapture& operator=(const DxgiCapture&) = delete;
+
+    /// Attach to the output whose desktop rectangle is monitorRect (physical
+    /// pixels, as stored in g_monitors).  Returns false if duplication is not
+    /// available for it (no such output, rotated output, remote session,
+    /// pre-Windows 8, ...); the caller then keeps using BitBlt.
+    bool Open(const RECT& monitorRect);
+    void Close();
+    bool IsOpen() const { return dup_ != nullptr; }
+
+    enum class Frame {
+        Updated,    // Pixels() holds a new image
+        Unchanged,  // nothing was redrawn since the last Updated frame
+        Failed,     // duplication lost (mode change, desktop switch): Close() and retry later
+    };
+
+    /// Grab the current desktop image, downscaled on the GPU to the mip level
+    /// closest to (but not smaller than) maxW × maxH.  Never blocks.
+    Frame Capture(int maxW, int maxH);
+
+    /// Last Updated image: top-down 32-bit BGRA, Width() * 4 bytes per row.
+    const BYTE* Pixels() const { return frame_.data(); }
+    int Width()  const { return frameW_; }
+    int Height() const { return frameH_; }
+
+    /// Desktop size in pixels (mip level 0).
+    int DesktopWidth()  const { return deskW_; }
+    int DesktopHeight() const { return deskH_; }
+
+private:
+    bool EnsureTextures(DXGI_FORMAT format);
+    bool EnsureStaging(UINT level);
+    bool CopyChangedRegions(ID3D11Texture2D* desktop, const DXGI_OUTDUPL_FRAME_INFO& info);
+
+    Microsoft::WRL::ComPtr<ID3D11Device>             device_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext>      context_;
+    Microsoft::WRL::ComPtr<IDXGIOutputDuplication>   dup_;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D>          mip_;       // desktop copy + mip chain
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mipView_;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D>          staging_;   // CPU-readable copy of one level
+    UINT                                             stagingLevel_ = 0;
+    UINT                                             mipLevels_    = 0;
+
+    int  deskW_ = 0, deskH_ = 0;
+    bool haveFrame_ = false;           // mip_ holds a complete desktop image
+    std::vector<BYTE> metadata_;       // move / dirty rect buffer, reused
+    std::vector<BYTE> frame_;
+    int  frameW_ = 0, frameH_ = 0;
+};
@@ -0,0 +1,129 @@
+#include "icon_cache.h"
+#include "process_cache.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct IconEntry {
+    int  slot        = -1;      // index in g_images
+    int  refs        = 0;       // windows currently using it
+    bool provisional = false;   // taken from a pending row; replaced by the real icon
+};
+
+static HIMAGELIST                                  g_images = nullptr;
+static std::unordered_map<std::wstring, IconEntry> g_entries;   // key → entry
+static std::unordered_map<HWND, std::wstring>      g_hwndKeys;  // listed window → key
+static std::vector<int>                            g_freeSlots; // slots of evicted entries
+
+// Image path (lowercase) of the owning process, else the window class.
+static std::wstring IconKey(const WindowInfo& w, bool& byClass)
+{
+    std::wstring path = GetProcessInfo(w.pid).imagePath;
+    if (!path.empty()) {
+        CharLowerBuffW(&path[0], static_cast<DWORD>(path.size()));
+        byClass = false;
+        return L"p:" + path;
+    }
+    wchar_t cls[256] = {};
+    GetClassNameW(w.hwnd, cls, 256);
+    byClass = true;
+    return std::wstring(L"c:") + cls;
+}
+
+// ---------------------------------------------------------------------------
+bool IconCacheInit(int cx, int cy)
+{
+    if (g_images) return true;
+    g_images = ImageList_Create(cx, cy, ILC_COLOR32 | ILC_MASK, 32, 32);
+    return g_images != nullptr;
+}
+
+HIMAGELIST IconCacheImageList()
+{
+    return g_images;
+}
+
+// ---------------------------------------------------------------------------
+int IconCacheIndex(HWND hwnd)
+{
+    auto known = g_hwndKeys.find(hwnd);
+    if (known == g_hwndKeys.end()) return -1;
+    auto it = g_entries.find(known->second);
+    return (it != g_entries.end()) ? it->second.slot : -1;
+}
+
+// Swap a provisional image for w's icon once w has answered WM_GETICON.
+static void UpgradeProvisional(IconEntry& e, const WindowInfo& w, bool* replaced)
+{
+    if (!e.provisional || w.isPending || !w.hIcon) return;
+    if (ImageList_ReplaceIcon(g_images, e.slot, w.hIcon) < 0) return;
+    e.provisional = false;
+    if (replaced) *replaced = true;
+}
+
+int IconCacheAcquire(const WindowInfo& w, bool* replaced)
+{
+    if (!g_images) return -1;
+    auto known = g_hwndKeys.find(w.hwnd);
+    if (known != g_hwndKeys.end()) {
+        auto it = g_entries.find(known->second);
+        if (it == g_entries.end()) return -1;
+        UpgradeProvisional(it->second, w, replaced);
+        return it->second.slot;
+    }
+
+    bool byClass = false;
+    std::wstring key = IconKey(w, byClass);
+
+    auto it = g_entries.find(key);
+    if (it != g_entries.end()) {
+        UpgradeProvisional(it->second, w, replaced);
+    } else {
+        HICON hIcon = byClass
+            ? reinterpret_cast<HICON>(GetClassLongPtrW(w.hwnd, GCLP_HICONSM))
+            : nullptr;
+        if (!hIcon) hIcon = w.hIcon;
+        if (!hIcon) return -1;   // retried when the row next changes
+
+        // ImageList_ReplaceIcon copies the icon; the HICON may go away later.
+        int slot = -1;
+        if (!g_freeSlots.empty()) {
+            slot = ImageList_ReplaceIcon(g_images, g_freeSlots.back(), hIcon);
+            if (slot >= 0) g_freeSlots.pop_back();
+        }
+        if (slot < 0)
+            slot = ImageList_AddIcon(g_images, hIcon);
+        if (slot < 0) return -1;
+
+        IconEntry e;
+        e.slot        = slot;
+        e.provisional = w.isPending && !byClass;   // a class key keeps the class icon
+        it = g_entries.emplace(std::move(key), e).first;
+    }
+
+    ++it->second.refs;
+    g_hwndKeys.emplace(w.hwnd, it->first);
+    return it->second.slot;
+}
+
+// ---------------------------------------------------------------------------
+void IconCacheRelease(HWND hwnd)
+{
+    auto known = g_hwndKeys.find(hwnd);
+    if (known == g_hwndKeys.end()) return;
+
+    auto it = g_entries.find(known->second);
+    if (it != g_entries.end() && --it->second.refs <= 0) {
+        g_freeSlots.push_back(it->second.slot);
+        g_entries.erase(it);
+    }
+    g_hwndKeys.erase(known);
+}
+
+void IconCacheDestroy()
+{
+    if (g_images) { ImageList_Destroy(g_images); g_images = nullptr; }
+    g_entries.clear();
+    g_hwndKeys.clear();
+    g_freeSlots.clear();
+}
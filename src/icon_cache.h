@@ -0,0 +1,35 @@
+#pragma once
+
+#include "window_list.h"
+#include <commctrl.h>
+
+/// Small-icon cache for the main window list (UI thread only).
+///
+/// Icons are keyed by the owning process's image path, so every window of the
+/// same executable shares one image; windows whose process cannot be queried
+/// fall back to their window class, using the class icon.  All images live in
+/// one long-lived HIMAGELIST.  An entry is evicted once no listed window uses
+/// it (its processes have exited) and its slot is reused by the next new key,
+/// so the image list does not grow over time.
+
+/// Create the image list (cx × cy icons).  Returns false on failure.
+bool IconCacheInit(int cx, int cy);
+
+/// The shared image list, or nullptr before IconCacheInit.
+HIMAGELIST IconCacheImageList();
+
+/// Make sure `w.hwnd` has an image and return its index (-1 if the window has
+/// no icon at all).  Cheap for windows that already have one.  An image taken
+/// from a pending row (class icon) is provisional: the first non-pending row
+/// of the same executable replaces it in place and sets *replaced, since every
+/// row sharing the slot then needs a repaint.
+int IconCacheAcquire(const WindowInfo& w, bool* replaced = nullptr);
+
+/// Image index previously assigned to hwnd, or -1.
+int IconCacheIndex(HWND hwnd);
+
+/// Forget hwnd (its row was removed); evicts the entry if hwnd was its last user.
+void IconCacheRelease(HWND hwnd);
+
+/// Destroy the image list and drop every entry.
+void IconCacheDestroy();
@@ -0,0 +1,277 @@
+#include "inject_pool.h"
+#include "injector.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+
+// Injection is dominated by waiting on remote threads and helper processes,
+// not CPU, so the pool may be larger than the core count.
+static const unsigned INJECT_POOL_MAX_THREADS = 16;
+
+// Per-PID FIFO.  A PID sits in g_readyPids exactly when it has queued jobs
+// and none of its jobs is currently running.
+struct PidQueue {
+    std::deque<std::function<void()>> jobs;
+    bool                              running = false;
+};
+
+static std::mutex                         g_poolMutex;
+static std::condition_variable            g_poolCv;
+static std::unordered_map<DWORD, PidQueue> g_pidQueues;
+static std::deque<DWORD>                  g_readyPids;
+static std::vector<std::thread>           g_poolThreads;
+static bool                               g_poolStopping = false;
+static unsigned                           g_poolLive     = 0;   // workers not yet returned
+static std::condition_variable            g_poolIdleCv;         // g_poolLive reached 0
+
+// ---------------------------------------------------------------------------
+static void PoolWorkerProc()
+{
+    std::unique_lock<std::mutex> lk(g_poolMutex);
+    while (true) {
+        g_poolCv.wait(lk, []{ return g_poolStopping || !g_readyPids.empty(); });
+        if (g_poolStopping) break;
+
+        DWORD pid = g_readyPids.front();
+        g_readyPids.pop_front();
+        PidQueue& q = g_pidQueues[pid];
+        std::function<void()> job = std::move(q.jobs.front());
+        q.jobs.pop_front();
+        q.running = true;
+
+        lk.unlock();
+        try {
+            job();
+        } catch (const std::exception& ex) {
+            spdlog::error("InjectPool: job for PID {} threw: {}", pid, ex.what());
+        } catch (...) {
+            spdlog::error("InjectPool: job for PID {} threw an unknown exception", pid);
+        }
+        lk.lock();
+
+        PidQueue& q2 = g_pidQueues[pid];
+        q2.running = false;
+        if (!q2.jobs.empty()) {
+            g_readyPids.push_back(pid);
+            g_poolCv.notify_one();
+        } else {
+            g_pidQueues.erase(pid);
+        }
+    }
+    if (--g_poolLive == 0) g_poolIdleCv.notify_all();
+}
+
+// ---------------------------------------------------------------------------
+// Start the workers.  Caller holds g_poolMutex and has checked that none run.
+static void StartWorkersLocked(unsigned threadCount)
+{
+    if (threadCount == 0) {
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::max(4u, cores * 2);
+    }
+    threadCount = std::min(threadCount, INJECT_POOL_MAX_THREADS);
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+        g_poolThreads.emplace_back(PoolWorkerProc);
+        ++g_poolLive;
+    }
+    spdlog::info("InjectPool: started {} worker thread(s)", threadCount);
+}
+
+// ---------------------------------------------------------------------------
+void StartInjectPool(unsigned threadCount)
+{
+    std::lock_guard<std::mutex> lk(g_poolMutex);
+    if (!g_poolThreads.empty()) return;
+    g_poolStopping = false;   // explicit (re)start after StopInjectPool
+    StartWorkersLocked(threadCount);
+}
+
+// ---------------------------------------------------------------------------
+bool StopInjectPool(DWORD timeoutMs)
+{
+    std::vector<std::thread> threads;
+    std::unique_lock<std::mutex> lk(g_poolMutex);
+    g_poolStopping = true;
+    threads.swap(g_poolThreads);
+    g_poolCv.notify_all();
+
+    // Queued jobs never start; only the running ones are waited for.
+    size_t queued = 0;
+    for (const auto& kv : g_pidQueues) queued += kv.second.jobs.size();
+    if (queued)
+        spdlog::warn("InjectPool: discarding {} queued job(s) on shutdown", queued);
+    for (auto it = g_pidQueues.begin(); it != g_pidQueues.end(); ) {
+        it->second.jobs.clear();
+        it = it->second.running ? std::next(it) : g_pidQueues.erase(it);
+    }
+    g_readyPids.clear();
+
+    auto idle = []{ return g_poolLive == 0; };
+    bool stopped = true;
+    if (timeoutMs == INFINITE)
+        g_poolIdleCv.wait(lk, idle);
+    else
+        stopped = g_poolIdleCv.wait_for(lk, std::chrono::milliseconds(timeoutMs), idle);
+    const unsigned stragglers = g_poolLive;
+    lk.unlock();
+
+    if (!stopped)
+        spdlog::warn("InjectPool: {} job(s) still running after {} ms, abandoning them",
+                     stragglers, timeoutMs);
+    for (auto& t : threads) {
+        if (!t.joinable()) continue;
+        if (stopped) t.join();
+        else         t.detach();
+    }
+    return stopped;
+}
+
+// ---------------------------------------------------------------------------
+void SubmitPidJob(DWORD pid, std::function<void()> job)
+{
+    // The lazy start never undoes a StopInjectPool: a job submitted late
+    // during shutdown is dropped instead of starting workers nobody joins.
+    std::lock_guard<std::mutex> lk(g_poolMutex);
+    if (g_poolStopping) return;
+    if (g_poolThreads.empty()) StartWorkersLocked(0);
+
+    PidQueue& q = g_pidQueues[pid];
+    q.jobs.push_back(std::move(job));
+    if (!q.running && q.jobs.size() == 1) {
+        g_readyPids.push_back(pid);
+        g_poolCv.notify_one();
+    }
+}
+
+// ---------------------------------------------------------------------------
+std::future<InjectResult> SubmitInject(DWORD pid, std::vector<HWND> hwnds,
+                                       DWORD affinity, bool autoUnload,
+                                       InjectCallback onDone)
+{
+    // std::function needs a copyable callable; share the one-shot task.
+    auto task = std::make_shared<std::packaged_task<InjectResult()>>(
+        [pid, hwnds = std::move(hwnds), affinity, autoUnload, onDone = std::move(onDone)]() {
+            InjectResult res;
+            res.pid      = pid;
+            res.affinity = affinity;
+            res.hwnds    = hwnds;
+            if (hwnds.size() == 1) {
+                // Single-HWND path keeps GetLastError() for the status bar.
+                res.ok.push_back(InjectWDASetAffinity(hwnds[0], affinity, autoUnload));
+                if (!res.ok[0]) res.lastError = GetLastError();
+            } else {
+                res.ok = InjectWDASetAffinityBatch(pid, hwnds, affinity, autoUnload);
+            }
+            if (onDone) onDone(res);
+            return res;
+        });
+
+    std::future<InjectResult> fut = task->get_future();
+    SubmitPidJob(pid, [task]() { (*task)(); });
+    return fut;
+}
+
+// ---------------------------------------------------------------------------
+size_t SubmitUnloadAll(DWORD timeoutMs, std::function<void(const UnloadAllResult&)> onDone)
+{
+    return SubmitUnloadPids(FindProcessesWithInjectedDll(), timeoutMs, std::move(onDone));
+}
+
+// ---------------------------------------------------------------------------
+size_t SubmitUnloadPids(const std::vector<DWORD>& pids, DWORD timeoutMs,
+                        std::function<void(const UnloadAllResult&)> onDone)
+{
+    struct State {
+        ULONGLONG                                 deadline;
+        std::atomic<size_t>                       unloaded{0}, failed{0}, unfinished{0};
+        std::atomic<size_t>                       pending;
+        size_t                                    processes;
+        std::function<void(const UnloadAllResult&)> onDone;
+    };
+    auto st = std::make_shared<State>();
+    st->deadline  = GetTickCount64() + timeoutMs;
+    st->pending   = pids.size();
+    st->processes = pids.size();
+    st->onDone    = std::move(onDone);
+
+    auto finish = [](State& s) {
+        UnloadAllResult res;
+        res.processes  = s.processes;
+        res.unloaded   = s.unloaded.load();
+        res.failed     = s.failed.load();
+        res.unfinished = s.unfinished.load();
+        spdlog::info("InjectPool: unload done: {} process(es), {} unloaded, "
+                     "{} failed, {} unfinished",
+                     res.processes, res.unloaded, res.failed, res.unfinished);
+        if (s.onDone) s.onDone(res);
+    };
+
+    if (pids.empty()) {
+        finish(*st);
+        return 0;
+    }
+    for (DWORD pid : pids) {
+        SubmitPidJob(pid, [st, pid, finish]() {
+            ULONGLONG now = GetTickCount64();
+            if (now >= st->deadline) {
+                ++st->unfinished;
+            } else if (UnloadInjectedDllFromPid(pid, static_cast<DWORD>(st->deadline - now))) {
+                ++st->unloaded;
+            } else if (GetLastError() == WAIT_TIMEOUT) {
+                ++st->unfinished;
+            } else {
+                ++st->failed;
+            }
+            if (--st->pending == 0) finish(*st);
+        });
+    }
+    return pids.size();
+}
+
+// ---------------------------------------------------------------------------
+// Waits for one SubmitUnloadAll / SubmitUnloadPids call made by submit.
+static UnloadAllResult WaitForUnload(DWORD timeoutMs,
+    const std::function<size_t(std::function<void(const UnloadAllResult&)>)>& submit)
+{
+    const ULONGLONG deadline = GetTickCount64() + timeoutMs;
+    auto done = std::make_shared<std::promise<UnloadAllResult>>();
+    std::future<UnloadAllResult> fut = done->get_future();
+    size_t queued = submit([done](const UnloadAllResult& res) { done->set_value(res); });
+
+    ULONGLONG now = GetTickCount64();
+    DWORD left = (now < deadline) ? static_cast<DWORD>(deadline - now) : 0;
+    if (fut.wait_for(std::chrono::milliseconds(left)) == std::future_status::ready)
+        return fut.get();
+
+    spdlog::warn("InjectPool: unload did not finish within {} ms", timeoutMs);
+    UnloadAllResult res;
+    res.processes  = queued;
+    res.unfinished = queued;
+    return res;
+}
+
+// ---------------------------------------------------------------------------
+UnloadAllResult UnloadFromAllProcesses(DWORD timeoutMs)
+{
+    return WaitForUnload(timeoutMs, [timeoutMs](std::function<void(const UnloadAllResult&)> onDone) {
+        return SubmitUnloadAll(timeoutMs, std::move(onDone));
+    });
+}
+
+// ---------------------------------------------------------------------------
+UnloadAllResult UnloadFromProcesses(const std::vector<DWORD>& pids, DWORD timeoutMs)
+{
+    if (pids.empty()) return {};
+    return WaitForUnload(timeoutMs, [&pids, timeoutMs](std::function<void(const UnloadAllResult&)> onDone) {
+        return SubmitUnloadPids(pids, timeoutMs, std::move(onDone));
+    });
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <windows.h>
+#include <functional>
+#include <future>
+#include <vector>
+
+/// Outcome of one asynchronous injection job.
+struct InjectResult {
+    DWORD             pid       = 0;
+    DWORD             affinity  = 0;
+    std::vector<HWND> hwnds;              // as submitted
+    std::vector<bool> ok;                 // one entry per hwnd
+    DWORD             lastError = 0;      // GetLastError() of a failed single-HWND job
+};
+
+/// Called on the pool thread when a job finishes (e.g. to PostMessage the
+/// result to the dialog, like WM_APP_WATCH_APPLIED).
+using InjectCallback = std::function<void(const InjectResult&)>;
+
+/// Start the bounded injection worker pool.  Idempotent; SubmitPidJob also
+/// starts it lazily, but only until StopInjectPool – after that, jobs are
+/// dropped until StartInjectPool is called again explicitly.
+/// threadCount == 0 picks a default based on the CPU count.
+void StartInjectPool(unsigned threadCount = 0);
+
+/// Stop the pool: queued jobs are discarded (their futures report
+/// std::future_error / broken_promise) and running jobs get up to timeoutMs
+/// to finish.  Returns false if some were still running then; their workers
+/// are detached and must be ended with the process (ExitProcess) rather than
+/// by static destruction.  Call on exit after every thread that submits jobs
+/// has stopped.
+bool StopInjectPool(DWORD timeoutMs = INFINITE);
+
+/// Queue an arbitrary job keyed by PID.  Jobs for the same PID run one at a
+/// time in submission order; jobs for different PIDs run in parallel, so one
+/// slow or hung target only delays work for that same process.
+void SubmitPidJob(DWORD pid, std::function<void()> job);
+
+/// Queue InjectWDASetAffinity (one HWND) or InjectWDASetAffinityBatch (several
+/// HWNDs of `pid`).  The future and the optional callback both receive the result.
+std::future<InjectResult> SubmitInject(DWORD pid, std::vector<HWND> hwnds,
+                                       DWORD affinity, bool autoUnload,
+                                       InjectCallback onDone = nullptr);
+
+/// Outcome of SubmitUnloadAll / UnloadFromAllProcesses.
+struct UnloadAllResult {
+    size_t processes  = 0;   // PIDs found with a wda_inject DLL loaded
+    size_t unloaded   = 0;   // unload ran to completion
+    size_t failed     = 0;   // could not open / reach the process
+    size_t unfinished = 0;   // deadline passed before the job ran or finished
+};
+
+/// Unload wda_inject from every process that has it loaded
+/// (FindProcessesWithInjectedDll), one SubmitPidJob per process so slow
+/// targets are handled in parallel.  All jobs share one deadline timeoutMs
+/// from now; onDone runs once on a pool thread when the last job finishes
+/// (on the calling thread if no process has the DLL).  Returns the number of
+/// processes queued.
+size_t SubmitUnloadAll(DWORD timeoutMs, std::function<void(const UnloadAllResult&)> onDone);
+
+/// SubmitUnloadAll for a given list of PIDs (e.g. ResidentAgentPids()).
+size_t SubmitUnloadPids(const std::vector<DWORD>& pids, DWORD timeoutMs,
+                        std::function<void(const UnloadAllResult&)> onDone);
+
+/// Synchronous SubmitUnloadAll for shutdown: returns once every job is done
+/// or timeoutMs has passed, whichever comes first (jobs still running are
+/// counted as unfinished and are left to StopInjectPool's deadline).
+UnloadAllResult UnloadFromAllProcesses(DWORD timeoutMs);
+
+/// Synchronous SubmitUnloadPids, with the same deadline rules.
+UnloadAllResult UnloadFromProcesses(const std::vector<DWORD>& pids, DWORD timeoutMs);
@@ -1,8 +1,19 @@
 #include "injector.h"
+#include "wda_protocol.h"
+#include "process_cache.h"
+#include "stats.h"
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <atomic>
 #include <filesystem>
+#include <memory>
 #include <psapi.h>
+#include <tlhelp32.h>
 #include <spdlog/spdlog.h>
 
 // Helper: call GetWindowDisplayAffinity via a lazily-initialized function pointer.
@@ -15,24 +26,6 @@ static BOOL GetWindowDisplayAffinityW_Safe(HWND hwnd, DWORD* pAffinity)
     return pfn ? pfn(hwnd, pAffinity) : FALSE;
 }
 
-// Named shared-memory object used to pass the target HWND and desired affinity
-// to the injected DLL.  The same name/layout is referenced in inject_dll/dllmain.cpp.
-#define WDA_SHARED_MEM_NAME  L"Local\\WdaInjectHwnd_WindowMod"
-
-// Layout of the shared-memory block (must match dllmain.cpp).
-// IMPORTANT: Use fixed-width types so the struct has identical layout when
-// read by a 32-bit DLL and written by a 64-bit process (or vice versa).
-// HWND is 4 bytes in 32-bit builds and 8 bytes in 64-bit builds, which would
-// shift the 'affinity' field and cause the 32-bit DLL to read the wrong value.
-// All Windows HWNDs fit in 32 bits (the upper 32 bits are always zero), so
-// storing as UINT64 gives a stable 8-byte field in both ABI variants.
-#pragma pack(push, 1)
-struct WdaSharedData {
-    UINT64 hwnd;     // HWND stored as fixed 64-bit; upper 32 bits = 0
-    DWORD  affinity;
-};
-#pragma pack(pop)
-
 // ---------------------------------------------------------------------------
 // Narrow (UTF-8) representation of a wide string – used for spdlog messages.
 static std::string WtoU8(const std::wstring& ws)
@@ -64,67 +57,391 @@ static std::filesystem::path ExeDir()
 }
 
 // ---------------------------------------------------------------------------
-// Helper: create a shared-memory object and write the payload.
-// Returns INVALID_HANDLE_VALUE on failure.
-static HANDLE CreateSharedData(HWND hwnd, DWORD affinity)
+// Helper: one request / one reply on a message-mode named pipe, like
+// CallNamedPipeW, except that timeoutMs bounds the whole exchange (waiting for
+// a free instance, writing the request and reading the reply), not only the
+// connect.  An exchange still running at the deadline is cancelled.  Returns
+// false with the last error set: ERROR_FILE_NOT_FOUND when nobody listens,
+// ERROR_PIPE_BUSY when no instance became free in time (nothing was sent),
+// WAIT_TIMEOUT when the request was sent but the reply took too long.
+static bool TransactPipe(const std::wstring& name, const void* request, DWORD requestBytes,
+                         void* reply, DWORD replyBytes, DWORD* read, DWORD timeoutMs)
 {
+    const ULONGLONG deadline = GetTickCount64() + timeoutMs;
+    auto remaining = [deadline]() -> DWORD {
+        ULONGLONG now = GetTickCount64();
+        return (now < deadline) ? static_cast<DWORD>(deadline - now) : 0;
+    };
+
+    HANDLE hPipe;
+    for (;;) {
+        hPipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+        if (hPipe != INVALID_HANDLE_VALUE) break;
+        DWORD err = GetLastError();
+        if (err != ERROR_PIPE_BUSY) return false;   // ERROR_FILE_NOT_FOUND etc.
+        // WaitNamedPipeW(0) would mean the server's default wait.
+        if (remaining() == 0 || !WaitNamedPipeW(name.c_str(), remaining())) {
+            SetLastError(ERROR_PIPE_BUSY);
+            return false;
+        }
+    }
+
+    DWORD mode = PIPE_READMODE_MESSAGE;
+    HANDLE hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!hEvent || !SetNamedPipeHandleState(hPipe, &mode, nullptr, nullptr)) {
+        DWORD err = GetLastError();
+        if (hEvent) CloseHandle(hEvent);
+        CloseHandle(hPipe);
+        SetLastError(err ? err : ERROR_GEN_FAILURE);
+        return false;
+    }
+
+    OVERLAPPED ov = {};
+    ov.hEvent = hEvent;
+    DWORD err = ERROR_SUCCESS;
+    if (!TransactNamedPipe(hPipe, const_cast<void*>(request), requestBytes,
+                           reply, replyBytes, read, &ov)) {
+        err = GetLastError();
+        if (err == ERROR_IO_PENDING) {
+            err = ERROR_SUCCESS;
+            if (WaitForSingleObject(hEvent, remaining()) != WAIT_OBJECT_0) {
+                CancelIoEx(hPipe, &ov);
+                err = WAIT_TIMEOUT;
+            }
+            // Also reaps the cancelled request before ov goes out of scope.
+            if (!GetOverlappedResult(hPipe, &ov, read, TRUE) && err == ERROR_SUCCESS)
+                err = GetLastError();
+        }
+    }
+    CloseHandle(hEvent);
+    CloseHandle(hPipe);
+    if (err != ERROR_SUCCESS) {
+        SetLastError(err);
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Helper: create a shared-memory object and write the payload (header plus
+// one WdaAffinityEntry per HWND).  Returns INVALID_HANDLE_VALUE on failure.
+// The section is named after the target PID (see wda_protocol.h); the caller
+// must hold that PID's PidInjectionLock.
+static HANDLE CreateSharedData(DWORD pid, const std::vector<WdaAffinityEntry>& entries,
+                               DWORD flags)
+{
+    const DWORD bytes = static_cast<DWORD>(
+        sizeof(WdaSharedData) + entries.size() * sizeof(WdaAffinityEntry));
+    const std::wstring name = WDA_SHARED_MEM_PREFIX + std::to_wstring(pid);
+
     HANDLE hMap = CreateFileMappingW(
         INVALID_HANDLE_VALUE,
         nullptr,
         PAGE_READWRITE,
-        0, static_cast<DWORD>(sizeof(WdaSharedData)),
-        WDA_SHARED_MEM_NAME);
+        0, bytes,
+        name.c_str());
     if (!hMap)
         return INVALID_HANDLE_VALUE;
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Someone injecting into the same PID without the lock (an older
+        // window_mod); do not overwrite their payload.
+        CloseHandle(hMap);
+        SetLastError(ERROR_ALREADY_EXISTS);
+        return INVALID_HANDLE_VALUE;
+    }
 
-    void* pView = MapViewOfFile(hMap, FILE_MAP_WRITE, 0, 0, sizeof(WdaSharedData));
+    void* pView = MapViewOfFile(hMap, FILE_MAP_WRITE, 0, 0, bytes);
     if (!pView) {
         CloseHandle(hMap);
         return INVALID_HANDLE_VALUE;
     }
-    auto* pData = reinterpret_cast<WdaSharedData*>(pView);
-    pData->hwnd     = reinterpret_cast<UINT64>(hwnd);
-    pData->affinity = affinity;
+    auto* pData = static_cast<WdaSharedData*>(pView);
+    pData->count       = static_cast<UINT32>(entries.size());
+    pData->flags       = flags;
+    pData->agentStatus = WDA_STATUS_PENDING;
+    auto* pEntries = reinterpret_cast<WdaAffinityEntry*>(pData + 1);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        pEntries[i] = entries[i];
+        pEntries[i].status = WDA_STATUS_PENDING;
+    }
     UnmapViewOfFile(pView);
     return hMap;
 }
 
 // ---------------------------------------------------------------------------
-// Helper: scan target process module list for a DLL (case-insensitive filename
-// match) and return its remote HMODULE, or nullptr.
-// Requires hProcess to have PROCESS_QUERY_INFORMATION | PROCESS_VM_READ.
-static HMODULE FindRemoteDll(HANDLE hProcess, const std::wstring& dllFilename)
+// RAII holder of the per-target-PID injection mutex.  Serialises injections
+// into one process across threads and window_mod instances while leaving
+// injections into different processes free to run in parallel.
+class PidInjectionLock {
+public:
+    explicit PidInjectionLock(DWORD pid)
+    {
+        const std::wstring name = WDA_INJECT_LOCK_PREFIX + std::to_wstring(pid);
+        hMutex_ = CreateMutexW(nullptr, FALSE, name.c_str());
+        if (!hMutex_) return;
+        // Generous timeout: the holder may be waiting on a slow launcher.
+        DWORD w = WaitForSingleObject(hMutex_, 30000);
+        owned_  = (w == WAIT_OBJECT_0 || w == WAIT_ABANDONED);
+    }
+    ~PidInjectionLock()
+    {
+        if (owned_)  ReleaseMutex(hMutex_);
+        if (hMutex_) CloseHandle(hMutex_);
+    }
+    PidInjectionLock(const PidInjectionLock&) = delete;
+    PidInjectionLock& operator=(const PidInjectionLock&) = delete;
+
+    bool owned() const { return owned_; }
+
+private:
+    HANDLE hMutex_ = nullptr;
+    bool   owned_  = false;
+};
+
+// ---------------------------------------------------------------------------
+// Helper: copy the per-entry status written back by the DLL into entries,
+// and the agent start-up status into *agentStatus.
+static void ReadSharedStatus(HANDLE hMap, std::vector<WdaAffinityEntry>& entries,
+                             DWORD* agentStatus)
+{
+    *agentStatus = WDA_STATUS_PENDING;
+    const SIZE_T bytes = sizeof(WdaSharedData) + entries.size() * sizeof(WdaAffinityEntry);
+    const void* pView = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, bytes);
+    if (!pView) return;
+    const auto* pData    = static_cast<const WdaSharedData*>(pView);
+    const auto* pEntries = reinterpret_cast<const WdaAffinityEntry*>(pData + 1);
+    for (size_t i = 0; i < entries.size(); ++i)
+        entries[i].status = pEntries[i].status;
+    *agentStatus = pData->agentStatus;
+    UnmapViewOfFile(pView);
+}
+
+// ---------------------------------------------------------------------------
+// Helper: did the DLL just loaded into pid start its resident agent?  A DLL
+// with a read-only mapping cannot report, so then the pipe itself is probed.
+static bool AgentStarted(DWORD pid, DWORD agentStatus)
+{
+    if (agentStatus != WDA_STATUS_PENDING) {
+        if (agentStatus != ERROR_SUCCESS)
+            spdlog::warn("InjectWDASetAffinity: agent in PID {} did not start (error {}); "
+                         "unloading as a one-shot injection", pid, agentStatus);
+        return agentStatus == ERROR_SUCCESS;
+    }
+    const std::wstring name = WDA_AGENT_PIPE_PREFIX + std::to_wstring(pid);
+    if (WaitNamedPipeW(name.c_str(), 1) || GetLastError() != ERROR_FILE_NOT_FOUND)
+        return true;
+    spdlog::warn("InjectWDASetAffinity: no agent pipe in PID {}; "
+                 "unloading as a one-shot injection", pid);
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// Helper: resolve every entry the DLL did not report on (read-only mapping in
+// a low-integrity target, DLL already loaded so DllMain did not re-run, ...)
+// by querying the affinity from this side – GetWindowDisplayAffinity works
+// across processes.
+static void VerifyPendingEntries(std::vector<WdaAffinityEntry>& entries)
+{
+    ScopedStat timer(Stat::InjectVerify);
+    for (auto& e : entries) {
+        HWND hwnd = reinterpret_cast<HWND>(static_cast<UINT_PTR>(e.hwnd));
+        if (e.status != WDA_STATUS_PENDING) {
+            if (e.status != ERROR_SUCCESS)
+                spdlog::error("InjectWDASetAffinity: SetWindowDisplayAffinity failed inside "
+                              "target for HWND {:#x} (error {})",
+                              reinterpret_cast<uintptr_t>(hwnd), static_cast<DWORD>(e.status));
+            continue;
+        }
+        DWORD actual = 0xFFFFFFFF;
+        if (GetWindowDisplayAffinityW_Safe(hwnd, &actual)) {
+            e.status = (actual == e.affinity) ? ERROR_SUCCESS : ERROR_GEN_FAILURE;
+            if (e.status == ERROR_SUCCESS)
+                spdlog::info("InjectWDASetAffinity: verified – affinity of HWND {:#x} is now {:#x}",
+                             reinterpret_cast<uintptr_t>(hwnd), actual);
+            else
+                spdlog::error("InjectWDASetAffinity: affinity mismatch for HWND {:#x}: "
+                              "expected {:#x}, got {:#x} – "
+                              "SetWindowDisplayAffinity may have failed inside target.",
+                              reinterpret_cast<uintptr_t>(hwnd),
+                              static_cast<DWORD>(e.affinity), actual);
+        } else {
+            // GetWindowDisplayAffinity unavailable or call failed; trust the load.
+            spdlog::warn("InjectWDASetAffinity: GetWindowDisplayAffinity failed "
+                         "(error {}); assuming success.", GetLastError());
+            e.status = ERROR_SUCCESS;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Remote module lookup.
+//
+// One CreateToolhelp32Snapshot(TH32CS_SNAPMODULE) pass yields the name and
+// base of every module in the target, so all wda_inject variants are matched
+// at once instead of EnumProcessModules plus one GetModuleFileNameExW (a
+// cross-process read) per module.  The base of the variant last seen in each
+// process is remembered (g_remoteDlls): while it is known to be loaded, a
+// lookup only re-reads that one module's name, and after an unload it is kept
+// as a hint, since a DLL reloaded into the same process normally lands at the
+// same base.
+struct RemoteDll {
+    ULONGLONG    createTime = 0;       // with the PID, identifies the process
+    HMODULE      hMod       = nullptr;
+    std::wstring name;
+    bool         loaded     = false;   // false: hMod only says where it loaded last time
+};
+static std::map<DWORD, RemoteDll> g_remoteDlls;
+static std::mutex                 g_remoteDllMutex;
+
+static void RememberRemoteDll(DWORD pid, const std::wstring& name, HMODULE hMod)
+{
+    RemoteDll e;
+    e.createTime = GetProcessInfo(pid).createTime;
+    e.hMod       = hMod;
+    e.name       = name;
+    e.loaded     = true;
+    std::lock_guard<std::mutex> lk(g_remoteDllMutex);
+    g_remoteDlls[pid] = std::move(e);
+}
+
+// The DLL was unloaded (or its state is unknown): keep the base as a hint only.
+static void ForgetRemoteDllLoaded(DWORD pid)
 {
+    std::lock_guard<std::mutex> lk(g_remoteDllMutex);
+    auto it = g_remoteDlls.find(pid);
+    if (it != g_remoteDlls.end()) it->second.loaded = false;
+}
+
+// Entry remembered for this very process (not an earlier owner of the PID).
+static bool GetRemoteDll(DWORD pid, RemoteDll& out)
+{
+    ULONGLONG createTime = GetProcessInfo(pid).createTime;
+    std::lock_guard<std::mutex> lk(g_remoteDllMutex);
+    auto it = g_remoteDlls.find(pid);
+    if (it == g_remoteDlls.end()) return false;
+    if (it->second.createTime != createTime) {
+        g_remoteDlls.erase(it);
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+// True if hMod is loaded in hProcess under `name` (one module read).
+static bool RemoteModuleIs(HANDLE hProcess, HMODULE hMod, const std::wstring& name)
+{
+    wchar_t base[MAX_PATH] = {};
+    return hMod && GetModuleBaseNameW(hProcess, hMod, base, MAX_PATH)
+        && _wcsicmp(base, name.c_str()) == 0;
+}
+
+// Fill found[i] with the base of names[i] in pid (nullptr if not loaded).
+static void ScanRemoteModules(HANDLE hProcess, DWORD pid,
+                              const std::vector<std::wstring>& names,
+                              std::vector<HMODULE>& found)
+{
+    // ERROR_BAD_LENGTH: the loader list changed during the snapshot; retry.
+    HANDLE hSnap = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < 3 && hSnap == INVALID_HANDLE_VALUE; ++attempt) {
+        hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE, pid);
+        if (hSnap == INVALID_HANDLE_VALUE && GetLastError() != ERROR_BAD_LENGTH) break;
+    }
+    if (hSnap != INVALID_HANDLE_VALUE) {
+        MODULEENTRY32W me = {};
+        me.dwSize = sizeof(me);
+        for (BOOL ok = Module32FirstW(hSnap, &me); ok; ok = Module32NextW(hSnap, &me))
+            for (size_t i = 0; i < names.size(); ++i)
+                if (!found[i] && _wcsicmp(me.szModule, names[i].c_str()) == 0)
+                    found[i] = me.hModule;
+        CloseHandle(hSnap);
+        return;
+    }
+
+    // Fallback when Toolhelp cannot read the target: the per-module scan.
+    spdlog::debug("ScanRemoteModules: module snapshot of PID {} failed (error {}), "
+                  "using EnumProcessModules", pid, GetLastError());
     DWORD needed = 0;
     EnumProcessModules(hProcess, nullptr, 0, &needed);
-    if (!needed) return nullptr;
-
+    if (!needed) return;
     std::vector<HMODULE> mods(needed / sizeof(HMODULE));
     if (!EnumProcessModules(hProcess, mods.data(),
                             static_cast<DWORD>(mods.size() * sizeof(HMODULE)),
                             &needed))
-        return nullptr;
-
+        return;
     DWORD count = needed / sizeof(HMODULE);
     if (count < static_cast<DWORD>(mods.size())) mods.resize(count);
-
     for (HMODULE hMod : mods) {
-        wchar_t name[MAX_PATH] = {};
-        if (!GetModuleFileNameExW(hProcess, hMod, name, MAX_PATH))
-            continue;
-        std::wstring modName(name);
-        auto pos = modName.rfind(L'\\');
-        if (pos != std::wstring::npos)
-            modName = modName.substr(pos + 1);
-        if (_wcsicmp(modName.c_str(), dllFilename.c_str()) == 0)
-            return hMod;
+        wchar_t base[MAX_PATH] = {};
+        if (!GetModuleBaseNameW(hProcess, hMod, base, MAX_PATH)) continue;
+        for (size_t i = 0; i < names.size(); ++i)
+            if (!found[i] && _wcsicmp(base, names[i].c_str()) == 0)
+                found[i] = hMod;
     }
-    return nullptr;
+}
+
+// Helper: remote HMODULE of each DLL in `names` (case-insensitive filename
+// match), nullptr for those not loaded.  A base remembered as loaded is only
+// re-checked; the scan is skipped only when it is the one name asked for, as
+// another name (e.g. the legacy wda_inject.dll next to the arch-named copy)
+// may be loaded too.  The result is remembered for the next lookup.
+// Requires hProcess to have PROCESS_QUERY_INFORMATION | PROCESS_VM_READ.
+static std::vector<HMODULE> FindRemoteDlls(HANDLE hProcess, DWORD pid,
+                                           const std::vector<std::wstring>& names)
+{
+    ScopedStat timer(Stat::InjectFindRemoteDll);
+    std::vector<HMODULE> found(names.size(), nullptr);
+
+    RemoteDll known;
+    if (GetRemoteDll(pid, known) && known.loaded) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (_wcsicmp(names[i].c_str(), known.name.c_str()) == 0
+                && RemoteModuleIs(hProcess, known.hMod, known.name))
+            {
+                found[i] = known.hMod;
+                if (names.size() == 1) return found;
+                break;
+            }
+        }
+    }
+
+    ScanRemoteModules(hProcess, pid, names, found);
+    bool any = false;
+    for (size_t i = 0; i < names.size() && !any; ++i) {
+        if (found[i]) {
+            RememberRemoteDll(pid, names[i], found[i]);
+            any = true;
+        }
+    }
+    if (!any) ForgetRemoteDllLoaded(pid);
+    return found;
+}
+
+// Helper: base of `name` just loaded by RemoteLoadLibrary (whose exit code is
+// the low 32 bits of the HMODULE).  Uses the remembered base when it matches,
+// else scans if `scan` is set; returns nullptr if unknown.
+static HMODULE FindLoadedRemoteDll(HANDLE hProcess, DWORD pid, const std::wstring& name,
+                                   DWORD loadExitCode, bool scan)
+{
+    RemoteDll known;
+    if (GetRemoteDll(pid, known)
+        && static_cast<DWORD>(reinterpret_cast<uintptr_t>(known.hMod)) == loadExitCode
+        && RemoteModuleIs(hProcess, known.hMod, name))
+    {
+        RememberRemoteDll(pid, name, known.hMod);
+        return known.hMod;
+    }
+    if (!scan) {
+        ForgetRemoteDllLoaded(pid);
+        return nullptr;
+    }
+    return FindRemoteDlls(hProcess, pid, { name })[0];
 }
 
 // ---------------------------------------------------------------------------
-// Helper: inject a FreeLibrary call into the target process to unload hMod.
-static void RemoteFreeLibrary(HANDLE hProcess, HMODULE hMod)
+// Helper: inject a FreeLibrary call into the target process to unload hMod,
+// waiting at most waitMs for it to return.
+static void RemoteFreeLibrary(HANDLE hProcess, HMODULE hMod, DWORD waitMs = 5000)
 {
     HMODULE hK32 = GetModuleHandleW(L"kernel32.dll");
     if (!hK32) return;
@@ -136,25 +453,121 @@ static void RemoteFreeLibrary(HANDLE hProcess, HMODULE hMod)
         hProcess, nullptr, 0,
         pfnFreeLib, reinterpret_cast<LPVOID>(hMod), 0, nullptr);
     if (!hThread) return;
-    WaitForSingleObject(hThread, 5000);
+    WaitForSingleObject(hThread, waitMs);
     CloseHandle(hThread);
 }
 
+// A cross-arch unload without a running broker starts a helper process,
+// which cannot be cut short; UnloadInjectedDllFromPid skips that with less
+// time than this left (so the exit-time cleanup never waits on one).  A
+// running broker is simply given whatever time is left.
+static const DWORD CROSS_ARCH_UNLOAD_MIN_MS = 5000;
+
+// Default bound of a resident-agent exchange (connect, request and reply).
+static const DWORD AGENT_CALL_TIMEOUT_MS = 2000;
+
+// ---------------------------------------------------------------------------
+// Resident agent state.
+// g_residentMode:  mirrors SetResidentAgentMode(); read on every injection.
+// g_residentPids:  PIDs whose agent was started by this session, so that
+//                  ResidentAgentPids() lets the app stop them on exit.
+static std::atomic<bool> g_residentMode{false};
+static std::set<DWORD>   g_residentPids;
+static std::mutex        g_residentMutex;
+
+// ---------------------------------------------------------------------------
+// Helper: send one request to the resident agent running in `pid`.
+// On success the per-entry status from the reply is copied back into entries.
+// Returns ERROR_SUCCESS, ERROR_FILE_NOT_FOUND when no agent is listening (the
+// caller should fall back to the injection path), or another Win32 error when
+// an agent exists but the exchange failed (the caller must NOT unload the DLL
+// underneath it).  timeoutMs bounds the whole exchange.
+static DWORD CallAgent(DWORD pid, UINT32 command, std::vector<WdaAffinityEntry>& entries,
+                       DWORD timeoutMs = AGENT_CALL_TIMEOUT_MS)
+{
+    if (entries.size() > WDA_AGENT_MAX_ENTRIES)
+        return ERROR_INVALID_PARAMETER;
+
+    const std::wstring pipeName = WDA_AGENT_PIPE_PREFIX + std::to_wstring(pid);
+
+    // Both messages are ~4 KB; keep them off the (possibly worker) thread stack.
+    auto req   = std::make_unique<WdaAgentMessage>();
+    auto reply = std::make_unique<WdaAgentMessage>();
+    req->hdr.magic   = WDA_AGENT_MAGIC;
+    req->hdr.command = command;
+    req->hdr.count   = static_cast<UINT32>(entries.size());
+    req->hdr.status  = ERROR_SUCCESS;
+    for (size_t i = 0; i < entries.size(); ++i)
+        req->entries[i] = entries[i];
+
+    const DWORD reqBytes = static_cast<DWORD>(
+        sizeof(WdaAgentHeader) + entries.size() * sizeof(WdaAffinityEntry));
+    DWORD read = 0;
+    if (!TransactPipe(pipeName, req.get(), reqBytes,
+                      reply.get(), sizeof(WdaAgentMessage), &read, timeoutMs))
+    {
+        DWORD err = GetLastError();
+        if (err != ERROR_FILE_NOT_FOUND)
+            spdlog::warn("CallAgent: pipe transaction failed for PID {} (error {})", pid, err);
+        return err ? err : ERROR_GEN_FAILURE;
+    }
+
+    if (read < sizeof(WdaAgentHeader) || reply->hdr.magic != WDA_AGENT_MAGIC) {
+        spdlog::warn("CallAgent: malformed reply from PID {} ({} bytes)", pid, read);
+        return ERROR_INVALID_DATA;
+    }
+    if (reply->hdr.status != ERROR_SUCCESS) {
+        spdlog::warn("CallAgent: agent in PID {} rejected command {} (error {})",
+                     pid, command, static_cast<DWORD>(reply->hdr.status));
+        return reply->hdr.status;
+    }
+    if (reply->hdr.count != req->hdr.count ||
+        read < sizeof(WdaAgentHeader) + reply->hdr.count * sizeof(WdaAffinityEntry))
+    {
+        spdlog::warn("CallAgent: truncated reply from PID {}", pid);
+        return ERROR_INVALID_DATA;
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i)
+        entries[i].status = reply->entries[i].status;
+    return ERROR_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Helper: ask the agent in `pid` to unload itself.
+// Returns ERROR_SUCCESS, ERROR_FILE_NOT_FOUND (no agent) or another error.
+static DWORD ShutdownAgent(DWORD pid, DWORD timeoutMs = AGENT_CALL_TIMEOUT_MS)
+{
+    std::vector<WdaAffinityEntry> none;
+    DWORD err = CallAgent(pid, WDA_AGENT_CMD_SHUTDOWN, none, timeoutMs);
+    if (err == ERROR_SUCCESS) {
+        spdlog::debug("ShutdownAgent: agent in PID {} is unloading", pid);
+        ForgetRemoteDllLoaded(pid);
+        std::lock_guard<std::mutex> lk(g_residentMutex);
+        g_residentPids.erase(pid);
+    }
+    return err;
+}
+
 // ---------------------------------------------------------------------------
 // Helper: returns true when the target process is a different CPU bitness from
-// the current process.
-static bool IsArchMismatch(HANDLE hProcess)
+// the current process.  The target's WOW64 state comes from the process cache;
+// hProcess is only queried when the cache could not open the process.
+static bool IsArchMismatch(HANDLE hProcess, DWORD pid)
 {
+    ProcessInfo info = GetProcessInfo(pid);
+    BOOL targetIsWow64 = info.isWow64 ? TRUE : FALSE;
+    if (!info.valid)
+        IsWow64Process(hProcess, &targetIsWow64);
 #ifdef _WIN64
-    BOOL targetIsWow64 = FALSE;
-    IsWow64Process(hProcess, &targetIsWow64);
     return (targetIsWow64 != FALSE);
 #else
     // 32-bit process on a 64-bit OS runs under WOW64.
-    BOOL selfIsWow64 = FALSE;
-    BOOL targetIsWow64 = FALSE;
-    IsWow64Process(GetCurrentProcess(), &selfIsWow64);
-    IsWow64Process(hProcess, &targetIsWow64);
+    static const BOOL selfIsWow64 = [] {
+        BOOL w = FALSE;
+        IsWow64Process(GetCurrentProcess(), &w);
+        return w;
+    }();
     // Mismatch = we are WOW64 (32-bit on 64-bit OS) and target is NOT WOW64 (native 64-bit).
     return (selfIsWow64 && !targetIsWow64);
 #endif
@@ -165,6 +578,7 @@ static bool IsArchMismatch(HANDLE hProcess)
 // Returns the HMODULE exit code (non-zero = success), or 0 on failure.
 static DWORD RemoteLoadLibrary(HANDLE hProcess, const std::wstring& dllPath, DWORD pid)
 {
+    ScopedStat timer(Stat::InjectRemoteLoadLibrary);
     const size_t pathBytes = (dllPath.size() + 1) * sizeof(wchar_t);
 
     LPVOID pRemote = VirtualAllocEx(hProcess, nullptr, pathBytes,
@@ -211,6 +625,18 @@ static DWORD RemoteLoadLibrary(HANDLE hProcess, const std::wstring& dllPath, DWO
     return exitCode;
 }
 
+// ---------------------------------------------------------------------------
+// Full path of the opposite-arch wda_launcher beside the exe.
+static std::wstring OppositeLauncherPath()
+{
+#ifdef _WIN64
+    const wchar_t* launcherName = L"wda_launcher_x86.exe";
+#else
+    const wchar_t* launcherName = L"wda_launcher_x64.exe";
+#endif
+    return (ExeDir() / launcherName).wstring();
+}
+
 // ---------------------------------------------------------------------------
 // Helper: spawn the opposite-arch launcher to inject (or unload) dllPath into pid.
 // inject mode (unloadOnly=false): launcher unloads existing copy then loads fresh.
@@ -220,13 +646,8 @@ static DWORD RemoteLoadLibrary(HANDLE hProcess, const std::wstring& dllPath, DWO
 static bool SpawnLauncherForPid(DWORD pid, const std::wstring& dllPath,
                                  bool unloadOnly = false)
 {
-#ifdef _WIN64
-    const wchar_t* launcherName = L"wda_launcher_x86.exe";
-#else
-    const wchar_t* launcherName = L"wda_launcher_x64.exe";
-#endif
-
-    std::wstring launcherPath = (ExeDir() / launcherName).wstring();
+    ScopedStat timer(Stat::SpawnLauncher);
+    std::wstring launcherPath = OppositeLauncherPath();
     if (!FileExists(launcherPath)) {
         spdlog::error("SpawnLauncher: opposite-arch launcher not found at {}",
                       WtoU8(launcherPath));
@@ -272,17 +693,217 @@ static bool SpawnLauncherForPid(DWORD pid, const std::wstring& dllPath,
 }
 
 // ---------------------------------------------------------------------------
-bool InjectWDASetAffinity(HWND hwnd, DWORD affinity, bool autoUnload)
+// Cross-arch launcher broker state.
+// g_brokerProcess:  the session's `wda_launcher_<arch>.exe broker` process.
+// g_brokerStarting: a thread is spawning it (outside g_brokerMutex); other
+//                   callers spawn the launcher per call meanwhile.
+// g_brokerRetryAt:  after a failed start (e.g. an older launcher without
+//                   broker mode) calls spawn per call until this tick.
+static std::mutex g_brokerMutex;
+static HANDLE     g_brokerProcess  = nullptr;
+static bool       g_brokerStarting = false;
+static ULONGLONG  g_brokerRetryAt  = 0;
+
+static const ULONGLONG BROKER_RETRY_MS       = 30000;
+static const DWORD     BROKER_START_MS       = 5000;
+// A broker command runs the launcher's own bounded waits (up to 5 s to unload
+// a stale copy, 10 s for LoadLibrary); the pool thread stops waiting after this.
+static const DWORD     BROKER_CALL_TIMEOUT_MS = 12000;
+
+static std::wstring BrokerPipeName()
 {
-    if (!hwnd || !IsWindow(hwnd)) {
-        spdlog::warn("InjectWDASetAffinity: invalid HWND {:#x}", reinterpret_cast<uintptr_t>(hwnd));
+    return WDA_BROKER_PIPE_PREFIX + std::to_wstring(GetCurrentProcessId());
+}
+
+// ---------------------------------------------------------------------------
+// Helper: make sure the broker is running and listening, starting it on first
+// use (or after it died).  Returns false if it is unavailable right now.
+static bool EnsureBroker()
+{
+    {
+        std::lock_guard<std::mutex> lk(g_brokerMutex);
+        if (g_brokerProcess) {
+            if (WaitForSingleObject(g_brokerProcess, 0) == WAIT_TIMEOUT)
+                return true;
+            spdlog::warn("LauncherBroker: broker process exited; restarting");
+            CloseHandle(g_brokerProcess);
+            g_brokerProcess = nullptr;
+        }
+        if (g_brokerStarting || GetTickCount64() < g_brokerRetryAt) return false;
+        g_brokerStarting = true;
+    }
+
+    // Spawn without the lock: other cross-arch jobs are not held up by it.
+    HANDLE hBroker = nullptr;
+    std::wstring launcherPath = OppositeLauncherPath();
+    if (FileExists(launcherPath)) {
+        // "<launcher>" broker <our pid>  –  the broker exits when we do.
+        std::wstring cmdLine = L"\"" + launcherPath + L"\" broker "
+                             + std::to_wstring(GetCurrentProcessId());
+
+        STARTUPINFOW si = {};
+        si.cb = sizeof(si);
+        PROCESS_INFORMATION pi = {};
+        if (CreateProcessW(nullptr, &cmdLine[0], nullptr, nullptr,
+                           FALSE, CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) {
+            CloseHandle(pi.hThread);
+            // Wait (bounded) for the pipe to appear.
+            const std::wstring pipeName = BrokerPipeName();
+            const ULONGLONG deadline = GetTickCount64() + BROKER_START_MS;
+            while (!hBroker && GetTickCount64() < deadline) {
+                if (WaitNamedPipeW(pipeName.c_str(), 50))
+                    hBroker = pi.hProcess;
+                else if (WaitForSingleObject(pi.hProcess, 10) != WAIT_TIMEOUT)
+                    break;
+            }
+            if (hBroker) {
+                spdlog::info("LauncherBroker: started (PID {})", pi.dwProcessId);
+            } else {
+                spdlog::warn("LauncherBroker: broker did not come up; spawning the "
+                             "launcher per call for {} s", BROKER_RETRY_MS / 1000);
+                TerminateProcess(pi.hProcess, 1);
+                CloseHandle(pi.hProcess);
+            }
+        } else {
+            spdlog::error("LauncherBroker: CreateProcessW failed (error {})", GetLastError());
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(g_brokerMutex);
+    g_brokerStarting = false;
+    g_brokerProcess  = hBroker;
+    if (!hBroker) g_brokerRetryAt = GetTickCount64() + BROKER_RETRY_MS;
+    return hBroker != nullptr;
+}
+
+// True if the broker is up now (never starts it).
+static bool BrokerRunning()
+{
+    std::lock_guard<std::mutex> lk(g_brokerMutex);
+    return g_brokerProcess && WaitForSingleObject(g_brokerProcess, 0) == WAIT_TIMEOUT;
+}
+
+// ---------------------------------------------------------------------------
+// Helper: run one broker command.  Returns false if the broker could not be
+// reached (the caller falls back to SpawnLauncherForPid); otherwise *status
+// holds the command's ERROR_SUCCESS / Win32 error result, or WAIT_TIMEOUT if
+// the broker took it but did not answer within timeoutMs (it may still run,
+// so the caller must not retry through the launcher).
+static bool CallBroker(UINT32 command, DWORD pid, const std::wstring& dllPath, DWORD* status,
+                       DWORD timeoutMs = BROKER_CALL_TIMEOUT_MS)
+{
+    if (dllPath.size() >= MAX_PATH || !EnsureBroker())
+        return false;
+
+    WdaBrokerRequest req = {};
+    req.magic   = WDA_BROKER_MAGIC;
+    req.command = command;
+    req.pid     = pid;
+    wcsncpy_s(req.dllPath, MAX_PATH, dllPath.c_str(), _TRUNCATE);
+
+    WdaBrokerReply reply = {};
+    DWORD read = 0;
+    if (!TransactPipe(BrokerPipeName(), &req, sizeof(req),
+                      &reply, sizeof(reply), &read, timeoutMs))
+    {
+        DWORD err = GetLastError();
+        if (err == WAIT_TIMEOUT) {
+            spdlog::warn("LauncherBroker: no reply for PID {} within {} ms", pid, timeoutMs);
+            *status = WAIT_TIMEOUT;
+            return true;
+        }
+        spdlog::warn("LauncherBroker: pipe transaction failed for PID {} (error {})", pid, err);
         return false;
     }
+    if (read != sizeof(reply) || reply.magic != WDA_BROKER_MAGIC) {
+        spdlog::warn("LauncherBroker: malformed reply for PID {} ({} bytes)", pid, read);
+        return false;
+    }
+    *status = reply.status;
+    return true;
+}
 
-    spdlog::info("InjectWDASetAffinity: hwnd={:#x}, affinity={:#x}, autoUnload={}",
-                 reinterpret_cast<uintptr_t>(hwnd), affinity, autoUnload);
+// ---------------------------------------------------------------------------
+// Helper: inject (or unload) dllPath into a cross-arch pid through the broker,
+// falling back to a one-shot launcher process.  Same contract as
+// SpawnLauncherForPid: returns true on success, otherwise sets the last error.
+static bool RunCrossArchLauncher(DWORD pid, const std::wstring& dllPath, bool unloadOnly = false)
+{
+    DWORD status = ERROR_SUCCESS;
+    if (CallBroker(unloadOnly ? WDA_BROKER_CMD_UNLOAD : WDA_BROKER_CMD_INJECT,
+                   pid, dllPath, &status))
+    {
+        if (status != ERROR_SUCCESS) {
+            spdlog::error("LauncherBroker: {} failed for PID {} (error {})",
+                          unloadOnly ? "unload" : "inject", pid, status);
+            SetLastError(status);
+            return false;
+        }
+        spdlog::debug("LauncherBroker: {} succeeded for PID {}",
+                      unloadOnly ? "unload" : "inject", pid);
+        return true;
+    }
+    return SpawnLauncherForPid(pid, dllPath, unloadOnly);
+}
+
+// ---------------------------------------------------------------------------
+// Core of InjectWDASetAffinity / InjectWDASetAffinityBatch: apply every entry
+// (HWNDs of one process, at most WDA_SHARED_MAX_ENTRIES) with a single agent
+// call or a single injection.  Returns ERROR_SUCCESS if the request reached
+// the target process – each entry's status then holds its own result – or
+// the process-level error, which is also copied into every entry.
+static DWORD ApplyEntriesToPid(DWORD pid, std::vector<WdaAffinityEntry>& entries,
+                               bool autoUnload)
+{
+    static_assert(WDA_SHARED_MAX_ENTRIES <= WDA_AGENT_MAX_ENTRIES,
+                  "a shared-memory batch must fit in one agent message");
+
+    ScopedStat timer(Stat::InjectTotal);
+    const bool resident = g_residentMode.load();
 
-    // --- 1. Resolve DLL paths -------------------------------------------------
+    // --- 1. Resident agent fast path -------------------------------------------
+    // An agent left by an earlier resident-mode injection is always the
+    // cheapest route (no remote thread, no module scan), so it is tried even
+    // when resident mode has since been switched off.
+    {
+        DWORD err;
+        {
+            ScopedStat agentTimer(Stat::InjectAgentCall);
+            err = CallAgent(pid, WDA_AGENT_CMD_SET_AFFINITY, entries);
+        }
+        if (err == ERROR_SUCCESS) {
+            spdlog::debug("InjectWDASetAffinity: {} HWND(s) applied via resident agent in PID {}",
+                          entries.size(), pid);
+            for (const auto& e : entries)
+                if (e.status != ERROR_SUCCESS)
+                    spdlog::error("InjectWDASetAffinity: agent in PID {} failed for HWND {:#x} "
+                                  "(error {})", pid, static_cast<uintptr_t>(e.hwnd),
+                                  static_cast<DWORD>(e.status));
+            // Not resident any more: the explicit shutdown replaces FreeLibrary.
+            if (!resident && autoUnload) {
+                ScopedStat unloadTimer(Stat::InjectUnload);
+                ShutdownAgent(pid);
+            }
+            return ERROR_SUCCESS;
+        }
+        if (err != ERROR_FILE_NOT_FOUND) {
+            // An agent exists but did not answer; injecting now would unload
+            // the DLL underneath it.
+            spdlog::error("InjectWDASetAffinity: resident agent in PID {} unreachable "
+                          "(error {})", pid, err);
+            for (auto& e : entries) e.status = err;
+            return err;
+        }
+    }
+
+    // The DLL stays loaded as an agent; the shutdown command unloads it later.
+    // If the agent fails to start, the caller's autoUnload applies after all.
+    const bool oneShotUnload = autoUnload;
+    if (resident)
+        autoUnload = false;
+    bool agentStarted = false;
+
+    // --- 2. Resolve DLL paths -------------------------------------------------
     std::filesystem::path exeDir = ExeDir();
 
     // Same-arch DLL (used when architectures match).
@@ -306,49 +927,54 @@ bool InjectWDASetAffinity(HWND hwnd, DWORD affinity, bool autoUnload)
     if (!FileExists(sameDllPath)) {
         spdlog::error("InjectWDASetAffinity: same-arch DLL not found at {}",
                       WtoU8(sameDllPath));
-        SetLastError(ERROR_FILE_NOT_FOUND);
-        return false;
+        for (auto& e : entries) e.status = ERROR_FILE_NOT_FOUND;
+        return ERROR_FILE_NOT_FOUND;
+    }
+
+    // --- 3. Write shared memory (entries + flags) ------------------------------
+    // Held until the section is closed below.
+    PidInjectionLock lock(pid);
+    if (!lock.owned()) {
+        spdlog::error("InjectWDASetAffinity: timed out waiting for the injection lock "
+                      "of PID {}", pid);
+        for (auto& e : entries) e.status = WAIT_TIMEOUT;
+        return WAIT_TIMEOUT;
     }
 
-    // --- 2. Write shared memory (HWND + affinity) ----------------------------
-    HANDLE hMap = CreateSharedData(hwnd, affinity);
+    HANDLE hMap = CreateSharedData(pid, entries, resident ? WDA_FLAG_RESIDENT : 0);
     if (hMap == INVALID_HANDLE_VALUE) {
-        spdlog::error("InjectWDASetAffinity: CreateSharedData failed (error {})",
-                      GetLastError());
-        return false;
+        DWORD err = GetLastError();
+        spdlog::error("InjectWDASetAffinity: CreateSharedData failed (error {})", err);
+        if (!err) err = ERROR_GEN_FAILURE;
+        for (auto& e : entries) e.status = err;
+        return err;
     }
 
-    bool success = false;
+    DWORD result = ERROR_GEN_FAILURE;
 
     do {
-        // --- 3. Identify target process --------------------------------------
-        DWORD pid = 0;
-        GetWindowThreadProcessId(hwnd, &pid);
-        if (!pid) {
-            spdlog::error("InjectWDASetAffinity: GetWindowThreadProcessId returned 0 (error {})",
-                          GetLastError());
-            break;
-        }
-
-        spdlog::info("InjectWDASetAffinity: target PID = {}", pid);
-
         // --- 4. Open target process ------------------------------------------
-        HANDLE hProcess = OpenProcess(
-            PROCESS_CREATE_THREAD |
-            PROCESS_QUERY_INFORMATION |
-            PROCESS_VM_OPERATION |
-            PROCESS_VM_WRITE |
-            PROCESS_VM_READ,
-            FALSE, pid);
+        HANDLE hProcess;
+        {
+            ScopedStat openTimer(Stat::InjectOpenProcess);
+            hProcess = OpenProcess(
+                PROCESS_CREATE_THREAD |
+                PROCESS_QUERY_INFORMATION |
+                PROCESS_VM_OPERATION |
+                PROCESS_VM_WRITE |
+                PROCESS_VM_READ,
+                FALSE, pid);
+        }
         if (!hProcess) {
+            result = GetLastError();
             spdlog::error("InjectWDASetAffinity: OpenProcess failed for PID {} (error {})",
-                          pid, GetLastError());
+                          pid, result);
             break;
         }
 
         do {
             // --- 5. Detect architecture mismatch ----------------------------
-            bool archMismatch = IsArchMismatch(hProcess);
+            bool archMismatch = IsArchMismatch(hProcess, pid);
 
             if (archMismatch) {
 #ifdef _WIN64
@@ -362,35 +988,38 @@ bool InjectWDASetAffinity(HWND hwnd, DWORD affinity, bool autoUnload)
                 if (!FileExists(oppDllPath)) {
                     spdlog::error("InjectWDASetAffinity: opposite-arch DLL not found at {}",
                                   WtoU8(oppDllPath));
-                    SetLastError(ERROR_FILE_NOT_FOUND);
+                    result = ERROR_FILE_NOT_FOUND;
                     break;
                 }
 
-                // Spawn the opposite-arch launcher which will:
+                // Have the opposite-arch launcher (the session broker, or a
+                // one-shot process as fallback):
                 // 1. FreeLibrary the DLL if already loaded (ensures DllMain fires fresh)
-                // 2. LoadLibraryW the DLL (triggers DllMain → SetWindowDisplayAffinity)
-                // Shared memory (with HWND + affinity) is already populated.
-                success = SpawnLauncherForPid(pid, oppDllPath);
-                if (!success) break;
-
-                // Best-effort affinity check from this side.
-                DWORD actual = 0xFFFFFFFF;
-                if (GetWindowDisplayAffinityW_Safe(hwnd, &actual)) {
-                    success = (actual == affinity);
-                    if (success)
-                        spdlog::info("InjectWDASetAffinity: verified (cross-arch) – "
-                                     "affinity is now {:#x}", actual);
-                    else
-                        spdlog::error("InjectWDASetAffinity: cross-arch affinity mismatch: "
-                                      "expected {:#x}, got {:#x}", affinity, actual);
+                // 2. LoadLibraryW the DLL (triggers DllMain → SetWindowDisplayAffinity
+                //    for every entry)
+                // Shared memory (with all entries) is already populated.
+                if (!RunCrossArchLauncher(pid, oppDllPath)) {
+                    result = GetLastError();
+                    if (!result) result = ERROR_GEN_FAILURE;
+                    break;
+                }
+                result = ERROR_SUCCESS;
+
+                DWORD agentStatus;
+                ReadSharedStatus(hMap, entries, &agentStatus);
+                VerifyPendingEntries(entries);
+                if (resident) {
+                    agentStarted = AgentStarted(pid, agentStatus);
+                    if (!agentStarted) autoUnload = oneShotUnload;
                 }
 
-                // Auto-unload: spawn launcher in unload-only mode so the DLL
+                // Auto-unload: run the launcher in unload-only mode so the DLL
                 // doesn't remain resident in the target process.
-                if (autoUnload && success) {
+                if (autoUnload) {
+                    ScopedStat unloadTimer(Stat::InjectUnload);
                     spdlog::debug("InjectWDASetAffinity: auto-unloading cross-arch DLL from PID {}",
                                   pid);
-                    SpawnLauncherForPid(pid, oppDllPath, /*unloadOnly=*/true);
+                    RunCrossArchLauncher(pid, oppDllPath, /*unloadOnly=*/true);
                 }
                 break; // finished cross-arch path
             }
@@ -399,12 +1028,15 @@ bool InjectWDASetAffinity(HWND hwnd, DWORD affinity, bool autoUnload)
 
             // Unload any previously loaded copy of either DLL variant so the
             // upcoming LoadLibraryW triggers a fresh DllMain.
-            for (const wchar_t* n : { sameDllName, L"wda_inject.dll" }) {
-                HMODULE hRemote = FindRemoteDll(hProcess, n);
-                if (hRemote) {
+            {
+                const std::vector<std::wstring> names = { sameDllName, L"wda_inject.dll" };
+                std::vector<HMODULE> stale = FindRemoteDlls(hProcess, pid, names);
+                for (size_t i = 0; i < names.size(); ++i) {
+                    if (!stale[i]) continue;
                     spdlog::debug("InjectWDASetAffinity: unloading stale '{}' from PID {}",
-                                  WtoU8(n), pid);
-                    RemoteFreeLibrary(hProcess, hRemote);
+                                  WtoU8(names[i]), pid);
+                    RemoteFreeLibrary(hProcess, stale[i]);
+                    ForgetRemoteDllLoaded(pid);
                 }
             }
 
@@ -413,56 +1045,142 @@ bool InjectWDASetAffinity(HWND hwnd, DWORD affinity, bool autoUnload)
             if (exitCode == 0) {
                 spdlog::error("InjectWDASetAffinity: LoadLibraryW returned NULL in PID {} "
                               "(missing dependency, AV blocked injection?)", pid);
+                result = ERROR_MOD_NOT_FOUND;
                 break;
             }
+            result = ERROR_SUCCESS;
 
             spdlog::debug("InjectWDASetAffinity: DLL loaded in PID {} (HMODULE={:#x})",
                           pid, exitCode);
 
-            // --- 8. Verify affinity ------------------------------------------
-            DWORD actual = 0xFFFFFFFF;
-            if (GetWindowDisplayAffinityW_Safe(hwnd, &actual)) {
-                success = (actual == affinity);
-                if (success)
-                    spdlog::info("InjectWDASetAffinity: verified – affinity is now {:#x}",
-                                 actual);
-                else
-                    spdlog::error("InjectWDASetAffinity: affinity mismatch: "
-                                  "expected {:#x}, got {:#x} – "
-                                  "SetWindowDisplayAffinity may have failed inside target.",
-                                  affinity, actual);
-            } else {
-                // GetWindowDisplayAffinity unavailable or call failed; trust the exit code.
-                spdlog::warn("InjectWDASetAffinity: GetWindowDisplayAffinity failed "
-                             "(error {}); assuming success.", GetLastError());
-                success = true;
+            // --- 8. Collect per-HWND results ---------------------------------
+            DWORD agentStatus;
+            ReadSharedStatus(hMap, entries, &agentStatus);
+            VerifyPendingEntries(entries);
+            if (resident) {
+                agentStarted = AgentStarted(pid, agentStatus);
+                if (!agentStarted) autoUnload = oneShotUnload;
             }
 
             // --- 9. Auto-unload the DLL if requested -------------------------
+            const std::wstring loadedName =
+                std::filesystem::path(sameDllPath).filename().wstring();
             if (autoUnload) {
-                HMODULE hRemote = FindRemoteDll(hProcess, sameDllName);
-                if (!hRemote) hRemote = FindRemoteDll(hProcess, L"wda_inject.dll");
+                ScopedStat unloadTimer(Stat::InjectUnload);
+                HMODULE hRemote = FindLoadedRemoteDll(hProcess, pid, loadedName, exitCode, true);
                 if (hRemote) {
                     spdlog::debug("InjectWDASetAffinity: auto-unloading DLL from PID {}", pid);
                     RemoteFreeLibrary(hProcess, hRemote);
+                    ForgetRemoteDllLoaded(pid);
                 }
+            } else {
+                // A kept DLL is remembered for UnloadInjectedDll when that costs no scan.
+                FindLoadedRemoteDll(hProcess, pid, loadedName, exitCode, false);
             }
 
         } while (false);
 
+        if (result == ERROR_SUCCESS && agentStarted) {
+            std::lock_guard<std::mutex> lk(g_residentMutex);
+            g_residentPids.insert(pid);
+        }
+
         CloseHandle(hProcess);
     } while (false);
 
     CloseHandle(hMap);
 
-    if (success)
+    if (result != ERROR_SUCCESS)
+        for (auto& e : entries) e.status = result;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+bool InjectWDASetAffinity(HWND hwnd, DWORD affinity, bool autoUnload)
+{
+    if (!hwnd || !IsWindow(hwnd)) {
+        spdlog::warn("InjectWDASetAffinity: invalid HWND {:#x}", reinterpret_cast<uintptr_t>(hwnd));
+        return false;
+    }
+
+    spdlog::info("InjectWDASetAffinity: hwnd={:#x}, affinity={:#x}, autoUnload={}",
+                 reinterpret_cast<uintptr_t>(hwnd), affinity, autoUnload);
+
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    if (!pid) {
+        spdlog::error("InjectWDASetAffinity: GetWindowThreadProcessId returned 0 (error {})",
+                      GetLastError());
+        return false;
+    }
+
+    spdlog::info("InjectWDASetAffinity: target PID = {}", pid);
+
+    std::vector<WdaAffinityEntry> entries{
+        { reinterpret_cast<UINT64>(hwnd), affinity, WDA_STATUS_PENDING } };
+    ApplyEntriesToPid(pid, entries, autoUnload);
+    const DWORD status = entries[0].status;
+
+    if (status == ERROR_SUCCESS)
         spdlog::info("InjectWDASetAffinity: SUCCESS for HWND {:#x}",
                      reinterpret_cast<uintptr_t>(hwnd));
     else
-        spdlog::error("InjectWDASetAffinity: FAILED for HWND {:#x}",
-                      reinterpret_cast<uintptr_t>(hwnd));
+        spdlog::error("InjectWDASetAffinity: FAILED for HWND {:#x} (error {})",
+                      reinterpret_cast<uintptr_t>(hwnd), status);
 
-    return success;
+    SetLastError(status);
+    return status == ERROR_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+std::vector<bool> InjectWDASetAffinityBatch(DWORD pid, const std::vector<HWND>& hwnds,
+                                            DWORD affinity, bool autoUnload)
+{
+    std::vector<bool> results(hwnds.size(), false);
+    if (!pid || hwnds.empty()) return results;
+
+    spdlog::info("InjectWDASetAffinityBatch: PID={}, {} HWND(s), affinity={:#x}, autoUnload={}",
+                 pid, hwnds.size(), affinity, autoUnload);
+
+    // Only live windows that really belong to `pid` go into the payload.
+    std::vector<WdaAffinityEntry> entries;
+    std::vector<size_t>           index;   // entries[k] ↔ hwnds[index[k]]
+    entries.reserve(hwnds.size());
+    index.reserve(hwnds.size());
+    for (size_t i = 0; i < hwnds.size(); ++i) {
+        HWND  hwnd  = hwnds[i];
+        DWORD owner = 0;
+        if (!hwnd || !IsWindow(hwnd) || !GetWindowThreadProcessId(hwnd, &owner)
+            || owner != pid)
+        {
+            spdlog::warn("InjectWDASetAffinityBatch: skipping HWND {:#x} (invalid or not owned "
+                         "by PID {})", reinterpret_cast<uintptr_t>(hwnd), pid);
+            continue;
+        }
+        entries.push_back({ reinterpret_cast<UINT64>(hwnd), affinity, WDA_STATUS_PENDING });
+        index.push_back(i);
+    }
+
+    // One injection (or agent call) per WDA_SHARED_MAX_ENTRIES windows.
+    size_t succeeded = 0;
+    for (size_t off = 0; off < entries.size(); off += WDA_SHARED_MAX_ENTRIES) {
+        size_t end = std::min(entries.size(), off + WDA_SHARED_MAX_ENTRIES);
+        std::vector<WdaAffinityEntry> chunk(entries.begin() + off, entries.begin() + end);
+        ApplyEntriesToPid(pid, chunk, autoUnload);
+        for (size_t k = 0; k < chunk.size(); ++k) {
+            bool ok = (chunk[k].status == ERROR_SUCCESS);
+            results[index[off + k]] = ok;
+            if (ok) ++succeeded;
+        }
+    }
+
+    if (succeeded == hwnds.size())
+        spdlog::info("InjectWDASetAffinityBatch: SUCCESS for all {} HWND(s) of PID {}",
+                     succeeded, pid);
+    else
+        spdlog::error("InjectWDASetAffinityBatch: {} of {} HWND(s) of PID {} failed",
+                      hwnds.size() - succeeded, hwnds.size(), pid);
+    return results;
 }
 
 // ---------------------------------------------------------------------------
@@ -484,6 +1202,30 @@ bool UnloadInjectedDll(HWND hwnd)
 
     spdlog::info("UnloadInjectedDll: hwnd={:#x}, PID={}",
                  reinterpret_cast<uintptr_t>(hwnd), pid);
+    return UnloadInjectedDllFromPid(pid);
+}
+
+// ---------------------------------------------------------------------------
+bool UnloadInjectedDllFromPid(DWORD pid, DWORD timeoutMs)
+{
+    const ULONGLONG deadline = GetTickCount64() + timeoutMs;
+    auto remaining = [deadline]() -> DWORD {
+        ULONGLONG now = GetTickCount64();
+        return (now < deadline) ? static_cast<DWORD>(deadline - now) : 0;
+    };
+
+    // A resident agent unloads itself; never FreeLibrary it from outside.
+    DWORD agentErr = ShutdownAgent(pid, (std::min)(remaining(), AGENT_CALL_TIMEOUT_MS));
+    if (agentErr == ERROR_SUCCESS) {
+        spdlog::info("UnloadInjectedDll: resident agent in PID {} shut down", pid);
+        return true;
+    }
+    if (agentErr != ERROR_FILE_NOT_FOUND) {
+        spdlog::error("UnloadInjectedDll: resident agent in PID {} unreachable (error {})",
+                      pid, agentErr);
+        SetLastError(agentErr);
+        return false;
+    }
 
     HANDLE hProcess = OpenProcess(
         PROCESS_CREATE_THREAD |
@@ -492,24 +1234,61 @@ bool UnloadInjectedDll(HWND hwnd)
         PROCESS_VM_READ,
         FALSE, pid);
     if (!hProcess) {
+        DWORD err = GetLastError();
         spdlog::error("UnloadInjectedDll: OpenProcess failed for PID {} (error {})",
-                      pid, GetLastError());
+                      pid, err);
+        SetLastError(err);
         return false;
     }
 
+    // Our module list cannot see the other bitness; the launcher unloads
+    // the opposite-arch DLL (a no-op if it is not loaded).
+    if (IsArchMismatch(hProcess, pid)) {
+        CloseHandle(hProcess);
+#ifdef _WIN64
+        const wchar_t* oppDllName = L"wda_inject_x86.dll";
+#else
+        const wchar_t* oppDllName = L"wda_inject_x64.dll";
+#endif
+        std::wstring oppDllPath = (ExeDir() / oppDllName).wstring();
+        DWORD status = ERROR_SUCCESS;
+        if (BrokerRunning()
+            && CallBroker(WDA_BROKER_CMD_UNLOAD, pid, oppDllPath, &status, remaining()))
+        {
+            if (status != ERROR_SUCCESS) {
+                spdlog::error("UnloadInjectedDll: cross-arch unload of PID {} failed (error {})",
+                              pid, status);
+                SetLastError(status);
+                return false;
+            }
+            spdlog::info("UnloadInjectedDll: cross-arch unload ran for PID {} (broker)", pid);
+            return true;
+        }
+        if (remaining() < CROSS_ARCH_UNLOAD_MIN_MS) {
+            spdlog::warn("UnloadInjectedDll: no time left for the cross-arch unload of PID {}",
+                         pid);
+            SetLastError(WAIT_TIMEOUT);
+            return false;
+        }
+        if (!RunCrossArchLauncher(pid, oppDllPath, /*unloadOnly=*/true))
+            return false;
+        spdlog::info("UnloadInjectedDll: cross-arch unload ran for PID {}", pid);
+        return true;
+    }
+
     bool found = false;
     // Try all known DLL names (arch-named and legacy).
-    for (const wchar_t* name : { L"wda_inject_x64.dll", L"wda_inject_x86.dll",
-                                  L"wda_inject.dll" })
-    {
-        HMODULE hMod = FindRemoteDll(hProcess, name);
-        if (hMod) {
-            spdlog::debug("UnloadInjectedDll: found '{}' in PID {}; unloading...",
-                          WtoU8(name), pid);
-            RemoteFreeLibrary(hProcess, hMod);
-            found = true;
-        }
+    const std::vector<std::wstring> names = { L"wda_inject_x64.dll", L"wda_inject_x86.dll",
+                                              L"wda_inject.dll" };
+    std::vector<HMODULE> mods = FindRemoteDlls(hProcess, pid, names);
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (!mods[i]) continue;
+        spdlog::debug("UnloadInjectedDll: found '{}' in PID {}; unloading...",
+                      WtoU8(names[i]), pid);
+        RemoteFreeLibrary(hProcess, mods[i], remaining());
+        found = true;
     }
+    if (found) ForgetRemoteDllLoaded(pid);
 
     CloseHandle(hProcess);
 
@@ -520,3 +1299,130 @@ bool UnloadInjectedDll(HWND hwnd)
 
     return true; // "success" means the operation ran, even if DLL was already absent
 }
+
+// ---------------------------------------------------------------------------
+// System-wide lookup of processes that have a wda_inject DLL loaded.
+//
+// NtQueryInformationFile(FileProcessIdsUsingFile) on each DLL beside the exe
+// returns, in one call, every process that has the file open or mapped -
+// loaded modules included - without enumerating any process's modules.  If it
+// is unavailable, the resident agents' pipes and the PIDs this session
+// injected into are used instead.
+#ifndef STATUS_INFO_LENGTH_MISMATCH
+#define STATUS_INFO_LENGTH_MISMATCH ((LONG)0xC0000004L)
+#endif
+
+struct NtIoStatusBlock {
+    union { LONG Status; PVOID Pointer; };
+    ULONG_PTR Information;
+};
+struct FileProcessIdsUsingFileInfo {
+    ULONG     NumberOfProcessIdsInList;
+    ULONG_PTR ProcessIdList[1];
+};
+static const int FILE_PROCESS_IDS_USING_FILE = 47;   // FILE_INFORMATION_CLASS
+
+typedef LONG (NTAPI* PFN_NtQueryInformationFile)(HANDLE, NtIoStatusBlock*, PVOID, ULONG, int);
+
+static bool ProcessesUsingFile(const std::wstring& path, std::set<DWORD>& pids)
+{
+    static PFN_NtQueryInformationFile pfn =
+        reinterpret_cast<PFN_NtQueryInformationFile>(
+            GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQueryInformationFile"));
+    if (!pfn) return false;
+
+    HANDLE hFile = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES,
+                               FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               nullptr, OPEN_EXISTING, 0, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return GetLastError() == ERROR_FILE_NOT_FOUND;   // nothing can have it loaded
+
+    std::vector<BYTE> buf(4096);
+    LONG status = STATUS_INFO_LENGTH_MISMATCH;
+    for (int attempt = 0; attempt < 6 && status == STATUS_INFO_LENGTH_MISMATCH; ++attempt) {
+        NtIoStatusBlock iosb = {};
+        status = pfn(hFile, &iosb, buf.data(), static_cast<ULONG>(buf.size()),
+                     FILE_PROCESS_IDS_USING_FILE);
+        if (status == STATUS_INFO_LENGTH_MISMATCH) buf.resize(buf.size() * 4);
+    }
+    CloseHandle(hFile);
+    if (status < 0) return false;
+
+    auto* info = reinterpret_cast<const FileProcessIdsUsingFileInfo*>(buf.data());
+    const size_t maxIds = (buf.size() - offsetof(FileProcessIdsUsingFileInfo, ProcessIdList))
+                        / sizeof(ULONG_PTR);
+    const size_t count  = (std::min)(static_cast<size_t>(info->NumberOfProcessIdsInList), maxIds);
+    for (size_t i = 0; i < count; ++i)
+        pids.insert(static_cast<DWORD>(info->ProcessIdList[i]));
+    return true;
+}
+
+std::vector<DWORD> FindProcessesWithInjectedDll()
+{
+    std::set<DWORD> pids;
+    bool ok = true;
+    const std::filesystem::path exeDir = ExeDir();
+    for (const wchar_t* name : { L"wda_inject_x64.dll", L"wda_inject_x86.dll",
+                                  L"wda_inject.dll" })
+        ok = ProcessesUsingFile((exeDir / name).wstring(), pids) && ok;
+
+    if (!ok) {
+        spdlog::info("FindProcessesWithInjectedDll: file query unavailable; "
+                     "using agent pipes and known PIDs");
+        WIN32_FIND_DATAW fd = {};
+        HANDLE hFind = FindFirstFileW(L"\\\\.\\pipe\\*", &fd);
+        if (hFind != INVALID_HANDLE_VALUE) {
+            const std::wstring prefix = std::wstring(WDA_AGENT_PIPE_PREFIX).substr(9);  // drop the \\.\pipe\ part
+            do {
+                if (_wcsnicmp(fd.cFileName, prefix.c_str(), prefix.size()) == 0)
+                    pids.insert(static_cast<DWORD>(wcstoul(fd.cFileName + prefix.size(),
+                                                           nullptr, 10)));
+            } while (FindNextFileW(hFind, &fd));
+            FindClose(hFind);
+        }
+        {
+            std::lock_guard<std::mutex> lk(g_remoteDllMutex);
+            for (const auto& kv : g_remoteDlls)
+                if (kv.second.loaded) pids.insert(kv.first);
+        }
+        std::lock_guard<std::mutex> lk(g_residentMutex);
+        pids.insert(g_residentPids.begin(), g_residentPids.end());
+    }
+
+    pids.erase(0);
+    pids.erase(GetCurrentProcessId());
+    spdlog::info("FindProcessesWithInjectedDll: {} process(es)", pids.size());
+    return std::vector<DWORD>(pids.begin(), pids.end());
+}
+
+// ---------------------------------------------------------------------------
+void SetResidentAgentMode(bool enable)
+{
+    g_residentMode.store(enable);
+    spdlog::info("SetResidentAgentMode: {}", enable ? "on" : "off");
+}
+
+// ---------------------------------------------------------------------------
+void ShutdownResidentAgents()
+{
+    std::vector<DWORD> pids;
+    {
+        std::lock_guard<std::mutex> lk(g_residentMutex);
+        pids.assign(g_residentPids.begin(), g_residentPids.end());
+    }
+    if (pids.empty()) return;
+
+    spdlog::info("ShutdownResidentAgents: stopping {} agent(s)", pids.size());
+    for (DWORD pid : pids)
+        ShutdownAgent(pid);
+
+    std::lock_guard<std::mutex> lk(g_residentMutex);
+    g_residentPids.clear();
+}
+
+// ---------------------------------------------------------------------------
+std::vector<DWORD> ResidentAgentPids()
+{
+    std::lock_guard<std::mutex> lk(g_residentMutex);
+    return std::vector<DWORD>(g_residentPids.begin(), g_residentPids.end());
+}
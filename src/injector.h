@@ -1,6 +1,7 @@
 #pragma once
 
 #include <windows.h>
+#include <vector>
 #include "window_ops.h"
 
 /// Inject wda_inject.dll into the process that owns `hwnd` and call
@@ -11,16 +12,55 @@
 ///           WDA_EXCLUDEFROMCAPTURE (0x00000011) to exclude from capture.
 /// autoUnload: if true (default), FreeLibrary the DLL after the affinity call
 ///             so that it does not remain loaded in the target process.
+///             Ignored while resident agent mode is on.
+/// If a resident agent is already running in the target process the command is
+/// sent over its pipe instead (no remote thread, no module scan).
 /// The DLL (and same-arch launcher) must be placed next to the executable.
 /// Returns true if the injection and the affinity call succeeded.
 bool InjectWDASetAffinity(HWND hwnd, DWORD affinity, bool autoUnload = true);
 
+/// Apply one affinity to several windows of the same process with a single
+/// injection (or a single resident-agent call): the DLL applies every HWND in
+/// one DllMain pass and reports a status per window.  HWNDs that are invalid
+/// or not owned by `pid` are skipped and reported as failed.
+/// Returns one result per entry of `hwnds`, in the same order.
+std::vector<bool> InjectWDASetAffinityBatch(DWORD pid, const std::vector<HWND>& hwnds,
+                                            DWORD affinity, bool autoUnload = true);
+
 /// Unload wda_inject.dll from the process that owns `hwnd` (if loaded).
 /// Useful for cleaning up DLLs left by a previous session or when auto-unload
-/// was disabled.  Returns true if the DLL was found and successfully unloaded
-/// (or was not loaded at all).
+/// was disabled.  A resident agent is sent the shutdown command instead.
+/// Returns true if the DLL was found and successfully unloaded (or was not
+/// loaded at all).
 bool UnloadInjectedDll(HWND hwnd);
 
+/// Same as UnloadInjectedDll for a process ID, spending at most about
+/// timeoutMs on it: the agent shutdown, remote FreeLibrary waits and a
+/// cross-arch unload through the running launcher broker are cut to what is
+/// left.  A cross-arch unload that needs a new helper process is skipped
+/// with less than 5 s left; it then fails with WAIT_TIMEOUT.
+bool UnloadInjectedDllFromPid(DWORD pid, DWORD timeoutMs = 5000);
+
+/// PIDs of every process that currently has a wda_inject DLL loaded, found
+/// with one system-wide query per DLL file instead of a module walk of each
+/// process.  Falls back to the resident agents' pipes plus the processes this
+/// session injected into when that query is unavailable.
+std::vector<DWORD> FindProcessesWithInjectedDll();
+
+/// Opt-in resident agent mode (off by default).  When on, the next injection
+/// into a process leaves wda_inject.dll loaded with a worker thread listening
+/// on a per-PID named pipe; later calls for that process go over the pipe.
+void SetResidentAgentMode(bool enable);
+
+/// Send the shutdown command to every resident agent started by this session,
+/// one after another on the calling thread (each bounded by
+/// AGENT_CALL_TIMEOUT_MS).  The app itself stops agents on exit through
+/// UnloadFromProcesses(ResidentAgentPids(), ...) so they run in parallel.
+void ShutdownResidentAgents();
+
+/// PIDs whose resident agent was started by this session and not shut down yet.
+std::vector<DWORD> ResidentAgentPids();
+
 /// Convenience wrapper – sets WDA_EXCLUDEFROMCAPTURE.
 inline bool InjectWDAExcludeFromCapture(HWND hwnd, bool autoUnload = true)
 {
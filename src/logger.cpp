@@ -1,15 +1,88 @@
 #include "logger.h"
 
 #include <windows.h>
+#include <chrono>
+#include <cwctype>
 #include <filesystem>
 #include <string>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <spdlog/spdlog.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/msvc_sink.h>
 
+// Same key as the dialog's settings (main.cpp REG_APP_KEY).
+static const wchar_t* const LOG_REG_KEY = L"Software\\WindowModifier";
+
+static std::thread g_settingsWatcher;
+static HANDLE      g_stopWatcher = nullptr;
+
+// Read a REG_SZ level name; returns `def` if missing or unrecognised.
+static spdlog::level::level_enum ReadLevel(HKEY hKey, const wchar_t* name,
+                                           spdlog::level::level_enum def)
+{
+    wchar_t buf[32] = {};
+    DWORD   size = sizeof(buf) - sizeof(wchar_t), type = 0;
+    if (!hKey || RegQueryValueExW(hKey, name, nullptr, &type,
+            reinterpret_cast<BYTE*>(buf), &size) != ERROR_SUCCESS
+        || type != REG_SZ)
+        return def;
+
+    std::string level;
+    for (const wchar_t* p = buf; *p; ++p)
+        level.push_back(static_cast<char>(towlower(*p)));
+    // from_str maps unknown names to "off"; only accept real ones.
+    spdlog::level::level_enum lvl = spdlog::level::from_str(level);
+    if (lvl == spdlog::level::off && level != "off") return def;
+    return lvl;
+}
+
+static bool ReadAsync(HKEY hKey)
+{
+    DWORD val = 1, size = sizeof(val), type = 0;
+    if (hKey && RegQueryValueExW(hKey, L"LogAsync", nullptr, &type,
+            reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS
+        && type == REG_DWORD)
+        return val != 0;
+    return true;
+}
+
+// Apply LogLevel / LogFlushLevel to the default logger.
+static void ApplyLevels(HKEY hKey)
+{
+    auto logger = spdlog::default_logger();
+    if (!logger) return;
+    auto level = ReadLevel(hKey, L"LogLevel",      spdlog::level::debug);
+    auto flush = ReadLevel(hKey, L"LogFlushLevel", spdlog::level::warn);
+    if (level != logger->level() || flush != logger->flush_level()) {
+        logger->set_level(level);
+        logger->flush_on(flush);
+        spdlog::info("Logger: level {}, flush on {}",
+                     spdlog::level::to_string_view(level),
+                     spdlog::level::to_string_view(flush));
+    }
+}
+
+// Re-apply the levels whenever a value under the settings key changes.
+static void SettingsWatcherProc(HKEY hKey)
+{
+    HANDLE changed = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    while (changed) {
+        if (RegNotifyChangeKeyValue(hKey, FALSE, REG_NOTIFY_CHANGE_LAST_SET,
+                                    changed, TRUE) != ERROR_SUCCESS)
+            break;
+        HANDLE waits[2] = { g_stopWatcher, changed };
+        if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+            break;
+        ApplyLevels(hKey);
+    }
+    if (changed) CloseHandle(changed);
+    RegCloseKey(hKey);
+}
+
 void InitLogger()
 {
     // Determine the log-file path: same directory as the running executable.
@@ -33,23 +106,67 @@ void InitLogger()
         }
     }
 
+    // Created if missing, so the watcher has something to watch.
+    HKEY hKey = nullptr;
+    if (RegCreateKeyExW(HKEY_CURRENT_USER, LOG_REG_KEY, 0, nullptr,
+            REG_OPTION_NON_VOLATILE, KEY_READ | KEY_NOTIFY, nullptr, &hKey, nullptr)
+        != ERROR_SUCCESS)
+        hKey = nullptr;
+    bool async = ReadAsync(hKey);
+
     try {
         auto fileSink  = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logPathA, /*truncate=*/true);
         auto debugSink = std::make_shared<spdlog::sinks::msvc_sink_mt>();
+        spdlog::sinks_init_list sinks{ fileSink, debugSink };
 
-        auto logger = std::make_shared<spdlog::logger>(
-            "window_mod",
-            spdlog::sinks_init_list{ fileSink, debugSink });
+        std::shared_ptr<spdlog::logger> logger;
+        if (async) {
+            spdlog::init_thread_pool(LOG_QUEUE_SIZE, 1);
+            logger = std::make_shared<spdlog::async_logger>(
+                "window_mod", sinks, spdlog::thread_pool(),
+                spdlog::async_overflow_policy::overrun_oldest);
+        } else {
+            logger = std::make_shared<spdlog::logger>("window_mod", sinks);
+        }
 
-        logger->set_level(spdlog::level::debug);
-        logger->flush_on(spdlog::level::debug);
+        logger->set_level(ReadLevel(hKey, L"LogLevel", spdlog::level::debug));
+        logger->flush_on(ReadLevel(hKey, L"LogFlushLevel", spdlog::level::warn));
         spdlog::set_default_logger(logger);
+        spdlog::flush_every(std::chrono::seconds(1));
 
-        spdlog::info("window_mod logger started. Log file: {}", logPathA);
+        spdlog::info("window_mod logger started ({}, level {}, flush on {}). Log file: {}",
+                     async ? "async" : "sync",
+                     spdlog::level::to_string_view(logger->level()),
+                     spdlog::level::to_string_view(logger->flush_level()),
+                     logPathA);
     } catch (const spdlog::spdlog_ex& ex) {
         // Fallback: at least write to the debugger output.
         OutputDebugStringA("window_mod: failed to initialise spdlog file logger: ");
         OutputDebugStringA(ex.what());
         OutputDebugStringA("\n");
     }
+
+    if (hKey) {
+        g_stopWatcher = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (g_stopWatcher)
+            g_settingsWatcher = std::thread(SettingsWatcherProc, hKey);
+        else
+            RegCloseKey(hKey);
+    }
+}
+
+void ShutdownLogger()
+{
+    if (g_settingsWatcher.joinable()) {
+        SetEvent(g_stopWatcher);
+        g_settingsWatcher.join();
+    }
+    if (g_stopWatcher) {
+        CloseHandle(g_stopWatcher);
+        g_stopWatcher = nullptr;
+    }
+    spdlog::shutdown();   // drains the async queue, flushes and drops all loggers
+    // Inject-pool jobs abandoned at exit (StopInjectPool's deadline) may
+    // still log until ExitProcess ends them: give them a logger with no sinks.
+    spdlog::set_default_logger(std::make_shared<spdlog::logger>("discard"));
 }
@@ -1,7 +1,26 @@
 #pragma once
 
+/// Capacity of the async logger's ring buffer, in messages.
+static const unsigned LOG_QUEUE_SIZE = 8192;
+
 /// Call once at application startup (before any logging).
 /// Creates (or truncates) "window_mod.log" next to the executable and registers
 /// it as the spdlog default logger.  All subsequent spdlog calls (info / warn /
 /// error / debug) write to that file and to the debugger output (OutputDebugString).
+///
+/// By default the logger is asynchronous: a call formats the message and
+/// queues it on a bounded ring buffer (LOG_QUEUE_SIZE entries) drained by one
+/// background thread, which owns the file and debugger sinks.  When the queue
+/// is full the oldest entry is dropped, so logging never blocks the caller.
+///
+/// Settings are read from HKCU\Software\WindowModifier:
+///   LogLevel       REG_SZ     trace / debug / info / warn / error / off (default debug)
+///   LogFlushLevel  REG_SZ     flush immediately at or above this level (default warn);
+///                             everything else is flushed once a second
+///   LogAsync       REG_DWORD  0 = synchronous logging (takes effect on next start)
+/// LogLevel and LogFlushLevel are watched and re-applied while running.
 void InitLogger();
+
+/// Call once before exit: stops the settings watcher, drains the queue and
+/// flushes the file.  Later spdlog calls are discarded.
+void ShutdownLogger();
@@ -27,19 +27,40 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <sstream>
 #include <iomanip>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
-#include <deque>
 #include <atomic>
 #include <chrono>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <functional>
 
 #include "resource.h"
 #include "window_list.h"
+#include "window_row.h"
 #include "window_ops.h"
 #include "injector.h"
+#include "inject_pool.h"
+#include "process_cache.h"
+#include "window_model.h"
+#include "icon_cache.h"
+#include "dxgi_capture.h"
+#include "dib_pool.h"
+#include "downscale.h"
+#include "dwm_thumbnail.h"
+#include "tile_hash.h"
+#include "tile_diff.h"
+#include "capture_frame.h"
+#include "stats.h"
+#include "cli.h"
+#include "channel.h"
+#include "watch_rules.h"
 #include "logger.h"
 
 #pragma comment(lib, "comctl32.lib")
@@ -53,66 +74,47 @@
 #define WM_APP_WINDOWS_READY  (WM_APP + 1)   // injector thread: window list ready
 #define WM_APP_PREVIEW_READY  (WM_APP + 2)   // capture thread:  preview bitmap ready
 #define WM_APP_WATCH_APPLIED  (WM_APP + 3)   // injector thread: watch rule applied
-
-// ============================================================================
-// Thread-safe channel (analogous to Rust's crossbeam_channel::unbounded)
-// ============================================================================
-template<typename T>
-class Channel {
-    std::mutex              mtx_;
-    std::condition_variable cv_;
-    std::deque<T>           q_;
-    bool                    closed_ = false;
-public:
-    void send(T val) {
-        { std::lock_guard<std::mutex> lk(mtx_); q_.push_back(std::move(val)); }
-        cv_.notify_one();
-    }
-    // Blocks until an item is available or the channel is closed.
-    // Returns false when closed and the queue is empty.
-    bool recv(T& out) {
-        std::unique_lock<std::mutex> lk(mtx_);
-        cv_.wait(lk, [this]{ return !q_.empty() || closed_; });
-        if (q_.empty()) return false;
-        out = std::move(q_.front());
-        q_.pop_front();
-        return true;
-    }
-    // Waits up to `ms` milliseconds for an item.
-    // Returns true if an item was received, false on timeout or channel close.
-    bool recv_timeout(T& out, unsigned ms) {
-        std::unique_lock<std::mutex> lk(mtx_);
-        bool ready = cv_.wait_for(lk, std::chrono::milliseconds(ms),
-                                  [this]{ return !q_.empty() || closed_; });
-        if (!ready || q_.empty()) return false;
-        out = std::move(q_.front());
-        q_.pop_front();
-        return true;
-    }
-    void close() {
-        { std::lock_guard<std::mutex> lk(mtx_); closed_ = true; }
-        cv_.notify_all();
-    }
-};
+#define WM_APP_INJECT_DONE    (WM_APP + 4)   // inject pool: lParam = InjectResult* (receiver deletes)
+#define WM_APP_WINDOWS_LISTED (WM_APP + 5)   // injector thread: startup enumeration published
+#define WM_APP_UNLOAD_ALL_DONE (WM_APP + 6)  // inject pool: lParam = UnloadAllResult* (receiver deletes)
+#define WM_APP_STRIP_READY    (WM_APP + 7)   // capture thread:  thumbnail strip ready
+#define WM_APP_CAPTURE_CHECKED (WM_APP + 8)  // capture thread:  wParam = HWND, lParam = CaptureCheck
 
 // ============================================================================
 // Injector worker events
 // ============================================================================
-enum class InjectorEventType { Update, WatchCheck, Quit };
+// StartupList / Warmup are the two background stages of startup: a first
+// enumeration without icon requests, then (after the first paint) the icons
+// and the first watch sweep in background mode.
+enum class InjectorEventType { Update, WatchCheck, WindowEvent, StartupList, Warmup, Quit };
 struct InjectorEvent {
-    InjectorEventType type = InjectorEventType::Update;
+    InjectorEventType type     = InjectorEventType::Update;
+    HWND              hwnd     = nullptr;   // WindowEvent: top-level window concerned
+    DWORD             winEvent = 0;         // WindowEvent: EVENT_OBJECT_* code, 0 = re-query only
 };
 
 // ============================================================================
 // Capture worker events
 // ============================================================================
-enum class CaptureEventType { Capture, StopCapture, Quit };
+// CheckBefore / CheckAfter drive the capture-leak check (g_captureCheck): the
+// worker grabs `hwnds` while the injection is under way, skipping any whose
+// affinity is already applied, and compares once CheckAfter reports the result.
+enum class CaptureEventType { Capture, StopCapture, CheckBefore, CheckAfter, Quit };
 struct CaptureEvent {
     CaptureEventType type       = CaptureEventType::StopCapture;
     RECT             monitorRect = {};
+    SIZE             previewSize = {};      // Capture: preview control size (GPU downscale target)
     bool             showCursor = false;
+    unsigned         frameTag   = 0;        // Capture: copied to PooledDib::tag of its frames
+    std::vector<RECT> stripMonitors;        // Capture: thumbnail strip monitors, empty = no strip
+    SIZE             stripSize  = {};       // Capture: IDC_MONITOR_STRIP client size
+    std::vector<HWND> hwnds;                // CheckBefore / CheckAfter: windows concerned
+    std::vector<bool> applied;              // CheckAfter: parallel to hwnds (InjectResult::ok)
 };
 
+// Capture-leak check state of one list row (WM_APP_CAPTURE_CHECKED).
+enum class CaptureCheck { None, Pending, Absent, Visible, Inconclusive };
+
 // ============================================================================
 // Dark theme colours  (Catppuccin Mocha palette)
 // ============================================================================
@@ -134,11 +136,7 @@ static const COLORREF CLR_SEP        = RGB(0x45, 0x47, 0x5a);  // surface1 (sepa
 static const int PREVIEW_H_MIN   = 80;   // minimum preview height in pixels
 static const int PREVIEW_H_MAX   = 200;  // maximum preview height in pixels
 static const int PREVIEW_H_PCT   = 30;   // preview height as % of window height
-
-// LVS_EX_CHECKBOXES state-image index constants (LVIS_STATEIMAGEMASK >> 12)
-static const UINT STATE_IMAGE_SHIFT     = 12;
-static const UINT STATE_IMAGE_UNCHECKED = 1;
-static const UINT STATE_IMAGE_CHECKED   = 2;
+static const int MONITOR_STRIP_H = 48;   // thumbnail strip height in pixels
 
 // ============================================================================
 // State
@@ -148,11 +146,14 @@ static HWND      g_hDlg        = nullptr;
 
 static std::vector<WindowInfo> g_windows;       // current window snapshot (UI thread)
 static std::vector<WindowInfo> g_hiddenWindows; // windows we've hidden
+static std::unordered_set<HWND> g_seededWindows; // rows from the last-session snapshot not yet confirmed
 
 // Monitor / screen preview
 static std::vector<RECT> g_monitors;
 static int               g_currentMonitor = 0;
-static HBITMAP           g_previewBmp     = nullptr;
+static PooledDib*        g_previewFrame   = nullptr;   // shown frame, from g_previewPool
+static PooledDib*        g_stripFrame     = nullptr;   // shown thumbnail strip, from g_stripPool
+static unsigned          g_previewTag     = 0;         // frames tagged otherwise predate the last switch
 
 // Suppress LVN_ITEMCHANGED side-effects during programmatic list updates
 static bool g_populatingList = false;
@@ -163,47 +164,165 @@ static bool g_hasFocus = true;
 // Whether the desktop preview is shown (mirrors IDC_CHK_SHOW_PREVIEW)
 static bool g_showDesktopPreview = true;
 
+// Whether the per-monitor thumbnail strip is shown under the preview
+// (mirrors IDC_CHK_MONITOR_STRIP)
+static bool g_showMonitorStrip = false;
+
+// Whether the preview shows the selected window instead of the monitor
+// (mirrors IDC_CHK_PREVIEW_WINDOW).  That preview is a DWM thumbnail composed
+// straight into IDC_PREVIEW_STATIC; the capture worker is stopped meanwhile.
+static bool         g_previewSelectedWindow = false;
+static DwmThumbnail g_windowThumb;
+
 // Whether to auto-unload the DLL after each injection (mirrors IDC_CHK_AUTO_UNLOAD)
 static bool g_autoUnloadDll = true;
 
+// Whether injected DLLs stay resident as a pipe agent (mirrors IDC_CHK_RESIDENT_AGENT)
+static bool g_residentAgent = false;
+
+// "Unload from all processes": tray command, and optionally at exit (mirrors
+// IDM_TRAY_UNLOAD_ON_EXIT).  The exit pass shares one short deadline so
+// WM_DESTROY never waits on a slow target for long.
+static bool            g_unloadAllOnExit  = false;
+static bool            g_unloadAllRunning = false;   // UI thread only
+static const DWORD     UNLOAD_ALL_TIMEOUT_MS  = 15000;
+static const DWORD     EXIT_UNLOAD_TIMEOUT_MS = 1500;
+// Then at most this long for the inject pool's running jobs; stragglers are
+// abandoned and ended by ExitProcess (g_injectPoolAbandoned).
+static const DWORD     EXIT_POOL_TIMEOUT_MS   = 500;
+static bool            g_injectPoolAbandoned  = false;
+
 // Dark theme GDI resources
 static HBRUSH g_hbrBg            = nullptr;
 static HBRUSH g_hbrListBg        = nullptr;
 static HFONT  g_hFontBold        = nullptr;
 static HFONT  g_hFontPlaceholder = nullptr; // large font for the focus-lost screen
+static HBRUSH g_hbrSep           = nullptr;
+static HBRUSH g_hbrBtnBg         = nullptr;
+static HBRUSH g_hbrBtnPress      = nullptr;
+static HPEN   g_hpenBtnBorder    = nullptr;
+static HPEN   g_hpenBtnFocus     = nullptr;
+static HBRUSH g_hbrAccent        = nullptr; // current monitor outline in the strip
+static HFONT  g_hFontPreviewPh   = nullptr; // ":)" in the preview, dh / 2 high
+static int    g_previewPhHeight  = 0;       // height g_hFontPreviewPh was made for
+
+// Off-screen bitmap + DC for flicker-free owner draw.  Kept for the dialog's
+// lifetime and only reallocated when a larger one is needed, so a paint
+// allocates nothing in steady state.
+struct PaintBuffer {
+    HDC     dc  = nullptr;
+    HBITMAP bmp = nullptr;
+    HGDIOBJ old = nullptr;
+    int     cx  = 0, cy = 0;
+
+    // DC with a bitmap of at least w × h compatible with `ref`, or nullptr.
+    HDC Get(HDC ref, int w, int h)
+    {
+        if (w <= 0 || h <= 0) return nullptr;
+        if (dc && w <= cx && h <= cy) return dc;
+        Destroy();
+        dc  = CreateCompatibleDC(ref);
+        bmp = CreateCompatibleBitmap(ref, w, h);
+        if (!dc || !bmp) { Destroy(); return nullptr; }
+        old = SelectObject(dc, bmp);
+        cx  = w;
+        cy  = h;
+        return dc;
+    }
+    void Destroy()
+    {
+        if (dc && old) SelectObject(dc, old);
+        if (bmp) DeleteObject(bmp);
+        if (dc)  DeleteDC(dc);
+        dc = nullptr; bmp = nullptr; old = nullptr;
+        cx = cy = 0;
+    }
+};
+// Latency-stats tooltip on IDC_STATUS_TEXT (see stats.h)
+static HWND  g_hStatsTip  = nullptr;
+static HFONT g_hFontMono  = nullptr;   // tooltip font, keeps the columns aligned
+
+static PaintBuffer g_previewBuf;              // IDC_PREVIEW_STATIC, sized by OnSize
+static PaintBuffer g_stripBuf;                // IDC_MONITOR_STRIP
+static PaintBuffer g_buttonBuf;               // flat owner-draw buttons
+static HDC         g_hdcPreviewFrame = nullptr;  // selects g_previewFrame for blitting
 
 // Tray icon
 static NOTIFYICONDATA g_nid       = {};
 static bool           g_trayAdded = false;
 
 // ── Injector worker thread ──────────────────────────────────────────────────
-// Receives InjectorEvent::Update, calls EnumerateWindows(), stores result in
-// g_pendingWindows, then posts WM_APP_WINDOWS_READY to the dialog.
-static Channel<InjectorEvent>   g_injectorChannel;
+// Owns the WindowModel.  WinEvents (InjectorEvent::WindowEvent) and the full
+// resync (InjectorEvent::Update) turn into WindowDeltas that are appended to
+// g_pendingDeltas; WM_APP_WINDOWS_READY is posted when the queue goes from
+// empty to non-empty, so a burst of changes costs the UI one message.
+// The WinEvent hook runs on the UI thread and must never wait for the
+// injector thread, so it uses try_send: when the ring is full the event is
+// dropped and g_injectorOverflow makes the worker resync once it has drained
+// the backlog.  Other producers send rare control events and may block.
+static const size_t              INJECTOR_QUEUE_SIZE = 4096;   // WinEvent bursts
+static MpscChannel<InjectorEvent, INJECTOR_QUEUE_SIZE> g_injectorChannel;
+static std::atomic<bool>         g_injectorOverflow{false};    // WinEvents dropped, resync
+static const ULONGLONG           WINDOW_RETRY_INTERVAL_MS = 2000;  // pending-window retry
 static std::thread               g_injectorThread;
-static std::mutex                g_pendingWindowsMutex;
-static std::vector<WindowInfo>   g_pendingWindows;
+static std::mutex                g_pendingDeltasMutex;
+static std::vector<WindowDelta>  g_pendingDeltas;
+
+// WinEvent hooks feeding the window model and Process Watch (UI thread).
+static HWINEVENTHOOK             g_winEventHooks[2] = {};
 
 // ── Process watch ───────────────────────────────────────────────────────────
-// g_watchedExeNames: exe filenames to monitor (UI-thread owned; copied under lock).
-// g_watchedPids:     PIDs already injected (updated by injector thread; cleaned on exit).
-static std::vector<std::wstring> g_watchedExeNames;
-static std::mutex                g_watchedExeMutex;
-static std::set<DWORD>           g_watchedPids;
-static std::mutex                g_watchedPidsMutex;
+// g_watchRules:      the watch list in display order (UI-thread owned; copied
+//                    under lock).
+// g_watchRuleSet:    g_watchRules compiled for matching (see watch_rules.h);
+//                    rebuilt by OnWatchListChanged() and shared read-only.
+// g_watchedWindows:  HWND → the window's process and the affinity the watcher
+//                    gave it (updated by the injector thread and the inject
+//                    pool; entries go on EVENT_OBJECT_DESTROY).  A window is
+//                    injected only when it is missing or its rule now wants
+//                    another affinity; the process creation time keeps a
+//                    recycled HWND or PID from being mistaken for the old one.
+struct WatchedWindow {
+    DWORD     pid        = 0;
+    ULONGLONG createTime = 0;
+    DWORD     affinity   = 0;
+};
+static std::vector<WatchRule>    g_watchRules;
+static std::shared_ptr<const WatchRuleSet> g_watchRuleSet;
+static std::mutex                g_watchRulesMutex;
+static std::unordered_map<HWND, WatchedWindow> g_watchedWindows;
+static std::mutex                g_watchedWindowsMutex;
 
 // ── Capture worker thread ───────────────────────────────────────────────────
-// Continuously captures frames (via BitBlt) while in capturing state and posts
+// Continuously captures frames while in capturing state and posts
 // WM_APP_PREVIEW_READY to the dialog for each frame.
 // CaptureEvent::Capture starts/restarts continuous capture for a given monitor rect.
 // CaptureEvent::StopCapture stops the continuous loop.
-static Channel<CaptureEvent>    g_captureChannel;
+// Frames are rendered at preview size into DIBs from g_previewPool; the UI
+// thread releases each one back to the pool when the next replaces it.
+static MpscChannel<CaptureEvent, 64> g_captureChannel;   // UI and injector threads, inject-pool callbacks (CheckAfter)
 static std::thread               g_captureThread;
-static std::mutex                g_pendingPreviewMutex;
-static HBITMAP                   g_pendingPreviewBmp = nullptr;
+static DibPool                   g_previewPool;
+static LatestSlot<PooledDib>     g_pendingPreview;      // newest unshown frame
+// Thumbnail strip: one strip-size DIB holding every monitor's thumbnail,
+// handed over the same way as the preview frames (WM_APP_STRIP_READY).
+static DibPool                   g_stripPool;
+static LatestSlot<PooledDib>     g_pendingStrip;
 // Mirrors IDC_CHK_SHOW_CURSOR; updated atomically so the capture thread can
 // read it on every frame without touching the UI thread.
 static std::atomic<bool>         g_captureShowCursor{false};
+// Preview frame-rate range (registry PreviewMinFps / PreviewMaxFps): the
+// worker runs at the maximum while the screen changes and backs off towards
+// the minimum while it does not.
+static std::atomic<unsigned>     g_previewMinFps{1};
+static std::atomic<unsigned>     g_previewMaxFps{30};
+// Capture-leak check (IDM_TRAY_CAPTURE_CHECK, registry CaptureCheck): after
+// each exclusion, compare a grab of the window taken before the change with
+// one taken after it, and flag windows whose pixels are still captured.
+// Also read by the injector thread (watch injections).
+static std::atomic<bool>         g_captureCheck{false};
+static std::atomic<bool>         g_captureWorkerUp{false};   // CaptureWorkerProc is running
+static std::unordered_map<HWND, CaptureCheck> g_captureChecks;   // UI thread only
 
 // ============================================================================
 // DPI awareness helper
@@ -233,192 +352,1130 @@ static PFN_SetThreadDpiAwarenessContext GetSetThreadDpiAwarenessFn()
 // ============================================================================
 INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam);
 static void ShowPreviewControls(HWND hDlg, bool show);
+static void SyncWindowListCount(HWND hDlg, int firstDirty);
 
 // ============================================================================
-// Injector worker thread
-// Handles InjectorEvent::Update: enumerates top-level windows asynchronously
-// and notifies the UI thread via WM_APP_WINDOWS_READY.
+// Process watch helpers (injector thread)
 // ============================================================================
-static void InjectorWorkerProc()
+
+static std::shared_ptr<const WatchRuleSet> CurrentWatchRuleSet()
 {
-    InjectorEvent evt;
-    while (g_injectorChannel.recv(evt)) {
-        if (evt.type == InjectorEventType::Quit) break;
+    std::lock_guard<std::mutex> lk(g_watchRulesMutex);
+    return g_watchRuleSet;
+}
 
-        if (evt.type == InjectorEventType::Update) {
-            // Enumerate top-level windows and notify the UI thread.
-            auto windows = EnumerateWindows();
-            {
-                std::lock_guard<std::mutex> lk(g_pendingWindowsMutex);
-                g_pendingWindows = std::move(windows);
-            }
-            if (g_hDlg)
-                PostMessage(g_hDlg, WM_APP_WINDOWS_READY, 0, 0);
+// Rules whose pattern matches pid's process, in list order.  The image path
+// is only queried (through the process cache) for full-path rules.
+static void MatchWatchedProcess(const WatchRuleSet& rules, DWORD pid,
+                                const std::wstring& imageName, std::vector<int>& out)
+{
+    rules.MatchProcess(imageName, [pid]() { return GetProcessInfo(pid).imagePath; }, out);
+}
+
+// The watch rule for one window of a matched process, or nullptr if no
+// candidate's title filter accepts it.  The title is read (without sending a
+// message) only when a candidate filters on it.
+static const WatchRule* MatchWatchedWindow(const WatchRuleSet& rules,
+                                           const std::vector<int>& candidates, HWND hwnd)
+{
+    std::wstring title;
+    if (rules.NeedsTitle(candidates)) {
+        wchar_t buf[512] = {};
+        InternalGetWindowText(hwnd, buf, 512);
+        title = buf;
+    }
+    return rules.MatchWindow(candidates, title);
+}
+
+// Watch injections grouped by (PID, affinity): one batched injection each.
+using WatchTargets = std::map<std::pair<DWORD, DWORD>, std::vector<HWND>>;
+
+// A process's candidate rules (MatchWatchedProcess), looked up once per call.
+struct WatchProcessMatch {
+    ULONGLONG        createTime = 0;
+    std::vector<int> rules;
+};
+using WatchProcessMatches = std::map<DWORD, WatchProcessMatch>;
+
+// Add to targets every window in hwnds that a watch rule selects and that
+// g_watchedWindows does not already record with that rule's affinity, and
+// record it there (so a burst of events for one window injects it once).
+// Processes missing from `matches` are looked up and added.
+static void SelectWatchTargets(const WatchRuleSet& rules, const std::vector<HWND>& hwnds,
+                               WatchProcessMatches& matches, WatchTargets& targets)
+{
+    const DWORD selfPid = GetCurrentProcessId();
+    for (HWND hwnd : hwnds) {
+        DWORD pid = 0;
+        GetWindowThreadProcessId(hwnd, &pid);
+        if (!pid || pid == selfPid) continue;
+
+        auto it = matches.find(pid);
+        if (it == matches.end()) {
+            ProcessInfo info = GetProcessInfo(pid);
+            it = matches.emplace(pid, WatchProcessMatch()).first;
+            it->second.createTime = info.createTime;
+            MatchWatchedProcess(rules, pid, info.imageName, it->second.rules);
         }
-        else if (evt.type == InjectorEventType::WatchCheck) {
-            // Get a snapshot of the current watch list.
-            std::vector<std::wstring> watchNames;
-            {
-                std::lock_guard<std::mutex> lk(g_watchedExeMutex);
-                watchNames = g_watchedExeNames;
-            }
-            if (watchNames.empty()) continue;
+        const WatchProcessMatch& m = it->second;
+        if (m.rules.empty()) continue;
 
-            // Clean up PIDs that are no longer alive.
-            {
-                std::lock_guard<std::mutex> lk(g_watchedPidsMutex);
-                for (auto it = g_watchedPids.begin(); it != g_watchedPids.end(); ) {
-                    HANDLE hP = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, *it);
-                    if (!hP) {
-                        it = g_watchedPids.erase(it);
-                    } else {
-                        DWORD code = 0;
-                        GetExitCodeProcess(hP, &code);
-                        CloseHandle(hP);
-                        it = (code != STILL_ACTIVE) ? g_watchedPids.erase(it) : ++it;
-                    }
-                }
-            }
+        const WatchRule* rule = MatchWatchedWindow(rules, m.rules, hwnd);
+        if (!rule) continue;
+        {
+            std::lock_guard<std::mutex> lk(g_watchedWindowsMutex);
+            WatchedWindow& w = g_watchedWindows[hwnd];
+            if (w.pid == pid && w.createTime == m.createTime && w.affinity == rule->affinity)
+                continue;
+            w = { pid, m.createTime, rule->affinity };
+        }
+        // Already right (set by someone else, or before a restart): record only.
+        DWORD current = WDA_NONE;
+        if (GetWindowDisplayAffinity(hwnd, &current) && current == rule->affinity) continue;
+        targets[{ pid, rule->affinity }].push_back(hwnd);
+    }
+}
+
+// SubmitInject with the capture-leak check: when it is on and the affinity
+// hides something, the capture worker is asked to grab the windows
+// (CheckBefore) while the job runs, and the job's result goes back to it so
+// it can compare once the change is on screen (CheckAfter).  The injection
+// never waits for the worker: if the request cannot be queued (worker gone,
+// channel full or closed) only the check is skipped.  onDone runs as usual.
+static void SubmitInjectChecked(DWORD pid, std::vector<HWND> hwnds, DWORD affinity,
+                                bool autoUnload, InjectCallback onDone)
+{
+    bool check = false;
+    if (g_captureCheck.load() && g_captureWorkerUp.load() && affinity != WDA_NONE) {
+        CaptureEvent evt;
+        evt.type  = CaptureEventType::CheckBefore;
+        evt.hwnds = hwnds;
+        check = g_captureChannel.try_send(evt);
+    }
+    if (!check) {
+        SubmitInject(pid, std::move(hwnds), affinity, autoUnload, std::move(onDone));
+        return;
+    }
+    SubmitInject(pid, std::move(hwnds), affinity, autoUnload, [onDone](const InjectResult& r) {
+        if (onDone) onDone(r);
+        if (!g_hDlg) return;
+        CaptureEvent after;
+        after.type    = CaptureEventType::CheckAfter;
+        after.hwnds   = r.hwnds;
+        after.applied = r.ok;
+        g_captureChannel.send(std::move(after));
+    });
+}
 
-            // Enumerate all running process IDs.
-            DWORD pids[4096]; DWORD needed = 0;
-            if (!EnumProcesses(pids, sizeof(pids), &needed)) continue;
-            DWORD count = needed / sizeof(DWORD);
+// Apply the watch rules' affinities to every target on the inject pool
+// without blocking the caller.  Windows whose injection failed are dropped
+// from g_watchedWindows so their next event tries again; the others are
+// re-queried by the window model so their rows show the new state.  The last
+// job to finish posts WM_APP_WATCH_APPLIED with the number of processes.
+static void SubmitWatchInjections(WatchTargets targets)
+{
+    if (targets.empty()) return;
 
-            int applied = 0;
-            for (DWORD i = 0; i < count; ++i) {
-                DWORD pid = pids[i];
-                if (!pid) continue;
+    struct SweepState {
+        std::atomic<int> remaining{0};
+        std::mutex       mtx;
+        std::set<DWORD>  applied;   // PIDs with at least one window updated
+    };
+    auto sweep = std::make_shared<SweepState>();
+    sweep->remaining = static_cast<int>(targets.size());
 
-                // Skip already-injected PIDs.
+    for (auto& t : targets) {
+        SubmitInjectChecked(t.first.first, std::move(t.second), t.first.second, true,
+            [sweep](const InjectResult& r) {
+                std::vector<HWND> updated;
+                {
+                    std::lock_guard<std::mutex> lk(g_watchedWindowsMutex);
+                    for (size_t i = 0; i < r.hwnds.size(); ++i) {
+                        if (i < r.ok.size() && r.ok[i]) {
+                            updated.push_back(r.hwnds[i]);
+                            continue;
+                        }
+                        auto w = g_watchedWindows.find(r.hwnds[i]);
+                        if (w != g_watchedWindows.end() && w->second.pid == r.pid
+                            && w->second.affinity == r.affinity)
+                            g_watchedWindows.erase(w);
+                    }
+                }
+                // Outside the lock: send may wait for the injector thread,
+                // which takes g_watchedWindowsMutex itself.
+                for (HWND hwnd : updated) {
+                    // winEvent 0: refresh the row only.
+                    InjectorEvent evt{InjectorEventType::WindowEvent};
+                    evt.hwnd = hwnd;
+                    if (g_hDlg) g_injectorChannel.send(evt);
+                }
+                if (std::find(r.ok.begin(), r.ok.end(), true) != r.ok.end()) {
+                    std::lock_guard<std::mutex> lk(sweep->mtx);
+                    sweep->applied.insert(r.pid);
+                }
+                if (sweep->remaining.fetch_sub(1) != 1) return;
+                size_t applied;
                 {
-                    std::lock_guard<std::mutex> lk(g_watchedPidsMutex);
-                    if (g_watchedPids.count(pid)) continue;
+                    std::lock_guard<std::mutex> lk(sweep->mtx);
+                    applied = sweep->applied.size();
                 }
+                if (g_hDlg && applied > 0)
+                    PostMessage(g_hDlg, WM_APP_WATCH_APPLIED, static_cast<WPARAM>(applied), 0);
+            });
+    }
+}
 
-                // Check process name against the watch list.
-                std::wstring procName = GetProcessName(pid);
-                if (procName.empty() || procName == L"<unknown>") continue;
+// Hand a batch of window-model deltas to the UI thread.
+static void PublishWindowDeltas(std::vector<WindowDelta>& deltas)
+{
+    if (deltas.empty()) return;
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lk(g_pendingDeltasMutex);
+        wasEmpty = g_pendingDeltas.empty();
+        for (auto& d : deltas) g_pendingDeltas.push_back(std::move(d));
+    }
+    deltas.clear();
+    if (wasEmpty && g_hDlg)
+        PostMessage(g_hDlg, WM_APP_WINDOWS_READY, 0, 0);
+}
 
-                bool matched = false;
-                for (const auto& w : watchNames) {
-                    if (_wcsicmp(procName.c_str(), w.c_str()) == 0) { matched = true; break; }
-                }
-                if (!matched) continue;
-
-                // Find all visible, titled top-level windows for this PID.
-                struct FindCtx { DWORD pid; std::vector<HWND> hwnds; };
-                FindCtx ctx = { pid };
-                EnumWindows([](HWND hwnd, LPARAM lp) -> BOOL {
-                    auto* c = reinterpret_cast<FindCtx*>(lp);
-                    DWORD wpid = 0;
-                    GetWindowThreadProcessId(hwnd, &wpid);
-                    if (wpid == c->pid && IsWindowVisible(hwnd)) {
-                        wchar_t t[8] = {};
-                        GetWindowTextW(hwnd, t, 8);
-                        if (t[0]) c->hwnds.push_back(hwnd);
-                    }
-                    return TRUE;
-                }, reinterpret_cast<LPARAM>(&ctx));
+// Handle windows reported by the WinEvent hook: keep those that belong to a
+// watched process and have not been given their rule's affinity yet, then
+// inject per process (one batch per burst of events).  This covers every new
+// window of a process, not only its first ones, and does not wait for a title
+// unless the rule filters on it: excluding at EVENT_OBJECT_CREATE means the
+// window is never captured, not even for its first frames.  Title-filtered
+// rules are re-checked on EVENT_OBJECT_NAMECHANGE.
+static void ApplyWatchToNewWindows(std::vector<HWND> hwnds)
+{
+    std::shared_ptr<const WatchRuleSet> rules = CurrentWatchRuleSet();
+    if (!rules || rules->empty()) return;
+
+    std::sort(hwnds.begin(), hwnds.end());
+    hwnds.erase(std::unique(hwnds.begin(), hwnds.end()), hwnds.end());
+    hwnds.erase(std::remove_if(hwnds.begin(), hwnds.end(),
+                               [](HWND h) { return !IsWindow(h); }), hwnds.end());
+
+    WatchProcessMatches matches;
+    WatchTargets        targets;
+    SelectWatchTargets(*rules, hwnds, matches, targets);
+    SubmitWatchInjections(std::move(targets));
+}
+
+// Destroyed windows leave g_watchedWindows.
+static void ForgetWatchedWindows(const std::vector<HWND>& hwnds)
+{
+    std::lock_guard<std::mutex> lk(g_watchedWindowsMutex);
+    for (HWND hwnd : hwnds) g_watchedWindows.erase(hwnd);
+}
 
-                if (ctx.hwnds.empty()) continue; // process not ready yet; retry next tick
+// Full sweep (WatchCheck): give the visible, titled windows of watched
+// processes their rule's affinity where g_watchedWindows shows they lack it.
+// Runs at startup and after the rules change; from then on the WinEvent hook
+// keeps up with new windows, so there is no periodic sweep unless the hooks
+// could not be installed.
+static void RunWatchSweep()
+{
+    // Get a snapshot of the current compiled rules.
+    std::shared_ptr<const WatchRuleSet> rules = CurrentWatchRuleSet();
+    if (!rules || rules->empty()) return;
 
-                // Apply ExcludeFromCapture to each window of this process.
-                for (HWND hwnd : ctx.hwnds)
-                    InjectWDASetAffinity(hwnd, WDA_EXCLUDEFROMCAPTURE, true);
+    // Drop windows whose DESTROY event was missed.
+    {
+        std::lock_guard<std::mutex> lk(g_watchedWindowsMutex);
+        for (auto it = g_watchedWindows.begin(); it != g_watchedWindows.end(); )
+            it = IsWindow(it->first) ? std::next(it) : g_watchedWindows.erase(it);
+    }
 
-                // Mark PID as processed so we don't re-inject on subsequent ticks.
-                {
-                    std::lock_guard<std::mutex> lk(g_watchedPidsMutex);
-                    g_watchedPids.insert(pid);
+    // One snapshot of every process's PID + image name; no process
+    // is opened for non-matching names.
+    std::vector<ProcessEntry> procs;
+    if (!SnapshotProcesses(procs)) return;
+
+    WatchProcessMatches matches;   // matching PIDs only
+    {
+        WatchProcessMatch m;
+        for (const auto& pe : procs) {
+            MatchWatchedProcess(*rules, pe.pid, pe.imageName, m.rules);
+            if (m.rules.empty()) continue;
+            m.createTime = GetProcessInfo(pe.pid).createTime;
+            matches[pe.pid] = m;
+        }
+    }
+    if (matches.empty()) return;
+
+    // Find all visible, titled top-level windows of the matched PIDs
+    // in a single EnumWindows pass.
+    struct FindCtx {
+        const WatchProcessMatches* pids;
+        std::vector<HWND>          hwnds;
+    };
+    FindCtx ctx = { &matches };
+    EnumWindows([](HWND hwnd, LPARAM lp) -> BOOL {
+        auto* c = reinterpret_cast<FindCtx*>(lp);
+        DWORD wpid = 0;
+        GetWindowThreadProcessId(hwnd, &wpid);
+        if (c->pids->count(wpid) && IsWindowVisible(hwnd)) {
+            wchar_t t[8] = {};
+            InternalGetWindowText(hwnd, t, 8);   // sends no message
+            if (t[0]) c->hwnds.push_back(hwnd);
+        }
+        return TRUE;
+    }, reinterpret_cast<LPARAM>(&ctx));
+
+    WatchTargets targets;
+    SelectWatchTargets(*rules, ctx.hwnds, matches, targets);
+    SubmitWatchInjections(std::move(targets));
+}
+
+// ============================================================================
+// Injector worker thread
+// Handles InjectorEvent::Update (full resync) and WindowEvent (one WinEvent)
+// by updating the WindowModel and publishing its deltas via
+// WM_APP_WINDOWS_READY.  WatchCheck (full sweep) and the CREATE / SHOW /
+// NAMECHANGE window events apply watch rules.  While windows are pending (owner hung
+// during enumeration) they are re-queried every WINDOW_RETRY_INTERVAL_MS.
+// At startup StartupList replaces the first Update and Warmup follows it
+// once the dialog has been painted.  WinEvents dropped on a full channel
+// (g_injectorOverflow) are made up for by a resync and a watch sweep.
+// ============================================================================
+static void InjectorWorkerProc()
+{
+    WindowModel              model;
+    std::vector<WindowDelta> deltas;
+
+    InjectorEvent evt;
+    InjectorEvent deferred;             // non-window event pulled while draining
+    bool          hasDeferred = false;
+    ULONGLONG     nextRetry   = 0;      // when pending windows are next re-queried
+    while (true) {
+        if (hasDeferred) {
+            evt = deferred;
+            hasDeferred = false;
+        } else if (model.HasPending()) {
+            // Windows whose owner was hung (or that the budget did not reach)
+            // are filled in in the background while waiting for events.
+            ULONGLONG now = GetTickCount64();
+            if (!nextRetry) nextRetry = now + WINDOW_RETRY_INTERVAL_MS;
+            unsigned wait = (now < nextRetry) ? static_cast<unsigned>(nextRetry - now) : 0;
+            if (!g_injectorChannel.recv_timeout(evt, wait)) {
+                model.RetryPending(deltas);
+                PublishWindowDeltas(deltas);
+                nextRetry = GetTickCount64() + WINDOW_RETRY_INTERVAL_MS;
+                continue;
+            }
+        } else {
+            nextRetry = 0;
+            if (!g_injectorChannel.recv(evt)) break;
+        }
+        if (evt.type == InjectorEventType::Quit) break;
+
+        if (evt.type == InjectorEventType::Update) {
+            // Full enumeration: startup and the periodic consistency check.
+            model.Resync(deltas);
+            PublishWindowDeltas(deltas);
+        }
+        else if (evt.type == InjectorEventType::StartupList) {
+            // Titles and process names only: no WM_GETICON round trips, so
+            // the list is complete in milliseconds even while other programs
+            // are still starting.  The icons follow in Warmup.
+            model.Resync(deltas, 0);
+            PublishWindowDeltas(deltas);
+            if (g_hDlg) PostMessage(g_hDlg, WM_APP_WINDOWS_LISTED, 0, 0);
+        }
+        else if (evt.type == InjectorEventType::Warmup) {
+            // Background mode lowers CPU and I/O priority while the rest of
+            // the desktop is starting.
+            SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+            model.RetryPending(deltas);
+            PublishWindowDeltas(deltas);
+            RunWatchSweep();
+            SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+            nextRetry = 0;
+        }
+        else if (evt.type == InjectorEventType::WatchCheck) {
+            RunWatchSweep();
+        }
+        else if (evt.type == InjectorEventType::WindowEvent) {
+            // Windows usually change in bursts (CREATE + SHOW + NAMECHANGE, a
+            // main window plus its owned popups); take everything already
+            // queued so the UI gets one delta batch and each watched process
+            // one batched injection.
+            std::vector<HWND> appeared, destroyed;
+            InjectorEvent cur = evt;
+            // A title change can only make a window match a title-filtered rule.
+            std::shared_ptr<const WatchRuleSet> rules = CurrentWatchRuleSet();
+            const bool titlesMatter = rules && rules->HasTitleFilters();
+            while (true) {
+                model.Refresh(cur.hwnd, cur.winEvent, deltas);
+                if (cur.winEvent == EVENT_OBJECT_CREATE || cur.winEvent == EVENT_OBJECT_SHOW
+                    || (titlesMatter && cur.winEvent == EVENT_OBJECT_NAMECHANGE))
+                    appeared.push_back(cur.hwnd);
+                else if (cur.winEvent == EVENT_OBJECT_DESTROY)
+                    destroyed.push_back(cur.hwnd);
+
+                if (!g_injectorChannel.recv_timeout(cur, 0)) break;
+                if (cur.type != InjectorEventType::WindowEvent) {
+                    deferred    = cur;
+                    hasDeferred = true;
+                    break;
                 }
-                ++applied;
             }
+            PublishWindowDeltas(deltas);
+            if (!destroyed.empty())
+                ForgetWatchedWindows(destroyed);
+            if (!appeared.empty())
+                ApplyWatchToNewWindows(std::move(appeared));
+        }
 
-            if (g_hDlg && applied > 0)
-                PostMessage(g_hDlg, WM_APP_WATCH_APPLIED, static_cast<WPARAM>(applied), 0);
+        // The ring was full when the flag was set, so this runs after at
+        // least the event that made room; later drops set it again.
+        if (g_injectorOverflow.exchange(false)) {
+            model.Resync(deltas);
+            PublishWindowDeltas(deltas);
+            RunWatchSweep();
         }
     }
 }
 
+// ============================================================================
+// WinEvent hooks (UI thread)
+// WINEVENT_OUTOFCONTEXT callbacks are delivered through this thread's message
+// loop, so the callback only filters and forwards; the window model, process
+// lookups and injection all live on the injector thread / inject pool.
+// ============================================================================
+static void CALLBACK WindowWinEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd,
+                                        LONG idObject, LONG idChild, DWORD, DWORD)
+{
+    if (!hwnd || idObject != OBJID_WINDOW || idChild != CHILDID_SELF) return;
+    // Top-level windows only.  A destroyed window can no longer be asked for
+    // its ancestor; the model simply ignores HWNDs it does not list.
+    if (event != EVENT_OBJECT_DESTROY && GetAncestor(hwnd, GA_ROOT) != hwnd) return;
+
+    InjectorEvent evt{InjectorEventType::WindowEvent};
+    evt.hwnd     = hwnd;
+    evt.winEvent = event;
+    // Never wait here (see g_injectorOverflow): a full ring means a resync.
+    if (!g_injectorChannel.try_send(evt))
+        g_injectorOverflow.store(true);
+}
+
+// Install the hooks (CREATE / DESTROY / SHOW / HIDE and NAMECHANGE; the
+// events in between, e.g. LOCATIONCHANGE, are far too chatty to subscribe to).
+// Returns false if either is missing; the IDT_WINDOW_RESYNC sweep and the
+// then-enabled IDT_WATCH sweep still keep the list and the watch rules
+// applied, just less promptly.
+static bool InstallWinEventHooks()
+{
+    const DWORD flags = WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS;
+    g_winEventHooks[0] = SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_HIDE,
+                                         nullptr, WindowWinEventProc, 0, 0, flags);
+    g_winEventHooks[1] = SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE,
+                                         nullptr, WindowWinEventProc, 0, 0, flags);
+    return g_winEventHooks[0] && g_winEventHooks[1];
+}
+
+static void RemoveWinEventHooks()
+{
+    for (auto& h : g_winEventHooks)
+        if (h) { UnhookWinEvent(h); h = nullptr; }
+}
+
+// Call after every change to g_watchRules: recompiles g_watchRuleSet.  The
+// rules are copied and compiled outside the lock; matchers keep using the
+// previous set until the new one is swapped in.  g_watchedWindows is kept:
+// the next sweep injects only windows whose rule now wants another affinity.
+static void OnWatchListChanged()
+{
+    std::vector<WatchRule> rules;
+    {
+        std::lock_guard<std::mutex> lk(g_watchRulesMutex);
+        rules = g_watchRules;
+    }
+    auto set = std::make_shared<const WatchRuleSet>(std::move(rules));
+    std::lock_guard<std::mutex> lk(g_watchRulesMutex);
+    g_watchRuleSet = std::move(set);
+}
+
+// Append a row for rule to the watch list view.
+static void InsertWatchListRow(HWND hList, const WatchRule& rule)
+{
+    std::wstring text = WatchRuleToText(rule);
+    LVITEMW lvi = {};
+    lvi.mask    = LVIF_TEXT;
+    lvi.iItem   = ListView_GetItemCount(hList);
+    lvi.pszText = const_cast<LPWSTR>(text.c_str());
+    ListView_InsertItem(hList, &lvi);
+}
+
 // ============================================================================
 // Capture worker thread
-// Implements a continuous BitBlt capture loop, analogous to Invisiwind's
+// Implements a continuous capture loop, analogous to Invisiwind's
 // ScreenCapture::start_free_threaded streaming model:
 //   • CaptureEvent::Capture  → enter/restart continuous capture for the given rect
 //   • CaptureEvent::StopCapture → exit continuous capture, discard pending bitmap
+//   • CaptureEvent::CheckBefore / CheckAfter → capture-leak check, see below
 //   • CaptureEvent::Quit     → terminate thread
 //
-// While capturing, a frame is taken every ~200 ms (≈5 fps) and posted to the
-// UI thread via WM_APP_PREVIEW_READY; the cursor overlay is drawn when
-// g_captureShowCursor is set.  Between frames the thread waits on the channel
-// so that a new event (monitor switch, stop, quit) is acted on immediately.
+// Frames come from DXGI Desktop Duplication when the monitor supports it
+// (GPU-downscaled, dirty rects tell whether anything was redrawn) and from
+// BitBlt otherwise (tile hashes tell, at most ~5 fps).  Only changed frames
+// are posted to the UI thread via WM_APP_PREVIEW_READY; the cursor overlay is
+// drawn when g_captureShowCursor is set.  The interval is adaptive: it drops
+// to 1 / g_previewMaxFps as soon as a frame changes and grows by half per
+// unchanged frame up to 1 / g_previewMinFps, so an idle desktop costs about
+// one cheap check per second.  Between frames the thread waits on the
+// channel so that a new event (monitor switch, stop, quit) is acted on
+// immediately.
+//
+// With the thumbnail strip on, the same pass also keeps one thumbnail per
+// monitor current and posts the strip via WM_APP_STRIP_READY.  Each output is
+// duplicated once and read back at the mip level nearest its thumbnail, so
+// the cost follows the thumbnail pixels rather than the monitors' size; a
+// monitor switch hands the new monitor's duplication to the preview instead
+// of reopening one.
 // ============================================================================
+static const unsigned CAPTURE_INTERVAL_GDI_MS  = 200;   // fastest BitBlt rate
+static const ULONGLONG CAPTURE_DXGI_RETRY_MS   = 2000;  // after duplication was lost
+static const unsigned CAPTURE_STRIP_INTERVAL_MS = 250;  // thumbnails of the other monitors
+static const unsigned PREVIEW_FPS_LIMIT        = 60;    // clamp for the registry values
+
+// Largest rectangle with the aspect ratio of `mon` that fits in `box`
+// (letterboxing).  Frames are rendered at exactly this size.
+static SIZE FitPreview(const RECT& mon, SIZE box)
+{
+    int sw = mon.right - mon.left, sh = mon.bottom - mon.top;
+    if (sw <= 0 || sh <= 0 || box.cx <= 0 || box.cy <= 0) return SIZE{ 0, 0 };
+    SIZE fit = { box.cx, MulDiv(box.cx, sh, sw) };
+    if (fit.cy > box.cy)
+        fit = { MulDiv(box.cy, sw, sh), box.cy };
+    return fit;
+}
+
+// Thumbnail strip layout: `count` equal cells left to right across `strip`,
+// STRIP_GAP pixels apart.  Each monitor's thumbnail is FitPreview of its cell,
+// centred in it.  The worker renders with these and the UI thread hit-tests
+// and highlights with them, so both always agree.
+static const int STRIP_GAP = 4;
+
+static RECT StripCell(int index, int count, SIZE strip)
+{
+    if (count <= 0) return RECT{};
+    int cellW = (std::max)(0, (strip.cx - (count - 1) * STRIP_GAP) / count);
+    int left  = index * (cellW + STRIP_GAP);
+    return RECT{ left, 0, left + cellW, strip.cy };
+}
+
+static RECT StripThumbRect(const RECT& mon, const RECT& cell)
+{
+    SIZE fit = FitPreview(mon, SIZE{ cell.right - cell.left, cell.bottom - cell.top });
+    int  x   = cell.left + (cell.right - cell.left - fit.cx) / 2;
+    int  y   = cell.top  + (cell.bottom - cell.top - fit.cy) / 2;
+    return RECT{ x, y, x + fit.cx, y + fit.cy };
+}
+
+// Hand a finished image to the UI thread through `slot`, replacing any
+// unconsumed one (bounded-1 behaviour).  An image that displaced another is
+// covered by the `msg` already posted for it, so at most one is in flight.
+static void PostFrame(LatestSlot<PooledDib>& slot, DibPool& pool, UINT msg, PooledDib* frame)
+{
+    PooledDib* discarded = slot.publish(frame);
+    if (discarded) {
+        pool.Release(discarded);
+        return;
+    }
+    if (!g_hDlg || !PostMessage(g_hDlg, msg, 0, 0))
+        pool.Release(slot.take());
+}
+
+static void PostPreviewFrame(PooledDib* frame)
+{
+    PostFrame(g_pendingPreview, g_previewPool, WM_APP_PREVIEW_READY, frame);
+}
+
+// Drop the frame shown in the preview (UI thread).
+static void ClearPreviewFrame()
+{
+    g_previewPool.Release(g_previewFrame);
+    g_previewFrame = nullptr;
+}
+
+// Drop the thumbnail strip shown in IDC_MONITOR_STRIP (UI thread).
+static void ClearStripFrame()
+{
+    g_stripPool.Release(g_stripFrame);
+    g_stripFrame = nullptr;
+}
+
+// Draw the cursor onto a frame of monitor `mon` scaled to frameW × frameH.
+static void DrawCursorOverlay(HDC hdc, const RECT& mon, int frameW, int frameH)
+{
+    CURSORINFO ci = {};
+    ci.cbSize = sizeof(ci);
+    if (!GetCursorInfo(&ci) || !(ci.flags & CURSOR_SHOWING) || !ci.hCursor)
+        return;
+    int monW = mon.right - mon.left, monH = mon.bottom - mon.top;
+    if (monW <= 0 || monH <= 0) return;
+    int x  = MulDiv(ci.ptScreenPos.x - mon.left, frameW, monW);
+    int y  = MulDiv(ci.ptScreenPos.y - mon.top,  frameH, monH);
+    int cx = (std::max)(MulDiv(GetSystemMetrics(SM_CXCURSOR), frameW, monW), 8);
+    int cy = (std::max)(MulDiv(GetSystemMetrics(SM_CYCURSOR), frameH, monH), 8);
+    DrawIconEx(hdc, x, y, ci.hCursor, (frameW == monW) ? 0 : cx,
+               (frameH == monH) ? 0 : cy, 0, nullptr, DI_NORMAL);
+}
+
+// Scale a top-down BGRA image into rectangle `r` of `frame` on this thread
+// (SIMD, see downscale.h).  GDI may still be drawing into the DIB (last
+// cursor overlay, a thumbnail StretchBlt), hence the flush before touching
+// its bits.
+static void ScaleIntoRect(const void* pixels, int w, int h, const PooledDib& frame, const RECT& r)
+{
+    int rw = r.right - r.left, rh = r.bottom - r.top;
+    if (w <= 0 || h <= 0 || rw <= 0 || rh <= 0) return;
+    GdiFlush();
+    const size_t stride = static_cast<size_t>(frame.width) * 4;
+    DownscaleBGRA(static_cast<const uint8_t*>(pixels), w, h, static_cast<size_t>(w) * 4,
+                  static_cast<uint8_t*>(frame.bits) + r.top * stride + r.left * 4, rw, rh,
+                  stride);
+}
+
+static void ScaleIntoFrame(const void* pixels, int w, int h, const PooledDib& frame)
+{
+    ScaleIntoRect(pixels, w, h, frame, RECT{ 0, 0, frame.width, frame.height });
+}
+
+// ----------------------------------------------------------------------------
+// Capture-leak check (g_captureCheck)
+//
+// A window is grabbed the way a screen capture sees it (the screen DC with
+// CAPTUREBLT, which leaves out windows excluded from capture) just before its
+// new affinity is applied, and again CAPTURE_CHECK_SETTLE_MS after the
+// injection reported success.  A window that really left the capture shows
+// whatever is behind it (or black, for WDA_MONITOR) the second time, so most
+// of its tiles differ; one whose content is still captured gives the same
+// pixels again.  Tiles covered by windows above it are left out, and a window
+// that moved, resized or was minimised in between gets no verdict.
+// ----------------------------------------------------------------------------
+static const ULONGLONG CAPTURE_CHECK_SETTLE_MS    = 150;    // DWM recomposes after the job
+static const ULONGLONG CAPTURE_CHECK_EXPIRE_MS    = 15000;  // CheckAfter never came
+static const int       CAPTURE_CHECK_MAX_SIDE     = 512;    // grabs are scaled down to fit
+static const size_t    CAPTURE_CHECK_MAX_PENDING  = 32;     // per batch of windows (watch sweeps)
+static const size_t    CAPTURE_CHECK_MIN_TILES    = 4;      // fewer to compare: inconclusive
+static const size_t    CAPTURE_CHECK_CHANGED_PCT  = 25;     // fewer tiles changed: still visible
+
+struct CaptureGrab {
+    RECT                 rect   = {};   // on screen, physical pixels, clipped to its monitor
+    int                  width  = 0;    // grab size (rect scaled to CAPTURE_CHECK_MAX_SIDE)
+    int                  height = 0;
+    std::vector<uint8_t> pixels;        // top-down BGRA, width * 4 bytes per row
+    std::vector<uint8_t> skip;          // per tile (tile_diff.h): covered by a window above
+};
+
+// Screen area of a window as a capture would show it, or false if it is not
+// on screen (hidden, cloaked, minimised).  Call with per-monitor DPI awareness.
+static bool CaptureCheckRect(HWND hwnd, RECT& out)
+{
+    if (!IsWindow(hwnd) || !IsWindowVisible(hwnd) || IsIconic(hwnd)) return false;
+    BOOL cloaked = FALSE;
+    if (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked)
+        return false;
+    RECT r;
+    if (FAILED(DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &r, sizeof(r)))
+        && !GetWindowRect(hwnd, &r))
+        return false;
+    MONITORINFO mi = {};
+    mi.cbSize = sizeof(mi);
+    if (!GetMonitorInfoW(MonitorFromRect(&r, MONITOR_DEFAULTTONEAREST), &mi)) return false;
+    return IntersectRect(&out, &r, &mi.rcMonitor) != FALSE;
+}
+
+// Fill g.skip: tiles of the grab that a window above hwnd covers show the
+// same pixels whatever happens to hwnd.  Windows that are not in captures
+// themselves, and click-through overlays, do not count.
+static void MarkCoveredTiles(HWND hwnd, CaptureGrab& g)
+{
+    const int cols = TileDiffCols(g.width), rows = TileDiffRows(g.height);
+    const int rw   = g.rect.right - g.rect.left, rh = g.rect.bottom - g.rect.top;
+    g.skip.assign(static_cast<size_t>(cols) * rows, 0);
+    for (HWND above = GetWindow(hwnd, GW_HWNDPREV); above; above = GetWindow(above, GW_HWNDPREV)) {
+        DWORD affinity = WDA_NONE;
+        if (GetWindowDisplayAffinity(above, &affinity) && affinity != WDA_NONE) continue;
+        const LONG_PTR ex = GetWindowLongPtrW(above, GWL_EXSTYLE);
+        if ((ex & (WS_EX_LAYERED | WS_EX_TRANSPARENT)) == (WS_EX_LAYERED | WS_EX_TRANSPARENT))
+            continue;
+        RECT r, o;
+        if (!CaptureCheckRect(above, r) || !IntersectRect(&o, &r, &g.rect)) continue;
+        // In grab pixels, rounded outwards to whole tiles.
+        const int x0 = MulDiv(o.left - g.rect.left, g.width,  rw) / TILE_DIFF_SIZE;
+        const int y0 = MulDiv(o.top  - g.rect.top,  g.height, rh) / TILE_DIFF_SIZE;
+        const int x1 = (std::min)(cols, (MulDiv(o.right  - g.rect.left, g.width,  rw)
+                                         + TILE_DIFF_SIZE - 1) / TILE_DIFF_SIZE);
+        const int y1 = (std::min)(rows, (MulDiv(o.bottom - g.rect.top,  g.height, rh)
+                                         + TILE_DIFF_SIZE - 1) / TILE_DIFF_SIZE);
+        for (int y = y0; y < y1; ++y)
+            memset(&g.skip[static_cast<size_t>(y) * cols + x0], 1, static_cast<size_t>(x1 - x0));
+    }
+}
+
+// Grab g.rect from the screen into g.pixels, scaled down (COLORONCOLOR, one
+// screen pixel per grab pixel) to fit CAPTURE_CHECK_MAX_SIDE.  `copy` keeps
+// the DIB between grabs of the same size.
+static bool GrabCaptureArea(HDC hFrameDC, DibPool& copy, CaptureGrab& g)
+{
+    const int rw = g.rect.right - g.rect.left, rh = g.rect.bottom - g.rect.top;
+    if (rw <= 0 || rh <= 0) return false;
+    g.width  = rw;
+    g.height = rh;
+    if (rw > CAPTURE_CHECK_MAX_SIDE || rh > CAPTURE_CHECK_MAX_SIDE) {
+        if (rw >= rh) {
+            g.width  = CAPTURE_CHECK_MAX_SIDE;
+            g.height = (std::max)(1, MulDiv(rh, CAPTURE_CHECK_MAX_SIDE, rw));
+        } else {
+            g.height = CAPTURE_CHECK_MAX_SIDE;
+            g.width  = (std::max)(1, MulDiv(rw, CAPTURE_CHECK_MAX_SIDE, rh));
+        }
+    }
+    copy.Resize(g.width, g.height);
+    PooledDib* dib = copy.Acquire();
+    if (!dib) return false;
+
+    HDC     hScreen = GetDC(nullptr);
+    HGDIOBJ old     = SelectObject(hFrameDC, dib->bmp);
+    SetStretchBltMode(hFrameDC, COLORONCOLOR);
+    BOOL ok = StretchBlt(hFrameDC, 0, 0, g.width, g.height, hScreen,
+                         g.rect.left, g.rect.top, rw, rh, SRCCOPY | CAPTUREBLT);
+    SelectObject(hFrameDC, old);
+    ReleaseDC(nullptr, hScreen);
+    GdiFlush();
+    if (ok) {
+        const uint8_t* bits = static_cast<const uint8_t*>(dib->bits);
+        g.pixels.assign(bits, bits + static_cast<size_t>(g.width) * g.height * 4);
+    }
+    copy.Release(dib);
+    return ok != FALSE;
+}
+
+// Second half of a check: grab hwnd again and compare with `before`.
+static CaptureCheck FinishCaptureCheck(HDC hFrameDC, DibPool& copy, HWND hwnd,
+                                       const CaptureGrab& before)
+{
+    CaptureGrab after;
+    if (!CaptureCheckRect(hwnd, after.rect) || !EqualRect(&after.rect, &before.rect)
+        || !GrabCaptureArea(hFrameDC, copy, after))
+        return CaptureCheck::Inconclusive;
+    MarkCoveredTiles(hwnd, after);
+
+    std::vector<uint8_t> skip(before.skip);
+    size_t compared = 0;
+    for (size_t i = 0; i < skip.size(); ++i) {
+        skip[i] |= after.skip[i];
+        if (!skip[i]) ++compared;
+    }
+    if (compared < CAPTURE_CHECK_MIN_TILES) return CaptureCheck::Inconclusive;
+
+    size_t changed = CountDifferentTiles(before.pixels.data(), after.pixels.data(),
+                                         after.width, after.height,
+                                         static_cast<size_t>(after.width) * 4,
+                                         TILE_DIFF_THRESHOLD, skip.data());
+    return (changed * 100 < compared * CAPTURE_CHECK_CHANGED_PCT) ? CaptureCheck::Visible
+                                                                  : CaptureCheck::Absent;
+}
+
 static void CaptureWorkerProc()
 {
     bool capturing  = false;
     RECT activeRect = {};
+    SIZE previewSize = {};
+    unsigned frameTag = 0;
+
+    // Held through a pointer so that a monitor switch can trade it with the
+    // strip's duplication of the new monitor (see the Capture event).
+    std::unique_ptr<DxgiCapture> dxgi = std::make_unique<DxgiCapture>();
+    ULONGLONG   dxgiRetryAt = 0;       // next Open attempt; 0 = try now
+    POINT       lastCursor  = { LONG_MIN, LONG_MIN };
+
+    // Every frame is drawn through this DC into a pooled preview-size DIB.
+    HDC hFrameDC = CreateCompatibleDC(nullptr);
+
+    // BitBlt path: monitor-size DIB the screen is copied into before the SIMD
+    // downscale; reallocated only when the monitor changes.
+    DibPool screenCopy(1);
+
+    // BitBlt path: per-tile hashes of the last screen copy.
+    TileHasher tiles;
+
+    // Thumbnail strip: the composed strip lives in `canvas` and a copy is
+    // posted whenever a thumbnail in it changed.  The active monitor's
+    // thumbnail is scaled from its preview frame; every other monitor has a
+    // duplication of its own, read back at the mip level nearest the
+    // thumbnail, or a COLORONCOLOR StretchBlt that samples one screen pixel
+    // per thumbnail pixel.  strip[i] is Capture's stripMonitors[i].
+    struct StripSource {
+        RECT                         rect    = {};
+        RECT                         thumb   = {};   // position in the strip
+        std::unique_ptr<DxgiCapture> dxgi    = std::make_unique<DxgiCapture>();
+        ULONGLONG                    retryAt = 0;
+        TileHasher                   tiles;          // BitBlt fallback
+        bool                         stale   = true; // cell not drawn since (re)layout
+    };
+    std::vector<StripSource> strip;
+    SIZE       stripSize   = {};
+    int        stripActive = -1;     // index of activeRect in strip, -1 if none
+    DibPool    stripCanvas(1);
+    PooledDib* canvas      = nullptr;
+    bool       stripDirty  = false;  // canvas differs from the last posted strip
+    bool       activeStale = false;  // active monitor's cell predates the last Capture
+    ULONGLONG  stripDueAt  = 0;
+
+    auto findStrip = [&](const RECT& rect) -> int {
+        for (size_t i = 0; i < strip.size(); ++i)
+            if (EqualRect(&strip[i].rect, &rect)) return static_cast<int>(i);
+        return -1;
+    };
 
-    auto takeFrame = [&]() {
-        int w = activeRect.right - activeRect.left;
-        int h = activeRect.bottom - activeRect.top;
-        if (w <= 0 || h <= 0) return;
+    // Rebuild the strip for a new monitor list or strip size.  Sources of
+    // monitors still present keep their open duplication.
+    auto configureStrip = [&](const CaptureEvent& e) {
+        bool same = e.stripSize.cx == stripSize.cx && e.stripSize.cy == stripSize.cy
+                 && e.stripMonitors.size() == strip.size();
+        for (size_t i = 0; same && i < strip.size(); ++i)
+            same = EqualRect(&strip[i].rect, &e.stripMonitors[i]) != FALSE;
+        if (same) return;
+
+        std::vector<StripSource> next(e.stripMonitors.size());
+        const int count = static_cast<int>(next.size());
+        for (int i = 0; i < count; ++i) {
+            next[i].rect  = e.stripMonitors[i];
+            next[i].thumb = StripThumbRect(next[i].rect, StripCell(i, count, e.stripSize));
+            int old = findStrip(next[i].rect);
+            if (old >= 0) {
+                next[i].dxgi    = std::move(strip[old].dxgi);
+                next[i].retryAt = strip[old].retryAt;
+            }
+        }
+        strip     = std::move(next);
+        stripSize = strip.empty() ? SIZE{} : e.stripSize;
+
+        stripCanvas.Release(canvas);
+        stripCanvas.Resize(stripSize.cx, stripSize.cy);
+        g_stripPool.Resize(stripSize.cx, stripSize.cy);
+        canvas = stripCanvas.Acquire();
+        if (canvas)
+            memset(canvas->bits, 0, static_cast<size_t>(canvas->width) * canvas->height * 4);
+        stripDirty = false;
+        stripDueAt = 0;
+    };
 
-        // Set per-monitor DPI awareness so GetDC(nullptr) and BitBlt use
-        // physical pixel coordinates.  These match the physical rects stored
-        // in g_monitors by EnumerateMonitors (which uses the same context),
-        // fixing partial-capture on monitors with a non-100% scale factor.
+    // The active monitor's thumbnail, from the image its preview frame is
+    // (or would be) scaled from.
+    auto scaleActiveThumb = [&](const void* pixels, int w, int h) {
+        if (stripActive < 0 || !canvas) return;
+        ScaleIntoRect(pixels, w, h, *canvas, strip[stripActive].thumb);
+        stripDirty  = true;
+        activeStale = false;
+    };
+
+    // Refresh the other monitors' thumbnails (at most every
+    // CAPTURE_STRIP_INTERVAL_MS) and post the strip if anything changed.
+    // Returns true if a strip was posted.
+    auto updateStrip = [&]() -> bool {
+        if (!canvas) return false;
+        ULONGLONG now = GetTickCount64();
+        if (now >= stripDueAt) {
+            stripDueAt = now + CAPTURE_STRIP_INTERVAL_MS;
+            HDC hScreen = nullptr;
+            for (int i = 0; i < static_cast<int>(strip.size()); ++i) {
+                if (i == stripActive) continue;
+                StripSource& src = strip[i];
+                int tw = src.thumb.right - src.thumb.left;
+                int th = src.thumb.bottom - src.thumb.top;
+                if (tw <= 0 || th <= 0) continue;
+
+                if (!src.dxgi->IsOpen() && now >= src.retryAt && !src.dxgi->Open(src.rect))
+                    src.retryAt = now + CAPTURE_DXGI_RETRY_MS;
+                if (src.dxgi->IsOpen()) {
+                    DxgiCapture::Frame f = src.dxgi->Capture(tw, th);
+                    if (src.dxgi->Width() && (f == DxgiCapture::Frame::Updated || src.stale)) {
+                        ScaleIntoRect(src.dxgi->Pixels(), src.dxgi->Width(), src.dxgi->Height(),
+                                      *canvas, src.thumb);
+                        src.stale  = false;
+                        stripDirty = true;
+                    }
+                    if (f != DxgiCapture::Frame::Failed) continue;
+                    src.dxgi->Close();
+                    src.tiles.Reset();
+                    src.retryAt = now + CAPTURE_DXGI_RETRY_MS;
+                }
+
+                if (!hScreen) hScreen = GetDC(nullptr);
+                HGDIOBJ old = SelectObject(hFrameDC, canvas->bmp);
+                SetStretchBltMode(hFrameDC, COLORONCOLOR);
+                StretchBlt(hFrameDC, src.thumb.left, src.thumb.top, tw, th, hScreen,
+                           src.rect.left, src.rect.top, src.rect.right - src.rect.left,
+                           src.rect.bottom - src.rect.top, SRCCOPY | CAPTUREBLT);
+                SelectObject(hFrameDC, old);
+                GdiFlush();
+                const size_t stride = static_cast<size_t>(canvas->width) * 4;
+                const uint8_t* cell = static_cast<const uint8_t*>(canvas->bits)
+                                    + src.thumb.top * stride + src.thumb.left * 4;
+                if (src.tiles.Update(cell, tw, th, stride) != 0 || src.stale)
+                    stripDirty = true;
+                src.stale = false;
+            }
+            if (hScreen) ReleaseDC(nullptr, hScreen);
+        }
+        if (!stripDirty) return false;
+
+        // Every pooled strip in use: the UI thread is behind, retry next tick.
+        PooledDib* out = g_stripPool.Acquire();
+        if (!out) return false;
+        GdiFlush();
+        memcpy(out->bits, canvas->bits, static_cast<size_t>(canvas->width) * canvas->height * 4);
+        stripDirty = false;
+        PostFrame(g_pendingStrip, g_stripPool, WM_APP_STRIP_READY, out);
+        return true;
+    };
+
+    auto stopStrip = [&]() {
+        strip.clear();   // closes every thumbnail duplication
+        stripSize   = {};
+        stripActive = -1;
+        stripCanvas.Release(canvas);
+        canvas = nullptr;
+        stripCanvas.Resize(0, 0);
+        g_stripPool.Release(g_pendingStrip.take());
+    };
+
+    // Capture-leak checks waiting for their second grab, see
+    // FinishCaptureCheck.  dueAt stays 0 until CheckAfter says the job is done.
+    struct PendingCheck {
+        CaptureGrab before;
+        ULONGLONG   dueAt     = 0;
+        ULONGLONG   expiresAt = 0;
+    };
+    std::unordered_map<HWND, PendingCheck> checks;
+    DibPool checkCopy(1);
+
+    auto postCheck = [](HWND hwnd, CaptureCheck state) {
+        if (g_hDlg)
+            PostMessage(g_hDlg, WM_APP_CAPTURE_CHECKED, reinterpret_cast<WPARAM>(hwnd),
+                        static_cast<LPARAM>(state));
+    };
+
+    // First grab of each window about to be hidden.  The injection runs in
+    // parallel, so a window whose affinity is already set (by this job or
+    // anyone else – nothing to compare against) is not checked, and neither
+    // is one that is not on screen.  The affinity is read again after the
+    // grab: if the job got there first, the grab may already miss the window.
+    auto checkBefore = [&](const CaptureEvent& e) {
         DPI_AWARENESS_CONTEXT prevCtx = nullptr;
         auto pfnSetDpi = GetSetThreadDpiAwarenessFn();
         if (pfnSetDpi)
             prevCtx = pfnSetDpi(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+        const ULONGLONG now = GetTickCount64();
+        size_t started = 0;
+        for (HWND hwnd : e.hwnds) {
+            if (started == CAPTURE_CHECK_MAX_PENDING) break;
+            DWORD affinity = WDA_NONE;
+            if (!GetWindowDisplayAffinity(hwnd, &affinity) || affinity != WDA_NONE) continue;
+            ScopedStat timer(Stat::CaptureCheck);
+            PendingCheck pc;
+            if (!CaptureCheckRect(hwnd, pc.before.rect)
+                || !GrabCaptureArea(hFrameDC, checkCopy, pc.before))
+                continue;
+            if (!GetWindowDisplayAffinity(hwnd, &affinity) || affinity != WDA_NONE) continue;
+            MarkCoveredTiles(hwnd, pc.before);
+            pc.expiresAt = now + CAPTURE_CHECK_EXPIRE_MS;
+            checks[hwnd] = std::move(pc);
+            postCheck(hwnd, CaptureCheck::Pending);
+            ++started;
+        }
+        if (pfnSetDpi)
+            pfnSetDpi(prevCtx);
+    };
 
-        HDC     hScreen = GetDC(nullptr);
-        HDC     hMem    = CreateCompatibleDC(hScreen);
-        HBITMAP hBmp    = CreateCompatibleBitmap(hScreen, w, h);
-        HGDIOBJ old     = SelectObject(hMem, hBmp);
-        BitBlt(hMem, 0, 0, w, h, hScreen, activeRect.left, activeRect.top, SRCCOPY | CAPTUREBLT);
+    // The job finished: compare once DWM has shown the change, or drop the
+    // check if the affinity could not be set.  Windows without a pending
+    // check (skipped by checkBefore, or its request never got queued) are
+    // ignored.
+    auto checkAfter = [&](const CaptureEvent& e) {
+        const ULONGLONG now = GetTickCount64();
+        for (size_t i = 0; i < e.hwnds.size(); ++i) {
+            auto it = checks.find(e.hwnds[i]);
+            if (it == checks.end()) continue;
+            if (i < e.applied.size() && e.applied[i]) {
+                it->second.dueAt = now + CAPTURE_CHECK_SETTLE_MS;
+            } else {
+                checks.erase(it);
+                postCheck(e.hwnds[i], CaptureCheck::None);
+            }
+        }
+    };
 
-        if (g_captureShowCursor.load()) {
-            CURSORINFO ci = {};
-            ci.cbSize = sizeof(ci);
-            if (GetCursorInfo(&ci) && (ci.flags & CURSOR_SHOWING) && ci.hCursor) {
-                DrawIconEx(hMem,
-                    ci.ptScreenPos.x - activeRect.left,
-                    ci.ptScreenPos.y - activeRect.top,
-                    ci.hCursor, 0, 0, 0, nullptr, DI_NORMAL);
+    // Finish the checks that are due.  Returns the time until the next one
+    // is, in ms, or INFINITE.
+    auto runChecks = [&]() -> unsigned {
+        if (checks.empty()) return INFINITE;
+        DPI_AWARENESS_CONTEXT prevCtx = nullptr;
+        auto pfnSetDpi = GetSetThreadDpiAwarenessFn();
+        if (pfnSetDpi)
+            prevCtx = pfnSetDpi(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+        const ULONGLONG now  = GetTickCount64();
+        ULONGLONG       next = ULLONG_MAX;
+        for (auto it = checks.begin(); it != checks.end(); ) {
+            const PendingCheck& pc = it->second;
+            const ULONGLONG at = pc.dueAt ? pc.dueAt : pc.expiresAt;
+            if (now < at) {
+                next = (std::min)(next, at);
+                ++it;
+                continue;
+            }
+            CaptureCheck state = CaptureCheck::None;   // expired: the job never reported
+            if (pc.dueAt) {
+                ScopedStat timer(Stat::CaptureCheck);
+                state = FinishCaptureCheck(hFrameDC, checkCopy, it->first, pc.before);
+            }
+            postCheck(it->first, state);
+            it = checks.erase(it);
+        }
+        if (checks.empty()) checkCopy.Resize(0, 0);
+        if (pfnSetDpi)
+            pfnSetDpi(prevCtx);
+        return (next == ULLONG_MAX) ? INFINITE : static_cast<unsigned>(next - now);
+    };
+
+    // The cursor overlay is redrawn (even on an unchanged image) when the
+    // cursor moved since the last posted frame.
+    POINT cursor      = { LONG_MIN, LONG_MIN };
+    bool  cursorMoved = false;
+
+    // DXGI path: returns false if this frame must come from BitBlt instead.
+    // `frame` is posted (true + consumed) or left for the caller.
+    auto takeDxgiFrame = [&](PooledDib*& frame) -> bool {
+        if (!dxgi->IsOpen()) {
+            if (GetTickCount64() < dxgiRetryAt) return false;
+            if (!dxgi->Open(activeRect)) {
+                dxgiRetryAt = GetTickCount64() + CAPTURE_DXGI_RETRY_MS;
+                return false;
             }
         }
+        DxgiCapture::Frame f = dxgi->Capture(frame->width, frame->height);
+        if (f == DxgiCapture::Frame::Failed) {
+            // Mode change, secure desktop, ...: BitBlt until it can be reopened.
+            dxgi->Close();
+            tiles.Reset();   // the shown frame is not the last BitBlt one
+            dxgiRetryAt = GetTickCount64() + CAPTURE_DXGI_RETRY_MS;
+            return false;
+        }
+
+        if (dxgi->Width() && (f == DxgiCapture::Frame::Updated || activeStale))
+            scaleActiveThumb(dxgi->Pixels(), dxgi->Width(), dxgi->Height());
+        if (f == DxgiCapture::Frame::Unchanged && (!cursorMoved || !dxgi->Width()))
+            return true;   // nothing new to show
+
+        lastCursor = cursor;
+        ScaleIntoFrame(dxgi->Pixels(), dxgi->Width(), dxgi->Height(), *frame);
+        if (g_captureShowCursor.load()) {
+            HGDIOBJ old = SelectObject(hFrameDC, frame->bmp);
+            DrawCursorOverlay(hFrameDC, activeRect, frame->width, frame->height);
+            SelectObject(hFrameDC, old);
+        }
+        frame->tag = frameTag;
+        PostPreviewFrame(frame);
+        frame = nullptr;
+        return true;
+    };
+
+    // Returns true if a new frame (preview or strip) was posted.
+    auto takeFrame = [&]() -> bool {
+        ScopedStat timer(Stat::CaptureFrame);
+        int w = activeRect.right - activeRect.left;
+        int h = activeRect.bottom - activeRect.top;
+        if (w <= 0 || h <= 0) return false;
 
-        SelectObject(hMem, old);
-        DeleteDC(hMem);
-        ReleaseDC(nullptr, hScreen);
+        // Every pooled DIB in use: the UI thread is behind, skip this tick.
+        PooledDib* frame = g_previewPool.Acquire();
+        if (!frame) return false;
 
+        // Set per-monitor DPI awareness so GetDC(nullptr), BitBlt and the
+        // cursor position use physical pixel coordinates.  These match the
+        // physical rects stored in g_monitors by EnumerateMonitors (which uses
+        // the same context), fixing partial-capture on monitors with a
+        // non-100% scale factor.
+        DPI_AWARENESS_CONTEXT prevCtx = nullptr;
+        auto pfnSetDpi = GetSetThreadDpiAwarenessFn();
         if (pfnSetDpi)
-            pfnSetDpi(prevCtx);
+            prevCtx = pfnSetDpi(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
 
-        // Replace any unconsumed frame (bounded-1 behaviour).
-        HBITMAP discarded = nullptr;
-        {
-            std::lock_guard<std::mutex> lk(g_pendingPreviewMutex);
-            discarded = g_pendingPreviewBmp;
-            g_pendingPreviewBmp = hBmp;
+        cursor = { LONG_MIN, LONG_MIN };
+        if (g_captureShowCursor.load()) GetCursorPos(&cursor);
+        cursorMoved = (cursor.x != lastCursor.x || cursor.y != lastCursor.y);
+
+        PooledDib* screen = nullptr;
+        if (!takeDxgiFrame(frame) && (screen = screenCopy.Acquire()) != nullptr) {
+            // Plain 1:1 BitBlt (the cheap GDI path), downscaled here instead
+            // of a HALFTONE StretchBlt when the tiles or the cursor changed.
+            bool changed = BitBltFrame(hFrameDC, activeRect, *screen, tiles, *frame, cursorMoved);
+            if (changed || cursorMoved) {
+                lastCursor = cursor;
+                if (changed)
+                    scaleActiveThumb(frame->bits, frame->width, frame->height);
+                if (g_captureShowCursor.load()) {
+                    HGDIOBJ old = SelectObject(hFrameDC, frame->bmp);
+                    DrawCursorOverlay(hFrameDC, activeRect, frame->width, frame->height);
+                    SelectObject(hFrameDC, old);
+                }
+                frame->tag = frameTag;
+                PostPreviewFrame(frame);
+                frame = nullptr;
+            }
+            screenCopy.Release(screen);
         }
-        if (discarded) DeleteObject(discarded);
+        bool posted = (frame == nullptr);
+        g_previewPool.Release(frame);   // unused (unchanged frame / no screen copy)
+        if (updateStrip()) posted = true;
 
-        if (g_hDlg)
-            PostMessage(g_hDlg, WM_APP_PREVIEW_READY, 0, 0);
+        if (pfnSetDpi)
+            pfnSetDpi(prevCtx);
+        return posted;
+    };
+
+    // Adaptive frame interval, see the section comment.
+    unsigned intervalMs = 0;
+    auto nextInterval = [&](bool changed) -> unsigned {
+        unsigned maxFps = (std::max)(1u, g_previewMaxFps.load());
+        unsigned minFps = (std::min)((std::max)(1u, g_previewMinFps.load()), maxFps);
+        unsigned fastMs = 1000 / maxFps;
+        if (!dxgi->IsOpen()) fastMs = (std::max)(fastMs, CAPTURE_INTERVAL_GDI_MS);
+        unsigned slowMs = (std::max)(1000 / minFps, fastMs);
+        if (!strip.empty()) slowMs = (std::min)(slowMs, (std::max)(fastMs, CAPTURE_STRIP_INTERVAL_MS));
+        if (changed || intervalMs < fastMs) return fastMs;
+        return (std::min)(slowMs, intervalMs + intervalMs / 2);
     };
 
+    g_captureWorkerUp = true;
+    ULONGLONG frameDueAt = 0;
     while (true) {
         CaptureEvent evt;
         bool hasEvent;
 
+        // Take a frame and finish the checks that are due, then wait until
+        // the next of either is.
+        unsigned waitMs = INFINITE;
         if (capturing) {
-            // Take a frame, then wait up to 200 ms for the next event.
-            takeFrame();
-            hasEvent = g_captureChannel.recv_timeout(evt, 200);
-            if (!hasEvent) continue;  // timeout → capture another frame
+            ULONGLONG now = GetTickCount64();
+            if (now >= frameDueAt) {
+                intervalMs = nextInterval(takeFrame());
+                frameDueAt = now + intervalMs;
+            }
+            waitMs = static_cast<unsigned>(frameDueAt - (std::min)(frameDueAt, GetTickCount64()));
+        }
+        waitMs = (std::min)(waitMs, runChecks());
+
+        if (waitMs != INFINITE) {
+            hasEvent = g_captureChannel.recv_timeout(evt, waitMs);
+            if (!hasEvent) continue;  // timeout → next frame or check
         } else {
             // Idle: block indefinitely until an event arrives.
             hasEvent = g_captureChannel.recv(evt);
@@ -427,23 +1484,66 @@ static void CaptureWorkerProc()
 
         if (evt.type == CaptureEventType::Quit) break;
 
+        if (evt.type == CaptureEventType::CheckBefore) {
+            checkBefore(evt);
+            continue;
+        }
+        if (evt.type == CaptureEventType::CheckAfter) {
+            checkAfter(evt);
+            continue;
+        }
+
         if (evt.type == CaptureEventType::StopCapture) {
             capturing = false;
-            // Discard any pending (not-yet-consumed) preview bitmap.
-            HBITMAP old = nullptr;
-            {
-                std::lock_guard<std::mutex> lk(g_pendingPreviewMutex);
-                old = g_pendingPreviewBmp;
-                g_pendingPreviewBmp = nullptr;
-            }
-            if (old) DeleteObject(old);
+            // Discard any pending (not-yet-consumed) preview frame.
+            g_previewPool.Release(g_pendingPreview.take());
+            screenCopy.Resize(0, 0);   // free the monitor-size copy while idle
+            tiles.Reset();
+            dxgi->Close();
+            dxgiRetryAt = 0;
+            stopStrip();
         } else if (evt.type == CaptureEventType::Capture) {
             // Start or restart continuous capture (e.g. monitor switched).
-            capturing  = true;
-            activeRect = evt.monitorRect;
-            // Next iteration will call takeFrame() immediately.
+            capturing   = true;
+            previewSize = evt.previewSize;
+            frameTag    = evt.frameTag;
+            configureStrip(evt);
+            if (!EqualRect(&activeRect, &evt.monitorRect)) {
+                // Frames of the old monitor are stale now.
+                g_previewPool.Release(g_pendingPreview.take());
+                // Trade duplications with the strip instead of reopening: the
+                // new monitor's becomes the preview's and the old preview's
+                // goes to the old monitor's thumbnail, so the first frame of
+                // the new monitor is one readback away.
+                // The active monitor's own strip entry never holds an open one.
+                int prev = findStrip(activeRect);
+                int next = findStrip(evt.monitorRect);
+                if (prev >= 0) {
+                    std::swap(dxgi, strip[prev].dxgi);
+                    strip[prev].tiles.Reset();
+                } else {
+                    dxgi->Close();
+                }
+                if (next >= 0)
+                    std::swap(dxgi, strip[next].dxgi);
+                dxgiRetryAt = 0;
+            }
+            activeRect  = evt.monitorRect;
+            stripActive = findStrip(activeRect);
+            activeStale = true;
+            lastCursor = { LONG_MIN, LONG_MIN };   // post the next frame even if unchanged
+            tiles.Reset();
+            intervalMs = 0;                        // and start at the full rate
+            // Only a new preview / monitor size reallocates the pool.
+            SIZE fit = FitPreview(activeRect, previewSize);
+            g_previewPool.Resize(fit.cx, fit.cy);
+            screenCopy.Resize(activeRect.right - activeRect.left,
+                              activeRect.bottom - activeRect.top);
+            frameDueAt = 0;                        // next iteration calls takeFrame()
         }
     }
+    g_captureWorkerUp = false;
+    DeleteDC(hFrameDC);
 }
 
 // ============================================================================
@@ -463,22 +1563,52 @@ static void SaveSettings()
     RegSetValueExW(hKey, L"ShowDesktopPreview", 0, REG_DWORD,
         reinterpret_cast<const BYTE*>(&showPreview), sizeof(showPreview));
 
+    DWORD minFps = g_previewMinFps.load(), maxFps = g_previewMaxFps.load();
+    RegSetValueExW(hKey, L"PreviewMinFps", 0, REG_DWORD,
+        reinterpret_cast<const BYTE*>(&minFps), sizeof(minFps));
+    RegSetValueExW(hKey, L"PreviewMaxFps", 0, REG_DWORD,
+        reinterpret_cast<const BYTE*>(&maxFps), sizeof(maxFps));
+
     DWORD showCursor = g_captureShowCursor.load() ? 1u : 0u;
     RegSetValueExW(hKey, L"ShowCursorInPreview", 0, REG_DWORD,
         reinterpret_cast<const BYTE*>(&showCursor), sizeof(showCursor));
 
-    // Build REG_MULTI_SZ: each name null-terminated, list ends with extra null.
+    DWORD previewWindow = g_previewSelectedWindow ? 1u : 0u;
+    RegSetValueExW(hKey, L"PreviewSelectedWindow", 0, REG_DWORD,
+        reinterpret_cast<const BYTE*>(&previewWindow), sizeof(previewWindow));
+
+    DWORD monitorStrip = g_showMonitorStrip ? 1u : 0u;
+    RegSetValueExW(hKey, L"ShowMonitorStrip", 0, REG_DWORD,
+        reinterpret_cast<const BYTE*>(&monitorStrip), sizeof(monitorStrip));
+
+    DWORD resident = g_residentAgent ? 1u : 0u;
+    RegSetValueExW(hKey, L"ResidentAgent", 0, REG_DWORD,
+        reinterpret_cast<const BYTE*>(&resident), sizeof(resident));
+
+    DWORD unloadOnExit = g_unloadAllOnExit ? 1u : 0u;
+    RegSetValueExW(hKey, L"UnloadAllOnExit", 0, REG_DWORD,
+        reinterpret_cast<const BYTE*>(&unloadOnExit), sizeof(unloadOnExit));
+
+    DWORD captureCheck = g_captureCheck.load() ? 1u : 0u;
+    RegSetValueExW(hKey, L"CaptureCheck", 0, REG_DWORD,
+        reinterpret_cast<const BYTE*>(&captureCheck), sizeof(captureCheck));
+
+    // Build REG_MULTI_SZ: one "pattern\taffinity\ttitle" row per rule, each
+    // null-terminated, list ends with extra null.  Replaces the old
+    // WatchedExeNames (names only), which LoadSettings still migrates.
     {
-        std::lock_guard<std::mutex> lk(g_watchedExeMutex);
+        std::lock_guard<std::mutex> lk(g_watchRulesMutex);
         std::vector<wchar_t> buf;
-        for (const auto& name : g_watchedExeNames) {
-            buf.insert(buf.end(), name.begin(), name.end());
+        for (const auto& rule : g_watchRules) {
+            std::wstring row = WatchRuleToRow(rule);
+            buf.insert(buf.end(), row.begin(), row.end());
             buf.push_back(L'\0');
         }
         buf.push_back(L'\0');
-        RegSetValueExW(hKey, L"WatchedExeNames", 0, REG_MULTI_SZ,
+        RegSetValueExW(hKey, L"WatchRules", 0, REG_MULTI_SZ,
             reinterpret_cast<const BYTE*>(buf.data()),
             static_cast<DWORD>(buf.size() * sizeof(wchar_t)));
+        RegDeleteValueW(hKey, L"WatchedExeNames");
     }
 
     RegCloseKey(hKey);
@@ -506,6 +1636,25 @@ static void LoadSettings(HWND hDlg)
         }
     }
 
+    // PreviewMinFps / PreviewMaxFps (clamped to 1..PREVIEW_FPS_LIMIT, min <= max)
+    {
+        DWORD minFps = g_previewMinFps.load(), maxFps = g_previewMaxFps.load();
+        DWORD val = 0, size = sizeof(val), type = 0;
+        if (RegQueryValueExW(hKey, L"PreviewMinFps", nullptr, &type,
+                reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS
+            && type == REG_DWORD)
+            minFps = val;
+        size = sizeof(val);
+        if (RegQueryValueExW(hKey, L"PreviewMaxFps", nullptr, &type,
+                reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS
+            && type == REG_DWORD)
+            maxFps = val;
+        maxFps = (std::min)((std::max)(maxFps, DWORD(1)), static_cast<DWORD>(PREVIEW_FPS_LIMIT));
+        minFps = (std::min)((std::max)(minFps, DWORD(1)), maxFps);
+        g_previewMinFps.store(minFps);
+        g_previewMaxFps.store(maxFps);
+    }
+
     // ShowCursorInPreview
     {
         DWORD val = 0, size = sizeof(val), type = 0;
@@ -519,34 +1668,189 @@ static void LoadSettings(HWND hDlg)
         }
     }
 
-    // WatchedExeNames (REG_MULTI_SZ)
+    // PreviewSelectedWindow
+    {
+        DWORD val = 0, size = sizeof(val), type = 0;
+        if (RegQueryValueExW(hKey, L"PreviewSelectedWindow", nullptr, &type,
+                reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS
+            && type == REG_DWORD)
+        {
+            g_previewSelectedWindow = (val != 0);
+            CheckDlgButton(hDlg, IDC_CHK_PREVIEW_WINDOW,
+                val ? BST_CHECKED : BST_UNCHECKED);
+        }
+    }
+
+    // ShowMonitorStrip
+    {
+        DWORD val = 0, size = sizeof(val), type = 0;
+        if (RegQueryValueExW(hKey, L"ShowMonitorStrip", nullptr, &type,
+                reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS
+            && type == REG_DWORD)
+        {
+            g_showMonitorStrip = (val != 0);
+            CheckDlgButton(hDlg, IDC_CHK_MONITOR_STRIP,
+                val ? BST_CHECKED : BST_UNCHECKED);
+            ShowPreviewControls(hDlg, g_showDesktopPreview);
+        }
+    }
+
+    // ResidentAgent
+    {
+        DWORD val = 0, size = sizeof(val), type = 0;
+        if (RegQueryValueExW(hKey, L"ResidentAgent", nullptr, &type,
+                reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS
+            && type == REG_DWORD)
+        {
+            g_residentAgent = (val != 0);
+            CheckDlgButton(hDlg, IDC_CHK_RESIDENT_AGENT,
+                g_residentAgent ? BST_CHECKED : BST_UNCHECKED);
+            // Auto-unload does not apply while the agent keeps the DLL loaded.
+            EnableWindow(GetDlgItem(hDlg, IDC_CHK_AUTO_UNLOAD), !g_residentAgent);
+            SetResidentAgentMode(g_residentAgent);
+        }
+    }
+
+    // UnloadAllOnExit
+    {
+        DWORD val = 0, size = sizeof(val), type = 0;
+        if (RegQueryValueExW(hKey, L"UnloadAllOnExit", nullptr, &type,
+                reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS
+            && type == REG_DWORD)
+        {
+            g_unloadAllOnExit = (val != 0);
+        }
+    }
+
+    // CaptureCheck
+    {
+        DWORD val = 0, size = sizeof(val), type = 0;
+        if (RegQueryValueExW(hKey, L"CaptureCheck", nullptr, &type,
+                reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS
+            && type == REG_DWORD)
+        {
+            g_captureCheck = (val != 0);
+        }
+    }
+
+    // WatchRules (REG_MULTI_SZ), or the names-only WatchedExeNames of older
+    // versions (each name becomes an exclude rule).
+    for (const wchar_t* valueName : { L"WatchRules", L"WatchedExeNames" }) {
+        DWORD type = 0, size = 0;
+        if (RegQueryValueExW(hKey, valueName, nullptr, &type,
+                nullptr, &size) != ERROR_SUCCESS
+            || type != REG_MULTI_SZ || size == 0)
+            continue;
+        // Room for a terminator in case the stored value lacks one.
+        std::vector<wchar_t> buf(size / sizeof(wchar_t) + 2, L'\0');
+        if (RegQueryValueExW(hKey, valueName, nullptr, nullptr,
+                reinterpret_cast<BYTE*>(buf.data()), &size) == ERROR_SUCCESS)
+        {
+            HWND hList = GetDlgItem(hDlg, IDC_WATCH_LIST);
+            SendMessageW(hList, WM_SETREDRAW, FALSE, 0);
+            std::lock_guard<std::mutex> lk(g_watchRulesMutex);
+            g_watchRules.clear();
+            for (const wchar_t* p = buf.data(); *p; p += wcslen(p) + 1) {
+                WatchRule rule;
+                if (!WatchRuleFromRow(p, rule)) continue;
+                g_watchRules.push_back(rule);
+                InsertWatchListRow(hList, rule);
+            }
+            SendMessageW(hList, WM_SETREDRAW, TRUE, 0);
+            InvalidateRect(hList, nullptr, TRUE);
+        }
+        break;
+    }
+
+    RegCloseKey(hKey);
+}
+
+// ---------------------------------------------------------------------------
+// Last-session window list (LastWindows, REG_MULTI_SZ next to WatchRules):
+// one "hwnd<TAB>pid<TAB>process<TAB>title" string per row.  At startup the rows
+// whose HWND still names a window of the same process are listed at once,
+// before the first enumeration has run; nothing is sent to their owners.
+static const size_t WINDOW_SNAPSHOT_MAX = 512;
+
+static void SaveWindowSnapshot()
+{
+    HKEY hKey;
+    if (RegCreateKeyExW(HKEY_CURRENT_USER, REG_APP_KEY, 0, nullptr,
+            REG_OPTION_NON_VOLATILE, KEY_WRITE, nullptr, &hKey, nullptr)
+        != ERROR_SUCCESS)
+        return;
+
+    std::vector<wchar_t> buf;
+    size_t n = (std::min)(g_windows.size(), WINDOW_SNAPSHOT_MAX);
+    for (size_t i = 0; i < n; ++i) {
+        const WindowInfo& w = g_windows[i];
+        wchar_t head[64];
+        swprintf_s(head, L"%llx\t%lu\t",
+                   static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(w.hwnd)),
+                   static_cast<unsigned long>(w.pid));
+        std::wstring row = head + w.processName + L'\t' + w.title;
+        buf.insert(buf.end(), row.begin(), row.end());
+        buf.push_back(L'\0');
+    }
+    buf.push_back(L'\0');
+    RegSetValueExW(hKey, L"LastWindows", 0, REG_MULTI_SZ,
+        reinterpret_cast<const BYTE*>(buf.data()),
+        static_cast<DWORD>(buf.size() * sizeof(wchar_t)));
+    RegCloseKey(hKey);
+}
+
+// Fill g_windows from LastWindows; the rows are remembered in g_seededWindows
+// until the startup enumeration confirms or drops them.
+static void LoadWindowSnapshot(HWND hDlg)
+{
+    HKEY hKey;
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, REG_APP_KEY,
+            0, KEY_READ, &hKey) != ERROR_SUCCESS)
+        return;
+
+    std::vector<wchar_t> buf;
+    DWORD type = 0, size = 0;
+    if (RegQueryValueExW(hKey, L"LastWindows", nullptr, &type,
+            nullptr, &size) == ERROR_SUCCESS
+        && type == REG_MULTI_SZ && size > 0)
     {
-        DWORD type = 0, size = 0;
-        if (RegQueryValueExW(hKey, L"WatchedExeNames", nullptr, &type,
-                nullptr, &size) == ERROR_SUCCESS
-            && type == REG_MULTI_SZ && size > 0)
-        {
-            std::vector<wchar_t> buf(size / sizeof(wchar_t));
-            if (RegQueryValueExW(hKey, L"WatchedExeNames", nullptr, nullptr,
-                    reinterpret_cast<BYTE*>(buf.data()), &size) == ERROR_SUCCESS)
-            {
-                HWND hList = GetDlgItem(hDlg, IDC_WATCH_LIST);
-                std::lock_guard<std::mutex> lk(g_watchedExeMutex);
-                g_watchedExeNames.clear();
-                for (const wchar_t* p = buf.data(); *p; p += wcslen(p) + 1) {
-                    std::wstring name(p);
-                    g_watchedExeNames.push_back(name);
-                    LVITEMW lvi = {};
-                    lvi.mask    = LVIF_TEXT;
-                    lvi.iItem   = ListView_GetItemCount(hList);
-                    lvi.pszText = const_cast<LPWSTR>(name.c_str());
-                    ListView_InsertItem(hList, &lvi);
-                }
-            }
-        }
+        // Room for two terminators: the value may lack its double NUL or
+        // have an odd byte count.
+        buf.resize(size / sizeof(wchar_t) + 2, L'\0');
+        if (RegQueryValueExW(hKey, L"LastWindows", nullptr, nullptr,
+                reinterpret_cast<BYTE*>(buf.data()), &size) != ERROR_SUCCESS)
+            buf.clear();
     }
-
     RegCloseKey(hKey);
+    if (buf.empty()) return;
+
+    const wchar_t* end = buf.data() + buf.size();
+    for (const wchar_t* p = buf.data(); p < end && *p; p += wcslen(p) + 1) {
+        std::wstring row(p);
+        size_t t1 = row.find(L'\t');
+        size_t t2 = (t1 == std::wstring::npos) ? t1 : row.find(L'\t', t1 + 1);
+        size_t t3 = (t2 == std::wstring::npos) ? t2 : row.find(L'\t', t2 + 1);
+        if (t3 == std::wstring::npos) continue;
+
+        WindowInfo w;
+        w.hwnd = reinterpret_cast<HWND>(static_cast<uintptr_t>(
+            wcstoull(row.c_str(), nullptr, 16)));
+        w.pid  = static_cast<DWORD>(wcstoul(row.c_str() + t1 + 1, nullptr, 10));
+        DWORD pid = 0;
+        if (!w.hwnd || w.hwnd == hDlg || !IsWindow(w.hwnd) || !IsWindowVisible(w.hwnd)
+            || !GetWindowThreadProcessId(w.hwnd, &pid) || pid != w.pid
+            || g_seededWindows.count(w.hwnd))
+            continue;   // gone, or the handle now names another window
+        w.processName = row.substr(t2 + 1, t3 - t2 - 1);
+        w.title       = row.substr(t3 + 1);
+        w.isTopMost   = IsWindowTopMost(w.hwnd);
+        w.isExcluded  = IsWindowExcludeFromCapture(w.hwnd);
+        w.isPending   = true;   // no icon until the enumeration lists it
+        g_seededWindows.insert(w.hwnd);
+        g_windows.push_back(std::move(w));
+    }
+    if (!g_windows.empty())
+        SyncWindowListCount(hDlg, 0);
 }
 
 // ============================================================================
@@ -599,12 +1903,35 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int)
 
     g_hInst = hInstance;
 
+    // Scripted use: apply the --exclude / --include rules first; with --no-ui
+    // no window, tray icon or capture thread is created at all.
+    CliOptions   cli;
+    std::wstring cliError;
+    if (!ParseCommandLine(cli, cliError) || cli.help) {
+        PrintCliUsage(cliError);
+        ShutdownLogger();
+        return cliError.empty() ? CLI_OK : CLI_USAGE;
+    }
+    if (cli.noUi || !cli.rules.empty()) {
+        int code = RunCommandLine(cli);
+        if (cli.noUi) {
+            StopInjectPool();
+            ClearProcessCache();
+            ShutdownLogger();
+            return code;
+        }
+    }
+
     INITCOMMONCONTROLSEX icc = {};
     icc.dwSize = sizeof(icc);
     icc.dwICC  = ICC_LISTVIEW_CLASSES | ICC_TAB_CLASSES;
     InitCommonControlsEx(&icc);
 
     DialogBoxW(hInstance, MAKEINTRESOURCEW(IDD_MAIN_DIALOG), nullptr, DlgProc);
+    ShutdownLogger();
+    // Jobs abandoned by StopInjectPool still run on detached workers: end
+    // them with the process instead of destroying the statics they use.
+    if (g_injectPoolAbandoned) ExitProcess(0);
     return 0;
 }
 
@@ -617,6 +1944,33 @@ static void SetStatus(HWND hDlg, const std::wstring& msg)
     SetDlgItemTextW(hDlg, IDC_STATUS_TEXT, msg.c_str());
 }
 
+// Hovering the status bar shows the latency histograms; the text is built
+// on demand in TTN_GETDISPINFOW.  Clicking it writes them to the log.
+static void CreateStatsTooltip(HWND hDlg)
+{
+    HWND hStatus = GetDlgItem(hDlg, IDC_STATUS_TEXT);
+    g_hStatsTip = CreateWindowExW(WS_EX_TOPMOST, TOOLTIPS_CLASSW, nullptr,
+        WS_POPUP | TTS_NOPREFIX | TTS_ALWAYSTIP, CW_USEDEFAULT, CW_USEDEFAULT,
+        CW_USEDEFAULT, CW_USEDEFAULT, hDlg, nullptr, g_hInst, nullptr);
+    if (!g_hStatsTip || !hStatus) return;
+
+    TOOLINFOW ti = {};
+    ti.cbSize   = sizeof(ti);
+    ti.uFlags   = TTF_IDISHWND | TTF_SUBCLASS;
+    ti.hwnd     = hDlg;
+    ti.uId      = reinterpret_cast<UINT_PTR>(hStatus);
+    ti.lpszText = LPSTR_TEXTCALLBACKW;
+    SendMessageW(g_hStatsTip, TTM_ADDTOOLW, 0, reinterpret_cast<LPARAM>(&ti));
+    SendMessageW(g_hStatsTip, TTM_SETMAXTIPWIDTH, 0, 800);   // multi-line
+    SendMessageW(g_hStatsTip, TTM_SETDELAYTIME, TTDT_AUTOPOP, 30000);
+
+    g_hFontMono = CreateFontW(-12, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
+        DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+        CLEARTYPE_QUALITY, FIXED_PITCH | FF_MODERN, L"Consolas");
+    if (g_hFontMono)
+        SendMessageW(g_hStatsTip, WM_SETFONT, reinterpret_cast<WPARAM>(g_hFontMono), FALSE);
+}
+
 static std::wstring FmtHandle(HWND hwnd)
 {
     std::wostringstream oss;
@@ -625,6 +1979,42 @@ static std::wstring FmtHandle(HWND hwnd)
     return oss.str();
 }
 
+// Queue an affinity change for one window on the inject pool; the result comes
+// back to the dialog as WM_APP_INJECT_DONE so the UI thread never blocks.
+static void SubmitUiInjection(HWND hwnd, DWORD pid, DWORD affinity)
+{
+    SetStatus(g_hDlg, L"Injecting \u2026");
+    SubmitInjectChecked(pid, { hwnd }, affinity, g_autoUnloadDll, [](const InjectResult& r) {
+        HWND hDlg = g_hDlg;
+        if (!hDlg) return;
+        auto* copy = new InjectResult(r);
+        if (!PostMessage(hDlg, WM_APP_INJECT_DONE, 0, reinterpret_cast<LPARAM>(copy)))
+            delete copy;
+    });
+}
+
+// Add rule to the watch list unless a rule for the same windows exists;
+// persists it, recompiles the rules and applies them to running processes.
+static void AddWatchRule(HWND hDlg, const WatchRule& rule)
+{
+    const std::wstring text = WatchRuleToText(rule);
+    {
+        std::lock_guard<std::mutex> lk(g_watchRulesMutex);
+        for (const auto& e : g_watchRules)
+            if (SameWatchTarget(e, rule)) {
+                SetStatus(hDlg, L"Already watching: " + WatchRuleToText(e));
+                return;
+            }
+        g_watchRules.push_back(rule);
+    }
+    InsertWatchListRow(GetDlgItem(hDlg, IDC_WATCH_LIST), rule);
+    SetStatus(hDlg, L"Watching: " + text);
+    SaveSettings();
+    OnWatchListChanged();
+    // Apply the new rule to already-running processes right away.
+    g_injectorChannel.send(InjectorEvent{InjectorEventType::WatchCheck});
+}
+
 // ============================================================================
 // Monitor enumeration
 // ============================================================================
@@ -670,14 +2060,29 @@ static void EnumerateMonitors()
 // Send a Capture event to the capture worker thread.
 // The cursor-overlay state is tracked via g_captureShowCursor (atomic) so
 // the worker reads the up-to-date value on every frame without touching the UI.
+// Ignored while the preview is a window thumbnail (see UpdatePreviewMode).
 static void SendCaptureEvent(int monitorIdx)
 {
     if (monitorIdx < 0 || monitorIdx >= static_cast<int>(g_monitors.size()))
         return;
+    if (g_windowThumb.IsActive())
+        return;
     CaptureEvent evt;
     evt.type        = CaptureEventType::Capture;
     evt.monitorRect = g_monitors[monitorIdx];
-    g_captureChannel.send(evt);
+    evt.frameTag    = g_previewTag;
+    RECT rc = {};
+    if (g_hDlg && GetClientRect(GetDlgItem(g_hDlg, IDC_PREVIEW_STATIC), &rc))
+        evt.previewSize = { rc.right - rc.left, rc.bottom - rc.top };
+    rc = {};
+    if (g_showMonitorStrip && g_hDlg
+        && GetClientRect(GetDlgItem(g_hDlg, IDC_MONITOR_STRIP), &rc)
+        && rc.right > 0 && rc.bottom > 0)
+    {
+        evt.stripMonitors = g_monitors;
+        evt.stripSize     = { rc.right - rc.left, rc.bottom - rc.top };
+    }
+    g_captureChannel.send(std::move(evt));
 }
 
 // Send a StopCapture event (e.g. on focus loss).
@@ -688,104 +2093,119 @@ static void SendStopCaptureEvent()
     g_captureChannel.send(evt);
 }
 
+// Switch the preview to monitor `idx` (screen tab or thumbnail strip click).
+// Frames still in flight for the old monitor are dropped by their tag.  With
+// the strip shown the preview falls back to the new monitor's thumbnail at
+// once (see WM_DRAWITEM) until the worker's first full frame arrives.
+static void SelectPreviewMonitor(HWND hDlg, int idx)
+{
+    if (idx < 0 || idx >= static_cast<int>(g_monitors.size()) || idx == g_currentMonitor)
+        return;
+    g_currentMonitor = idx;
+    ++g_previewTag;
+    HWND hTab = GetDlgItem(hDlg, IDC_TAB_SCREENS);
+    if (TabCtrl_GetCurSel(hTab) != idx)
+        TabCtrl_SetCurSel(hTab, idx);
+    if (g_stripFrame) {
+        ClearPreviewFrame();
+        InvalidateRect(GetDlgItem(hDlg, IDC_PREVIEW_STATIC), nullptr, FALSE);
+    }
+    InvalidateRect(GetDlgItem(hDlg, IDC_MONITOR_STRIP), nullptr, FALSE);
+    // Invisiwind: clicking a monitor tab sends CaptureWorkerEvent::Capture(*monitor)
+    if (g_showDesktopPreview)
+        SendCaptureEvent(g_currentMonitor);
+}
+
 // ---------------------------------------------------------------------------
 // ListView column setup for the hidden-windows list (4 columns).
 
 // ---------------------------------------------------------------------------
-// Main window list: Title, Process, TopMost, Hidden columns.
-// ExcludeCapture is represented by the LVS_EX_CHECKBOXES checkbox.
+// The main window list is virtual (LVS_OWNERDATA): the control stores no rows
+// and asks for text / icon / checkbox state through LVN_GETDISPINFO, reading
+// g_windows directly.  g_windows follows the injector thread's WindowModel via
+// WM_APP_WINDOWS_READY; g_injectorChannel.send({InjectorEventType::Update})
+// forces a full resync.
+
+// Selected row, tracked by HWND so it survives rows moving.
+static HWND g_selectedHwnd = nullptr;
 
-static void InitMainListViewColumns(HWND hList)
+static int FindWindowRow(HWND hwnd)
 {
-    static const struct { const wchar_t* name; int cx; } cols[] = {
-        { L"Title",   200 },
-        { L"Process",  90 },
-        { L"TopMost",  60 },
-        { L"Hidden",   50 },
-    };
-    LVCOLUMNW lvc = {};
-    lvc.mask = LVCF_TEXT | LVCF_WIDTH | LVCF_SUBITEM;
-    for (int i = 0; i < 4; ++i) {
-        lvc.cx       = cols[i].cx;
-        lvc.pszText  = const_cast<LPWSTR>(cols[i].name);
-        lvc.iSubItem = i;
-        ListView_InsertColumn(hList, i, &lvc);
-    }
+    for (size_t i = 0; i < g_windows.size(); ++i)
+        if (g_windows[i].hwnd == hwnd) return static_cast<int>(i);
+    return -1;
 }
 
-// ---------------------------------------------------------------------------
-// Populate (or refresh) the main window list from the current g_windows snapshot.
-// The caller is responsible for ensuring g_windows is up-to-date before calling.
-// Use g_injectorChannel.send({InjectorEventType::Update}) to request an async
-// refresh; the injector thread will post WM_APP_WINDOWS_READY when done.
-
-static void PopulateWindowList(HWND hDlg, bool preserveSelection = false)
+// Capture-leak check state of a row (None when the check is off or the
+// window was never checked).
+static CaptureCheck GetCaptureCheck(HWND hwnd)
 {
-    HWND hList = GetDlgItem(hDlg, IDC_WINDOW_LIST);
-
-    HWND selHwnd = nullptr;
-    if (preserveSelection) {
-        int sel = ListView_GetNextItem(hList, -1, LVNI_SELECTED);
-        if (sel >= 0 && sel < static_cast<int>(g_windows.size()))
-            selHwnd = g_windows[sel].hwnd;
-    }
-
-    g_populatingList = true;
-    ListView_DeleteAllItems(hList);
+    auto it = g_captureChecks.find(hwnd);
+    return (it != g_captureChecks.end()) ? it->second : CaptureCheck::None;
+}
 
-    // Build an image list from per-window icons.
-    int n = static_cast<int>(g_windows.size());
-    HIMAGELIST hImgList = ImageList_Create(16, 16, ILC_COLOR32 | ILC_MASK, n, 0);
-    std::vector<int> imgIdx(n, -1);
-    for (int i = 0; i < n; ++i) {
-        if (g_windows[i].hIcon)
-            imgIdx[i] = ImageList_AddIcon(hImgList, g_windows[i].hIcon);
+static const wchar_t* CaptureCheckText(CaptureCheck state)
+{
+    switch (state) {
+    case CaptureCheck::Pending:      return L"\u2026";
+    case CaptureCheck::Absent:       return L"\u2713";
+    case CaptureCheck::Visible:      return L"visible";
+    case CaptureCheck::Inconclusive: return L"?";
+    default:                         return L"";
     }
-    HIMAGELIST hOld = ListView_SetImageList(hList, hImgList, LVSIL_SMALL);
-    if (hOld) ImageList_Destroy(hOld);
-
-    LVITEMW lvi = {};
-
-    for (int i = 0; i < n; ++i) {
-        const auto& w = g_windows[i];
-
-        lvi.iItem    = i;
-        lvi.iSubItem = 0;
-        lvi.lParam   = static_cast<LPARAM>(i);
-        lvi.pszText  = const_cast<LPWSTR>(w.title.c_str());
-        lvi.iImage   = (imgIdx[i] >= 0) ? imgIdx[i] : I_IMAGENONE;
-        lvi.mask     = LVIF_TEXT | LVIF_PARAM | LVIF_IMAGE; // always set image to avoid defaulting to 0
-        ListView_InsertItem(hList, &lvi);
+}
 
-        ListView_SetItemText(hList, i, 1,
-            const_cast<LPWSTR>(w.processName.c_str()));
+// Fill one LVN_GETDISPINFO request from g_windows (see window_row.h).
+static void GetWindowRowDispInfo(LVITEMW& item)
+{
+    static const WindowRowLookups lookups = {
+        [](HWND hwnd) { return CaptureCheckText(GetCaptureCheck(hwnd)); },
+        IconCacheIndex,
+    };
+    if (item.iItem < 0 || item.iItem >= static_cast<int>(g_windows.size()))
+        return;
+    FillWindowRowDispInfo(item, g_windows[item.iItem], lookups);
+}
 
-        // TopMost column
-        ListView_SetItemText(hList, i, 2,
-            const_cast<LPWSTR>(IsWindowTopMost(w.hwnd) ? L"\u2713" : L""));
+static void RedrawWindowRow(HWND hDlg, int idx)
+{
+    if (idx >= 0)
+        ListView_RedrawItems(GetDlgItem(hDlg, IDC_WINDOW_LIST), idx, idx);
+}
 
-        // Hidden column
-        ListView_SetItemText(hList, i, 3,
-            const_cast<LPWSTR>(w.isHidden ? L"\u25cf" : L""));
+// Select the row of g_selectedHwnd (or clear the selection if it is gone).
+static void RestoreSelectedRow(HWND hDlg)
+{
+    HWND hList = GetDlgItem(hDlg, IDC_WINDOW_LIST);
+    int  row   = g_selectedHwnd ? FindWindowRow(g_selectedHwnd) : -1;
+    if (row == ListView_GetNextItem(hList, -1, LVNI_SELECTED)) return;
 
-        // ExcludeCapture state = checkbox state (skip for hidden windows)
-        ListView_SetCheckState(hList, i,
-            (!w.isHidden && IsWindowExcludeFromCapture(w.hwnd)) ? TRUE : FALSE);
-    }
+    g_populatingList = true;
+    ListView_SetItemState(hList, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+    if (row >= 0)
+        ListView_SetItemState(hList, row,
+            LVIS_SELECTED | LVIS_FOCUSED, LVIS_SELECTED | LVIS_FOCUSED);
     g_populatingList = false;
+    if (row < 0) g_selectedHwnd = nullptr;
+}
 
-    // Restore selection
-    if (selHwnd) {
-        for (int i = 0; i < static_cast<int>(g_windows.size()); ++i) {
-            if (g_windows[i].hwnd == selHwnd) {
-                ListView_SetItemState(hList, i,
-                    LVIS_SELECTED | LVIS_FOCUSED,
-                    LVIS_SELECTED | LVIS_FOCUSED);
-                ListView_EnsureVisible(hList, i, FALSE);
-                break;
-            }
-        }
-    }
+// Resize the virtual list to g_windows and repaint from `firstDirty` down
+// (rows above it are unchanged).  Pass 0 to repaint every visible row.
+static void SyncWindowListCount(HWND hDlg, int firstDirty)
+{
+    ScopedStat timer(Stat::PopulateWindowList);
+    HWND hList = GetDlgItem(hDlg, IDC_WINDOW_LIST);
+    int  n     = static_cast<int>(g_windows.size());
+    ListView_SetItemCountEx(hList, n, LVSICF_NOSCROLL | LVSICF_NOINVALIDATEALL);
+    if (firstDirty < n)
+        ListView_RedrawItems(hList, firstDirty, n - 1);
+    RestoreSelectedRow(hDlg);
+}
+
+// Repaint the whole main window list from g_windows.
+static void PopulateWindowList(HWND hDlg, bool preserveSelection = false)
+{
+    SyncWindowListCount(hDlg, 0);
 
     if (!preserveSelection) {
         SetStatus(hDlg,
@@ -798,10 +2218,10 @@ static void PopulateWindowList(HWND hDlg, bool preserveSelection = false)
 // All regular control IDs – used to show/hide them en masse.
 static const int s_allControls[] = {
     IDC_PREVIEW_LABEL, IDC_PREVIEW_SUBTEXT, IDC_PREVIEW_STATIC, IDC_TAB_SCREENS,
-    IDC_CHK_SHOW_PREVIEW,
+    IDC_CHK_SHOW_PREVIEW, IDC_CHK_PREVIEW_WINDOW, IDC_MONITOR_STRIP, IDC_CHK_MONITOR_STRIP,
     IDC_SEP_1,
     IDC_HIDE_APPS_LABEL, IDC_HIDE_APPS_SUB, IDC_WINDOW_LIST, IDC_SELECTED_INFO,
-    IDC_CHK_AUTO_UNLOAD,
+    IDC_CHK_AUTO_UNLOAD, IDC_CHK_RESIDENT_AGENT,
     IDC_GRP_WATCH, IDC_WATCH_EDIT, IDC_BTN_WATCH_ADD, IDC_BTN_WATCH_REMOVE, IDC_WATCH_LIST,
     IDC_SEP_2, IDC_STATUS_TEXT, IDC_CHK_SHOW_CURSOR,
 };
@@ -809,7 +2229,6 @@ static const int s_allControls[] = {
 // Show a full-page ":)" placeholder when the app loses focus.
 static void ShowPlaceholder(HWND hDlg)
 {
-    g_windows.clear();
     for (int id : s_allControls)
         if (HWND h = GetDlgItem(hDlg, id))
             ShowWindow(h, SW_HIDE);
@@ -830,6 +2249,10 @@ static void ShowPreviewControls(HWND hDlg, bool show)
     ShowWindow(GetDlgItem(hDlg, IDC_PREVIEW_STATIC),  sw);
     ShowWindow(GetDlgItem(hDlg, IDC_TAB_SCREENS),     sw);
     ShowWindow(GetDlgItem(hDlg, IDC_CHK_SHOW_CURSOR), sw);
+    ShowWindow(GetDlgItem(hDlg, IDC_CHK_PREVIEW_WINDOW), sw);
+    ShowWindow(GetDlgItem(hDlg, IDC_CHK_MONITOR_STRIP),  sw);
+    ShowWindow(GetDlgItem(hDlg, IDC_MONITOR_STRIP),
+               (show && g_showMonitorStrip) ? SW_SHOW : SW_HIDE);
 }
 
 static void HidePlaceholder(HWND hDlg)
@@ -838,9 +2261,45 @@ static void HidePlaceholder(HWND hDlg)
     for (int id : s_allControls)
         if (HWND h = GetDlgItem(hDlg, id))
             ShowWindow(h, SW_SHOW);
-    // Re-hide preview-related controls if desktop preview is disabled
-    if (!g_showDesktopPreview)
-        ShowPreviewControls(hDlg, false);
+    // Re-hide preview-related controls if desktop preview or the strip is off
+    ShowPreviewControls(hDlg, g_showDesktopPreview);
+}
+
+// ---------------------------------------------------------------------------
+// Pick the preview source.  With "Preview selected window" on, a visible
+// selected window is shown as a DWM thumbnail in IDC_PREVIEW_STATIC and the
+// capture worker is stopped; otherwise (or if DWM refuses) the monitor
+// preview runs on the capture worker as before.  Call whenever the selection,
+// the preview rectangle, focus or one of the preview options changes.
+static void UpdatePreviewMode(HWND hDlg)
+{
+    HWND source = nullptr;
+    if (g_showDesktopPreview && g_hasFocus && g_previewSelectedWindow && g_selectedHwnd) {
+        int row = FindWindowRow(g_selectedHwnd);
+        if (row >= 0 && !g_windows[row].isHidden)
+            source = g_selectedHwnd;
+    }
+
+    bool wasActive = g_windowThumb.IsActive();
+    if (source) {
+        RECT rc = {};
+        HWND hPrev = GetDlgItem(hDlg, IDC_PREVIEW_STATIC);
+        GetWindowRect(hPrev, &rc);
+        MapWindowPoints(nullptr, hDlg, reinterpret_cast<POINT*>(&rc), 2);
+        if (!g_windowThumb.Show(hDlg, source, rc))
+            source = nullptr;
+    }
+    if (source) {
+        if (!wasActive) {
+            ClearPreviewFrame();
+            SendStopCaptureEvent();
+        }
+        return;
+    }
+
+    g_windowThumb.Stop();
+    if (wasActive && g_showDesktopPreview && g_hasFocus)
+        SendCaptureEvent(g_currentMonitor);
 }
 
 // ---------------------------------------------------------------------------
@@ -867,13 +2326,25 @@ static void RestoreAllHiddenWindows()
 // ---------------------------------------------------------------------------
 // Return the WindowInfo for the currently selected row (main list).
 
-static const WindowInfo* GetSelectedWindow(HWND hDlg)
+static const WindowInfo* GetSelectedWindow(HWND /*hDlg*/)
 {
-    HWND hList = GetDlgItem(hDlg, IDC_WINDOW_LIST);
-    int sel = ListView_GetNextItem(hList, -1, LVNI_SELECTED);
-    if (sel < 0 || sel >= static_cast<int>(g_windows.size()))
-        return nullptr;
-    return &g_windows[sel];
+    int sel = g_selectedHwnd ? FindWindowRow(g_selectedHwnd) : -1;
+    return (sel >= 0) ? &g_windows[sel] : nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Flip the ExcludeCapture checkbox of one row.  The row shows the requested
+// state at once; WM_APP_INJECT_DONE reverts it if the injection fails.
+
+static void ToggleRowExclude(HWND hDlg, int row)
+{
+    if (row < 0 || row >= static_cast<int>(g_windows.size())) return;
+    WindowInfo& w = g_windows[row];
+    if (w.isHidden) return;
+
+    w.isExcluded = !w.isExcluded;
+    RedrawWindowRow(hDlg, row);
+    SubmitUiInjection(w.hwnd, w.pid, w.isExcluded ? WDA_EXCLUDEFROMCAPTURE : WDA_NONE);
 }
 
 // ---------------------------------------------------------------------------
@@ -963,13 +2434,16 @@ static void OnSize(HWND hDlg, int /*cx*/, int /*cy*/)
 
     int prevLblY = top;  top += bigH + 2;
     // Preview-related controls only occupy vertical space when the preview is shown
-    int prevSubY = 0, previewY = 0, previewH = 0, tabY = 0;
+    int prevSubY = 0, previewY = 0, previewH = 0, stripY = 0, tabY = 0;
     if (g_showDesktopPreview) {
         prevSubY = top;  top += subH + DY;
         previewY = top;
         previewH = std::max(PREVIEW_H_MIN,
                             std::min(PREVIEW_H_MAX, H * PREVIEW_H_PCT / 100));
         top += previewH + DY;
+        if (g_showMonitorStrip) {
+            stripY = top;  top += MONITOR_STRIP_H + DY;
+        }
         tabY = top;  top += 22 + DY;
     }
     int hideAppY = top;  top += bigH + 2;
@@ -988,14 +2462,44 @@ static void OnSize(HWND hDlg, int /*cx*/, int /*cy*/)
     // Preview section – label and both checkboxes share the top row
     static const int chkW  = 140; // "Show cursor in preview" width
     static const int chkW2 = 160; // "Show desktop preview" width
+    static const int chkW3 = 160; // "Preview selected window" width
     Move(IDC_PREVIEW_LABEL,    mX, prevLblY, listW - chkW2 - chkW - 8, bigH);
     Move(IDC_CHK_SHOW_PREVIEW, mX + listW - chkW2 - chkW - 4, prevLblY, chkW2, bigH);
     Move(IDC_CHK_SHOW_CURSOR,  mX + listW - chkW, prevLblY, chkW, bigH);
     if (g_showDesktopPreview) {
-        Move(IDC_PREVIEW_SUBTEXT, mX, prevSubY, listW, subH);
+        Move(IDC_PREVIEW_SUBTEXT, mX, prevSubY, listW - chkW3 - 4, subH);
+        Move(IDC_CHK_PREVIEW_WINDOW, mX + listW - chkW3, prevSubY, chkW3, subH);
         Move(IDC_PREVIEW_STATIC,  mX, previewY, listW, previewH);
-        Move(IDC_TAB_SCREENS,     mX, tabY,     listW, 22);
+        // The capture worker renders at preview size; tell it about a new one.
+        static SIZE s_previewSize = {};
+        if (listW != s_previewSize.cx || previewH != s_previewSize.cy) {
+            s_previewSize = { listW, previewH };
+            // Size the paint back buffer here rather than on the next paint.
+            if (HDC hdc = GetDC(hDlg)) {
+                g_previewBuf.Get(hdc, listW, previewH);
+                ReleaseDC(hDlg, hdc);
+            }
+            if (g_hasFocus && g_captureThread.joinable())
+                SendCaptureEvent(g_currentMonitor);
+        }
+        if (g_showMonitorStrip) {
+            Move(IDC_MONITOR_STRIP, mX, stripY, listW, MONITOR_STRIP_H);
+            static int s_stripW = 0;
+            if (listW != s_stripW) {
+                s_stripW = listW;
+                if (HDC hdc = GetDC(hDlg)) {
+                    g_stripBuf.Get(hdc, listW, MONITOR_STRIP_H);
+                    ReleaseDC(hDlg, hdc);
+                }
+                if (g_hasFocus && g_captureThread.joinable())
+                    SendCaptureEvent(g_currentMonitor);
+            }
+        }
+        static const int chkW4 = 130; // "Screen thumbnails" width
+        Move(IDC_TAB_SCREENS,       mX, tabY, listW - chkW4 - 4, 22);
+        Move(IDC_CHK_MONITOR_STRIP, mX + listW - chkW4, tabY, chkW4, 22);
     }
+    UpdatePreviewMode(hDlg);
 
     // Hide applications section
     Move(IDC_HIDE_APPS_LABEL, mX, hideAppY, listW, bigH);
@@ -1007,8 +2511,9 @@ static void OnSize(HWND hDlg, int /*cx*/, int /*cy*/)
     // Selected info label
     Move(IDC_SELECTED_INFO, mX, selInfoY, listW, lblH);
 
-    // Auto-unload DLL checkbox (between window list and watch group)
-    Move(IDC_CHK_AUTO_UNLOAD, mX, autoUnloadY, listW, autoUnloadH);
+    // Auto-unload DLL + resident agent checkboxes (between window list and watch group)
+    Move(IDC_CHK_AUTO_UNLOAD,    mX,             autoUnloadY, listW / 2,         autoUnloadH);
+    Move(IDC_CHK_RESIDENT_AGENT, mX + listW / 2, autoUnloadY, listW - listW / 2, autoUnloadH);
 
     // Process watch section
     if (HWND hGrp = GetDlgItem(hDlg, IDC_GRP_WATCH))
@@ -1031,10 +2536,10 @@ static void OnSize(HWND hDlg, int /*cx*/, int /*cy*/)
     }
 
     // Stretch the Title column of the main window list to fill available width
-    // Columns: Title (dynamic) | Process (90) | TopMost (60) | Hidden (50)
+    // Columns: Title (dynamic) | Process (90) | TopMost (60) | Hidden (50) | Capture (56)
     if (HWND hWinList = GetDlgItem(hDlg, IDC_WINDOW_LIST)) {
         int scrollW = GetSystemMetrics(SM_CXVSCROLL);
-        int titleW  = listW - 90 - 60 - 50 - scrollW - 4;
+        int titleW  = listW - 90 - 60 - 50 - 56 - scrollW - 4;
         if (titleW > 40) ListView_SetColumnWidth(hWinList, 0, titleW);
     }
 
@@ -1089,6 +2594,15 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
         g_hbrBg    = CreateSolidBrush(CLR_BG);
         g_hbrListBg = CreateSolidBrush(CLR_LIST_BG);
 
+        // Owner-draw brushes / pens, created once instead of per paint
+        g_hbrSep        = CreateSolidBrush(CLR_SEP);
+        g_hbrBtnBg      = CreateSolidBrush(CLR_BTN_BG);
+        g_hbrBtnPress   = CreateSolidBrush(CLR_BTN_PRESS);
+        g_hpenBtnBorder = CreatePen(PS_SOLID, 1, CLR_BTN_BORDER);
+        g_hpenBtnFocus  = CreatePen(PS_SOLID, 1, CLR_BTN_FOCUS);
+        g_hbrAccent     = CreateSolidBrush(CLR_ACCENT);
+        g_hdcPreviewFrame = CreateCompatibleDC(nullptr);
+
         // Bold font for section headers
         NONCLIENTMETRICSW ncm = {};
         ncm.cbSize = sizeof(ncm);
@@ -1127,10 +2641,14 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
         // Init main list view (Title, Process, TopMost + checkboxes)
         {
             HWND hList = GetDlgItem(hDlg, IDC_WINDOW_LIST);
-            InitMainListViewColumns(hList);
+            InitWindowListColumns(hList);
             DWORD exStyle = LVS_EX_FULLROWSELECT | LVS_EX_CHECKBOXES
                           | LVS_EX_DOUBLEBUFFER;
             ListView_SetExtendedListViewStyle(hList, exStyle);
+            // Owner data: the checkbox state image comes from LVN_GETDISPINFO.
+            ListView_SetCallbackMask(hList, LVIS_STATEIMAGEMASK);
+            if (IconCacheInit(16, 16))
+                ListView_SetImageList(hList, IconCacheImageList(), LVSIL_SMALL);
             ListView_SetBkColor(hList, CLR_LIST_BG);
             ListView_SetTextBkColor(hList, CLR_LIST_BG);
             ListView_SetTextColor(hList, CLR_TEXT);
@@ -1163,14 +2681,14 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
             SetWindowLongPtrW(hBtn, GWL_STYLE, style);
         }
 
-        // Init process watch list view (single "Process" column)
+        // Init process watch list view (single "Rule" column)
         // LVS_EX_NOHORIZONTALSCROLL prevents the horizontal scrollbar from appearing.
         {
             HWND hList = GetDlgItem(hDlg, IDC_WATCH_LIST);
             LVCOLUMNW lvc = {};
             lvc.mask    = LVCF_TEXT | LVCF_WIDTH | LVCF_SUBITEM;
             lvc.cx      = 300;
-            lvc.pszText = const_cast<LPWSTR>(L"Process (exe name)");
+            lvc.pszText = const_cast<LPWSTR>(L"Rule (exe, glob or path | title= | include)");
             ListView_InsertColumn(hList, 0, &lvc);
             static const DWORD LVS_EX_NOHORIZONTALSCROLL = 0x04000000;
             ListView_SetExtendedListViewStyle(hList,
@@ -1185,32 +2703,55 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
         g_showDesktopPreview = true;
         CheckDlgButton(hDlg, IDC_CHK_SHOW_PREVIEW,
                        g_showDesktopPreview ? BST_CHECKED : BST_UNCHECKED);
+        // "Screen thumbnails" strip – default off.
+        g_showMonitorStrip = false;
+        CheckDlgButton(hDlg, IDC_CHK_MONITOR_STRIP, BST_UNCHECKED);
+        ShowWindow(GetDlgItem(hDlg, IDC_MONITOR_STRIP), SW_HIDE);
         // "Show cursor in preview" checkbox – default off; sync the atomic.
         g_captureShowCursor.store(
             IsDlgButtonChecked(hDlg, IDC_CHK_SHOW_CURSOR) == BST_CHECKED);
         // "Auto-unload DLL" checkbox – default on.
         g_autoUnloadDll = true;
         CheckDlgButton(hDlg, IDC_CHK_AUTO_UNLOAD, BST_CHECKED);
+        // "Keep DLL resident (agent)" checkbox – default off (opt-in).
+        g_residentAgent = false;
+        CheckDlgButton(hDlg, IDC_CHK_RESIDENT_AGENT, BST_UNCHECKED);
 
         // Load persisted settings (may override the defaults set above).
         LoadSettings(hDlg);
+        // Last session's rows that are still open, listed before any enumeration.
+        LoadWindowSnapshot(hDlg);
 
         // Tray icon
         CreateTrayIcon(hDlg);
 
-        // Start the two background worker threads.
-        g_injectorThread = std::thread(InjectorWorkerProc);
-        g_captureThread  = std::thread(CaptureWorkerProc);
-
-        // Request initial window enumeration (async).
-        g_injectorChannel.send(InjectorEvent{InjectorEventType::Update});
+        // Latency stats tooltip on the status bar
+        CreateStatsTooltip(hDlg);
 
-        // Process watch timer: fires every 2 s to check for new matching processes.
-        SetTimer(hDlg, IDT_WATCH, 2000, nullptr);
+        // Start the injector worker; the capture worker, the icons and the
+        // first watch sweep wait for IDT_STARTUP, after the first paint.
+        g_injectorThread = std::thread(InjectorWorkerProc);
 
-        // Start the initial screen preview if enabled (async).
+        // Window model: WinEvents keep it live; the initial enumeration and
+        // a periodic resync catch anything the hooks missed.
+        const bool hooked = InstallWinEventHooks();
+        g_injectorChannel.send(InjectorEvent{InjectorEventType::StartupList});
+        SetTimer(hDlg, IDT_WINDOW_RESYNC, 30000, nullptr);
+
+        // Process watch: one sweep at startup (Warmup), then the same
+        // WinEvents apply the rules to each new window as it appears.  The
+        // periodic sweep is only needed without the hooks.
+        OnWatchListChanged();
+        if (!hooked)
+            SetTimer(hDlg, IDT_WATCH, 10000, nullptr);
+
+        // Start the initial screen preview if enabled (queued until the
+        // capture worker starts).
         if (g_showDesktopPreview && !g_monitors.empty())
             SendCaptureEvent(0);
+        // WM_TIMER is only generated once no WM_PAINT is pending, so the
+        // deferred stage runs after the dialog has been drawn.
+        SetTimer(hDlg, IDT_STARTUP, USER_TIMER_MINIMUM, nullptr);
 
         // Trigger initial layout
         {
@@ -1226,19 +2767,19 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
     {
         if (LOWORD(wParam) == WA_INACTIVE) {
             g_hasFocus = false;
-            // Stop the screen preview while unfocused.
-            if (g_previewBmp) {
-                DeleteObject(g_previewBmp);
-                g_previewBmp = nullptr;
-            }
+            // Stop the screen preview (or window thumbnail) while unfocused.
+            UpdatePreviewMode(hDlg);
+            ClearPreviewFrame();
+            ClearStripFrame();
             SendStopCaptureEvent();
             ShowPlaceholder(hDlg);
         } else {
             g_hasFocus = true;
             HidePlaceholder(hDlg);
-            // Trigger async window-list refresh (Invisiwind: InjectorWorkerEvent::Update).
-            g_injectorChannel.send(InjectorEvent{InjectorEventType::Update});
-            // Restart screen preview if enabled (Invisiwind: CaptureWorkerEvent::Capture).
+            // No refresh needed: the window model keeps g_windows live.
+            // Restart screen preview if enabled (Invisiwind: CaptureWorkerEvent::Capture);
+            // a window thumbnail, if selected, takes precedence.
+            UpdatePreviewMode(hDlg);
             if (g_showDesktopPreview)
                 SendCaptureEvent(g_currentMonitor);
             UpdateSelectedInfo(hDlg);
@@ -1262,24 +2803,17 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
 
             // Off-screen buffer to avoid flicker
             int bw = rc.right - rc.left, bh = rc.bottom - rc.top;
-            HDC     hBuf    = CreateCompatibleDC(hDC);
-            HBITMAP hBufBmp = CreateCompatibleBitmap(hDC, bw, bh);
-            HGDIOBJ hBufOld = SelectObject(hBuf, hBufBmp);
+            HDC hBuf = g_buttonBuf.Get(hDC, bw, bh);
+            if (!hBuf) return TRUE;
 
             RECT rcBuf = { 0, 0, bw, bh };
-            COLORREF bgCol = pressed ? CLR_BTN_PRESS : CLR_BTN_BG;
-            HBRUSH hBrBg = CreateSolidBrush(bgCol);
-            FillRect(hBuf, &rcBuf, hBrBg);
-            DeleteObject(hBrBg);
-
-            COLORREF borderCol = focused ? CLR_BTN_FOCUS : CLR_BTN_BORDER;
-            HPEN hPen = CreatePen(PS_SOLID, 1, borderCol);
-            HGDIOBJ oldPen   = SelectObject(hBuf, hPen);
+            FillRect(hBuf, &rcBuf, pressed ? g_hbrBtnPress : g_hbrBtnBg);
+
+            HGDIOBJ oldPen   = SelectObject(hBuf, focused ? g_hpenBtnFocus : g_hpenBtnBorder);
             HGDIOBJ oldBrush = SelectObject(hBuf, GetStockObject(NULL_BRUSH));
             Rectangle(hBuf, 0, 0, bw, bh);
             SelectObject(hBuf, oldPen);
             SelectObject(hBuf, oldBrush);
-            DeleteObject(hPen);
 
             wchar_t text[256] = {};
             GetWindowTextW(di->hwndItem, text, 256);
@@ -1292,9 +2826,6 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
             SelectObject(hBuf, oldFont);
 
             BitBlt(hDC, rc.left, rc.top, bw, bh, hBuf, 0, 0, SRCCOPY);
-            SelectObject(hBuf, hBufOld);
-            DeleteObject(hBufBmp);
-            DeleteDC(hBuf);
             return TRUE;
         }
 
@@ -1302,9 +2833,7 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
         if (di->CtlType == ODT_STATIC &&
             (di->CtlID == IDC_SEP_1 || di->CtlID == IDC_SEP_2))
         {
-            HBRUSH hBr = CreateSolidBrush(CLR_SEP);
-            FillRect(di->hDC, &di->rcItem, hBr);
-            DeleteObject(hBr);
+            FillRect(di->hDC, &di->rcItem, g_hbrSep);
             return TRUE;
         }
 
@@ -1316,9 +2845,8 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
             int  dh  = rc.bottom - rc.top;
 
             // Double-buffer: render into off-screen DC, then blit once
-            HDC     hBuf    = CreateCompatibleDC(hDC);
-            HBITMAP hBufBmp = CreateCompatibleBitmap(hDC, dw, dh);
-            HGDIOBJ hBufOld = SelectObject(hBuf, hBufBmp);
+            HDC hBuf = g_previewBuf.Get(hDC, dw, dh);
+            if (!hBuf) return TRUE;
             RECT rcBuf = { 0, 0, dw, dh };
 
             FillRect(hBuf, &rcBuf, reinterpret_cast<HBRUSH>(GetStockObject(BLACK_BRUSH)));
@@ -1327,51 +2855,96 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
                 // Show ":)" placeholder when unfocused – no screen capture
                 SetBkMode(hBuf, TRANSPARENT);
                 SetTextColor(hBuf, CLR_SUBTEXT);
-                HFONT hBig = CreateFontW(dh / 2, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                    DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                    CLEARTYPE_QUALITY, DEFAULT_PITCH, L"Segoe UI");
-                HGDIOBJ oldF = SelectObject(hBuf, hBig);
+                if (!g_hFontPreviewPh || g_previewPhHeight != dh / 2) {
+                    if (g_hFontPreviewPh) DeleteObject(g_hFontPreviewPh);
+                    g_previewPhHeight = dh / 2;
+                    g_hFontPreviewPh  = CreateFontW(g_previewPhHeight, 0, 0, 0, FW_BOLD,
+                        FALSE, FALSE, FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
+                        CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, DEFAULT_PITCH, L"Segoe UI");
+                }
+                HGDIOBJ oldF = SelectObject(hBuf, g_hFontPreviewPh);
                 DrawTextW(hBuf, L":)", -1, &rcBuf, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
                 SelectObject(hBuf, oldF);
-                DeleteObject(hBig);
-            } else if (g_previewBmp && !g_monitors.empty()) {
+            } else if (g_previewFrame && !g_monitors.empty()) {
                 int mi = (g_currentMonitor < static_cast<int>(g_monitors.size()))
                          ? g_currentMonitor : 0;
-                const RECT& mr = g_monitors[mi];
-                int sw = mr.right  - mr.left;
-                int sh = mr.bottom - mr.top;
-                if (sw > 0 && sh > 0) {
-                    // Letterbox: preserve aspect ratio
-                    double srcAsp = static_cast<double>(sw) / sh;
-                    double dstAsp = static_cast<double>(dw) / dh;
-                    int drawW, drawH, drawX, drawY;
-                    if (dstAsp > srcAsp) {
-                        drawH = dh;
-                        drawW = static_cast<int>(dh * srcAsp);
-                        drawX = (dw - drawW) / 2;
-                        drawY = 0;
-                    } else {
-                        drawW = dw;
-                        drawH = static_cast<int>(dw / srcAsp);
-                        drawX = 0;
-                        drawY = (dh - drawH) / 2;
-                    }
-                    HDC     hMem = CreateCompatibleDC(hBuf);
-                    HGDIOBJ old  = SelectObject(hMem, g_previewBmp);
+                // Letterbox: preserve aspect ratio.  The worker renders at
+                // exactly this size, so this is a 1:1 blit except for the
+                // frame or two after a resize.
+                SIZE fit   = FitPreview(g_monitors[mi], SIZE{ dw, dh });
+                int  drawX = (dw - fit.cx) / 2;
+                int  drawY = (dh - fit.cy) / 2;
+                const PooledDib& f = *g_previewFrame;
+                HDC     hMem = g_hdcPreviewFrame;
+                HGDIOBJ old  = SelectObject(hMem, f.bmp);
+                if (fit.cx == f.width && fit.cy == f.height) {
+                    BitBlt(hBuf, drawX, drawY, f.width, f.height, hMem, 0, 0, SRCCOPY);
+                } else {
                     SetStretchBltMode(hBuf, HALFTONE);
                     SetBrushOrgEx(hBuf, 0, 0, nullptr);
-                    StretchBlt(hBuf, drawX, drawY, drawW, drawH,
-                               hMem, 0, 0, sw, sh, SRCCOPY);
-                    SelectObject(hMem, old);
-                    DeleteDC(hMem);
+                    StretchBlt(hBuf, drawX, drawY, fit.cx, fit.cy,
+                               hMem, 0, 0, f.width, f.height, SRCCOPY);
                 }
+                SelectObject(hMem, old);
+            } else if (g_stripFrame && g_currentMonitor < static_cast<int>(g_monitors.size())) {
+                // Just switched monitors: stretch the strip's thumbnail of the
+                // new one until its first full frame arrives.
+                const PooledDib& f = *g_stripFrame;
+                RECT thumb = StripThumbRect(g_monitors[g_currentMonitor],
+                    StripCell(g_currentMonitor, static_cast<int>(g_monitors.size()),
+                              SIZE{ f.width, f.height }));
+                SIZE fit   = FitPreview(g_monitors[g_currentMonitor], SIZE{ dw, dh });
+                HDC     hMem = g_hdcPreviewFrame;
+                HGDIOBJ old  = SelectObject(hMem, f.bmp);
+                SetStretchBltMode(hBuf, HALFTONE);
+                SetBrushOrgEx(hBuf, 0, 0, nullptr);
+                StretchBlt(hBuf, (dw - fit.cx) / 2, (dh - fit.cy) / 2, fit.cx, fit.cy,
+                           hMem, thumb.left, thumb.top, thumb.right - thumb.left,
+                           thumb.bottom - thumb.top, SRCCOPY);
+                SelectObject(hMem, old);
             }
 
             // Single blit to the real DC – no intermediate flash
             BitBlt(hDC, rc.left, rc.top, dw, dh, hBuf, 0, 0, SRCCOPY);
-            SelectObject(hBuf, hBufOld);
-            DeleteObject(hBufBmp);
-            DeleteDC(hBuf);
+            return TRUE;
+        }
+
+        // ---- Thumbnail strip: one cell per monitor, current one outlined ---
+        if (di->CtlType == ODT_STATIC && di->CtlID == IDC_MONITOR_STRIP) {
+            HDC  hDC = di->hDC;
+            RECT rc  = di->rcItem;
+            int  dw  = rc.right  - rc.left;
+            int  dh  = rc.bottom - rc.top;
+
+            HDC hBuf = g_stripBuf.Get(hDC, dw, dh);
+            if (!hBuf) return TRUE;
+            RECT rcBuf = { 0, 0, dw, dh };
+            FillRect(hBuf, &rcBuf, g_hbrBg);
+
+            const int count = static_cast<int>(g_monitors.size());
+            if (g_stripFrame && g_hasFocus) {
+                // The worker renders at exactly this size except for the
+                // frame or two after a resize.
+                const PooledDib& f = *g_stripFrame;
+                HDC     hMem = g_hdcPreviewFrame;
+                HGDIOBJ old  = SelectObject(hMem, f.bmp);
+                if (f.width == dw && f.height == dh) {
+                    BitBlt(hBuf, 0, 0, dw, dh, hMem, 0, 0, SRCCOPY);
+                } else {
+                    SetStretchBltMode(hBuf, HALFTONE);
+                    SetBrushOrgEx(hBuf, 0, 0, nullptr);
+                    StretchBlt(hBuf, 0, 0, dw, dh, hMem, 0, 0, f.width, f.height, SRCCOPY);
+                }
+                SelectObject(hMem, old);
+            }
+            if (g_currentMonitor < count) {
+                RECT thumb = StripThumbRect(g_monitors[g_currentMonitor],
+                    StripCell(g_currentMonitor, count, SIZE{ dw, dh }));
+                InflateRect(&thumb, 1, 1);
+                FrameRect(hBuf, &thumb, g_hbrAccent);
+            }
+
+            BitBlt(hDC, rc.left, rc.top, dw, dh, hBuf, 0, 0, SRCCOPY);
             return TRUE;
         }
         break;
@@ -1441,6 +3014,14 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
             AppendMenuW(hMenu, MF_STRING | (IsAutoStartEnabled() ? MF_CHECKED : 0),
                 IDM_TRAY_AUTOSTART, L"Start on Boot");
             AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
+            AppendMenuW(hMenu, MF_STRING | (g_unloadAllRunning ? MF_GRAYED : 0),
+                IDM_TRAY_UNLOAD_ALL, L"Unload DLL from All Processes");
+            AppendMenuW(hMenu, MF_STRING | (g_unloadAllOnExit ? MF_CHECKED : 0),
+                IDM_TRAY_UNLOAD_ON_EXIT, L"Unload DLL from All Processes on Exit");
+            AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
+            AppendMenuW(hMenu, MF_STRING | (g_captureCheck.load() ? MF_CHECKED : 0),
+                IDM_TRAY_CAPTURE_CHECK, L"Verify Exclusion in Captures");
+            AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
             AppendMenuW(hMenu, MF_STRING, IDM_TRAY_EXIT, L"Exit");
             SetForegroundWindow(hDlg);
             TrackPopupMenu(hMenu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, hDlg, nullptr);
@@ -1473,21 +3054,29 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
     {
         auto* pNMHDR = reinterpret_cast<LPNMHDR>(lParam);
 
+        // Status-bar tooltip: current latency stats
+        if (pNMHDR->hwndFrom == g_hStatsTip && pNMHDR->code == TTN_GETDISPINFOW) {
+            static std::wstring s_tipText;
+            std::string report = StatsReport();
+            s_tipText.assign(report.begin(), report.end());   // ASCII
+            s_tipText += L"\n\nClick the status bar to write these to the log.";
+            reinterpret_cast<LPNMTTDISPINFOW>(lParam)->lpszText = &s_tipText[0];
+            return TRUE;
+        }
+
         // Tab control: switch preview monitor
         if (pNMHDR->idFrom == IDC_TAB_SCREENS &&
             pNMHDR->code   == TCN_SELCHANGE)
         {
-            g_currentMonitor = TabCtrl_GetCurSel(
-                GetDlgItem(hDlg, IDC_TAB_SCREENS));
-            // Invisiwind: clicking a monitor tab sends CaptureWorkerEvent::Capture(*monitor)
-            if (g_showDesktopPreview)
-                SendCaptureEvent(g_currentMonitor);
+            SelectPreviewMonitor(hDlg, TabCtrl_GetCurSel(
+                GetDlgItem(hDlg, IDC_TAB_SCREENS)));
         }
 
         // Main window list notifications
         if (pNMHDR->idFrom == IDC_WINDOW_LIST) {
 
-            // NM_CUSTOMDRAW: tint hidden rows (dimmed text + subtle bg + accent Hidden col)
+            // NM_CUSTOMDRAW: tint hidden rows (dimmed text + subtle bg + accent Hidden col);
+            // a failed capture-leak check shows its Capture column in the same accent.
             if (pNMHDR->code == NM_CUSTOMDRAW) {
                 auto* pnmcd = reinterpret_cast<LPNMLVCUSTOMDRAW>(lParam);
                 DWORD stage = pnmcd->nmcd.dwDrawStage;
@@ -1506,6 +3095,11 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
                             pnmcd->clrText = CLR_SUBTEXT;
                             ret = CDRF_NOTIFYSUBITEMDRAW | CDRF_NEWFONT;
                         }
+                    } else if (idx >= 0 && idx < static_cast<int>(g_windows.size())
+                               && !(pnmcd->nmcd.uItemState & CDIS_SELECTED)
+                               && GetCaptureCheck(g_windows[idx].hwnd) == CaptureCheck::Visible)
+                    {
+                        ret = CDRF_NOTIFYSUBITEMDRAW;
                     }
                 } else if ((stage & CDDS_SUBITEM) && (stage & CDDS_ITEMPREPAINT)) {
                     int idx = static_cast<int>(pnmcd->nmcd.dwItemSpec);
@@ -1516,54 +3110,49 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
                         pnmcd->clrText   = (pnmcd->iSubItem == 3)
                                             ? CLR_HIDDEN_FG : CLR_SUBTEXT;
                         ret = CDRF_NEWFONT;
+                    } else if (idx >= 0 && idx < static_cast<int>(g_windows.size())) {
+                        pnmcd->clrText = (pnmcd->iSubItem == 4) ? CLR_HIDDEN_FG : CLR_TEXT;
+                        ret = CDRF_NEWFONT;
                     }
                 }
                 SetWindowLongPtrW(hDlg, DWLP_MSGRESULT, ret);
                 return TRUE;
             }
 
+            if (pNMHDR->code == LVN_GETDISPINFOW) {
+                GetWindowRowDispInfo(reinterpret_cast<NMLVDISPINFOW*>(lParam)->item);
+                return TRUE;
+            }
+
+            // Owner-data lists keep no checkbox state: toggle on a click on
+            // the state image or on Space.
+            if (pNMHDR->code == NM_CLICK) {
+                auto* pia = reinterpret_cast<LPNMITEMACTIVATE>(lParam);
+                LVHITTESTINFO ht = {};
+                ht.pt = pia->ptAction;
+                if (ListView_HitTest(pNMHDR->hwndFrom, &ht) >= 0
+                    && (ht.flags & LVHT_ONITEMSTATEICON))
+                    ToggleRowExclude(hDlg, ht.iItem);
+            }
+            if (pNMHDR->code == LVN_KEYDOWN
+                && reinterpret_cast<LPNMLVKEYDOWN>(lParam)->wVKey == VK_SPACE)
+            {
+                ToggleRowExclude(hDlg,
+                    ListView_GetNextItem(pNMHDR->hwndFrom, -1, LVNI_SELECTED));
+            }
+
+            // Selection change → remember the HWND, update info label
             if (pNMHDR->code == LVN_ITEMCHANGED && !g_populatingList) {
                 auto* pnm = reinterpret_cast<LPNMLISTVIEW>(lParam);
                 if (pnm->uChanged & LVIF_STATE) {
-                    // Detect checkbox toggle (state-image index changed)
-                    UINT oldImg = (pnm->uOldState & LVIS_STATEIMAGEMASK)
-                                  >> STATE_IMAGE_SHIFT;
-                    UINT newImg = (pnm->uNewState & LVIS_STATEIMAGEMASK)
-                                  >> STATE_IMAGE_SHIFT;
-                    if (oldImg != newImg &&
-                        oldImg != 0 && newImg != 0 &&
-                        pnm->iItem >= 0 &&
-                        pnm->iItem < static_cast<int>(g_windows.size()))
-                    {
-                        bool shouldExclude = (newImg == STATE_IMAGE_CHECKED);
-                        const WindowInfo& w = g_windows[pnm->iItem];
-                        DWORD affinity = shouldExclude ? WDA_EXCLUDEFROMCAPTURE : WDA_NONE;
-                        SetStatus(hDlg, L"Injecting \u2026");
-                        if (InjectWDASetAffinity(w.hwnd, affinity, g_autoUnloadDll)) {
-                            SetStatus(hDlg, shouldExclude
-                                ? L"ExcludeCapture enabled: \"" + w.title + L"\""
-                                : L"ExcludeCapture disabled: \"" + w.title + L"\"");
-                        } else {
-                            DWORD err = GetLastError();
-                            std::wstring errMsg =
-                                L"Injection failed (error "
-                                + std::to_wstring(err)
-                                + L"). Run as Administrator, ensure "
-                                  L"wda_inject_x64.dll / wda_inject_x86.dll and "
-                                  L"wda_launcher_x86.exe / wda_launcher_x64.exe "
-                                  L"are beside the exe. Check window_mod.log for details.";
-                            SetStatus(hDlg, errMsg);
-                            // Revert the checkbox
-                            g_populatingList = true;
-                            HWND hList = GetDlgItem(hDlg, IDC_WINDOW_LIST);
-                            ListView_SetCheckState(hList, pnm->iItem,
-                                !shouldExclude ? TRUE : FALSE);
-                            g_populatingList = false;
-                        }
-                    }
-                    // Selection change → update info label
-                    if (pnm->uNewState & LVIS_SELECTED)
+                    int row = ListView_GetNextItem(pNMHDR->hwndFrom, -1, LVNI_SELECTED);
+                    HWND hwnd = (row >= 0 && row < static_cast<int>(g_windows.size()))
+                              ? g_windows[row].hwnd : nullptr;
+                    if (hwnd != g_selectedHwnd) {
+                        g_selectedHwnd = hwnd;
                         UpdateSelectedInfo(hDlg);
+                        UpdatePreviewMode(hDlg);
+                    }
                 }
             }
         }
@@ -1582,8 +3171,8 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
 
         const WindowInfo& w = g_windows[sel];
         bool isHid     = w.isHidden;
-        bool isTopMost = !isHid && IsWindowTopMost(w.hwnd);
-        bool isExclude = !isHid && IsWindowExcludeFromCapture(w.hwnd);
+        bool isTopMost = !isHid && w.isTopMost;
+        bool isExclude = !isHid && w.isExcluded;
 
         HMENU hMenu = CreatePopupMenu();
         if (isHid) {
@@ -1620,13 +3209,9 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
             if (HideWindow(wi.hwnd)) {
                 wi.isHidden = true;
                 g_hiddenWindows.push_back(wi);
-                // Update the hidden column in place (no full re-enumeration)
-                g_populatingList = true;
-                ListView_SetItemText(hList, sel, 3,
-                    const_cast<LPWSTR>(L"\u25cf"));
-                // Clear checkbox for hidden windows
-                ListView_SetCheckState(hList, sel, FALSE);
-                g_populatingList = false;
+                // Hidden marker shown, checkbox cleared (no full re-enumeration)
+                RedrawWindowRow(hDlg, sel);
+                UpdatePreviewMode(hDlg);
                 SetStatus(hDlg, L"Hidden: \"" + wi.title + L"\"");
             } else {
                 SetStatus(hDlg, L"Failed to hide window.");
@@ -1645,7 +3230,7 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
                     std::remove_if(g_hiddenWindows.begin(), g_hiddenWindows.end(),
                         [&wi](const WindowInfo& h){ return h.hwnd == wi.hwnd; }),
                     g_hiddenWindows.end());
-                ListView_SetItemText(hList, sel, 3, const_cast<LPWSTR>(L""));
+                RedrawWindowRow(hDlg, sel);
                 break;
             }
             if (ShowWindowRestore(wi.hwnd)) {
@@ -1654,14 +3239,11 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
                     std::remove_if(g_hiddenWindows.begin(), g_hiddenWindows.end(),
                         [&wi](const WindowInfo& h){ return h.hwnd == wi.hwnd; }),
                     g_hiddenWindows.end());
-                g_populatingList = true;
-                ListView_SetItemText(hList, sel, 3, const_cast<LPWSTR>(L""));
-                // Restore TopMost column
-                ListView_SetItemText(hList, sel, 2,
-                    const_cast<LPWSTR>(IsWindowTopMost(wi.hwnd) ? L"\u2713" : L""));
-                g_populatingList = false;
+                wi.isTopMost = IsWindowTopMost(wi.hwnd);
+                RedrawWindowRow(hDlg, sel);
                 SetStatus(hDlg, L"Restored: \"" + wi.title + L"\"");
                 UpdateSelectedInfo(hDlg);
+                UpdatePreviewMode(hDlg);
             } else {
                 SetStatus(hDlg, L"Failed to show window.");
             }
@@ -1672,10 +3254,8 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
         {
             bool newState = !IsWindowTopMost(wi.hwnd);
             if (SetWindowTopMost(wi.hwnd, newState)) {
-                g_populatingList = true;
-                ListView_SetItemText(hList, sel, 2,
-                    const_cast<LPWSTR>(newState ? L"\u2713" : L""));
-                g_populatingList = false;
+                wi.isTopMost = newState;
+                RedrawWindowRow(hDlg, sel);
                 SetStatus(hDlg, newState
                     ? L"Set TOPMOST: \""     + wi.title + L"\""
                     : L"Removed TOPMOST: \"" + wi.title + L"\"");
@@ -1684,62 +3264,34 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
         }
 
         case IDM_CTX_EXCLUDE:
-        {
-            bool newExclude = !IsWindowExcludeFromCapture(wi.hwnd);
-            DWORD affinity = newExclude ? WDA_EXCLUDEFROMCAPTURE : WDA_NONE;
-            SetStatus(hDlg, L"Injecting \u2026");
-            if (InjectWDASetAffinity(wi.hwnd, affinity, g_autoUnloadDll)) {
-                // Sync the checkbox
-                g_populatingList = true;
-                ListView_SetCheckState(hList, sel, newExclude ? TRUE : FALSE);
-                g_populatingList = false;
-                SetStatus(hDlg, newExclude
-                    ? L"ExcludeCapture enabled: \""  + wi.title + L"\""
-                    : L"ExcludeCapture disabled: \"" + wi.title + L"\"");
-            } else {
-                SetStatus(hDlg, L"Injection failed (error "
-                          + std::to_wstring(GetLastError()) + L").");
-            }
+            ToggleRowExclude(hDlg, sel);
             break;
-        }
 
         case IDM_CTX_WATCH:
         {
-            std::wstring name = wi.processName;
-            if (name.empty()) { SetStatus(hDlg, L"No process name available."); break; }
-            {
-                std::lock_guard<std::mutex> lk(g_watchedExeMutex);
-                for (const auto& e : g_watchedExeNames)
-                    if (_wcsicmp(e.c_str(), name.c_str()) == 0) {
-                        SetStatus(hDlg, L"Already watching: " + name);
-                        goto done_ctx_watch;
-                    }
-                g_watchedExeNames.push_back(name);
-            }
-            {
-                HWND hWatchList = GetDlgItem(hDlg, IDC_WATCH_LIST);
-                LVITEMW lvi = {};
-                lvi.mask    = LVIF_TEXT;
-                lvi.iItem   = ListView_GetItemCount(hWatchList);
-                lvi.pszText = const_cast<LPWSTR>(name.c_str());
-                ListView_InsertItem(hWatchList, &lvi);
-            }
-            SetStatus(hDlg, L"Watching: " + name);
-            SaveSettings();
-        done_ctx_watch:;
+            if (wi.processName.empty()) { SetStatus(hDlg, L"No process name available."); break; }
+            WatchRule rule;
+            rule.pattern = wi.processName;
+            AddWatchRule(hDlg, rule);
             break;
         }
 
         case IDM_CTX_UNLOAD_DLL:
         {
             SetStatus(hDlg, L"Unloading DLL \u2026");
-            if (UnloadInjectedDll(wi.hwnd)) {
-                SetStatus(hDlg, L"DLL unloaded from: \"" + wi.title + L"\"");
-            } else {
-                SetStatus(hDlg, L"Unload failed (error "
-                          + std::to_wstring(GetLastError())
-                          + L"). Run as Administrator and check window_mod.log.");
-            }
+            // Queued behind any inject for the same process; the result
+            // comes back as WM_APP_UNLOAD_DONE so the UI thread never blocks.
+            const HWND hwnd = wi.hwnd;
+            SubmitPidJob(wi.pid, [hwnd]() {
+                DWORD err = ERROR_SUCCESS;
+                if (!UnloadInjectedDll(hwnd)) {
+                    err = GetLastError();
+                    if (err == ERROR_SUCCESS) err = ERROR_GEN_FAILURE;
+                }
+                if (HWND hDlg = g_hDlg)
+                    PostMessage(hDlg, WM_APP_UNLOAD_DONE, reinterpret_cast<WPARAM>(hwnd),
+                                static_cast<LPARAM>(err));
+            });
             break;
         }
         }
@@ -1753,11 +3305,27 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
 
         switch (id)
         {
+        case IDC_STATUS_TEXT:
+            if (HIWORD(wParam) == STN_CLICKED) {
+                StatsDumpToLog();
+                SetStatus(hDlg, L"Latency stats written to window_mod.log.");
+            }
+            break;
+
         case IDC_CHK_AUTO_UNLOAD:
             g_autoUnloadDll =
                 (IsDlgButtonChecked(hDlg, IDC_CHK_AUTO_UNLOAD) == BST_CHECKED);
             break;
 
+        case IDC_CHK_RESIDENT_AGENT:
+            g_residentAgent =
+                (IsDlgButtonChecked(hDlg, IDC_CHK_RESIDENT_AGENT) == BST_CHECKED);
+            // Auto-unload does not apply while the agent keeps the DLL loaded.
+            EnableWindow(GetDlgItem(hDlg, IDC_CHK_AUTO_UNLOAD), !g_residentAgent);
+            SetResidentAgentMode(g_residentAgent);
+            SaveSettings();
+            break;
+
         case IDC_CHK_SHOW_PREVIEW:
         {
             // Invisiwind: toggling "Show desktop preview" sends Capture or StopCapture.
@@ -1773,17 +3341,55 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
             if (g_showDesktopPreview) {
                 SendCaptureEvent(g_currentMonitor);
             } else {
-                // Clear existing preview bitmap immediately.
-                if (g_previewBmp) {
-                    DeleteObject(g_previewBmp);
-                    g_previewBmp = nullptr;
-                }
+                // Clear existing preview frame immediately.
+                ClearPreviewFrame();
+                ClearStripFrame();
                 SendStopCaptureEvent();
             }
             SaveSettings();
             break;
         }
 
+        case IDC_CHK_PREVIEW_WINDOW:
+            g_previewSelectedWindow =
+                (IsDlgButtonChecked(hDlg, IDC_CHK_PREVIEW_WINDOW) == BST_CHECKED);
+            UpdatePreviewMode(hDlg);
+            SaveSettings();
+            break;
+
+        case IDC_CHK_MONITOR_STRIP:
+            g_showMonitorStrip =
+                (IsDlgButtonChecked(hDlg, IDC_CHK_MONITOR_STRIP) == BST_CHECKED);
+            ShowPreviewControls(hDlg, g_showDesktopPreview);
+            {
+                RECT rc; GetClientRect(hDlg, &rc);
+                OnSize(hDlg, rc.right, rc.bottom);
+            }
+            if (!g_showMonitorStrip)
+                ClearStripFrame();
+            // Starts or stops the thumbnails with the preview's current monitor.
+            if (g_showDesktopPreview && g_hasFocus)
+                SendCaptureEvent(g_currentMonitor);
+            SaveSettings();
+            break;
+
+        case IDC_MONITOR_STRIP:
+            // Click on a thumbnail: switch the preview to that monitor.
+            if (HIWORD(wParam) == STN_CLICKED) {
+                HWND  hStrip = GetDlgItem(hDlg, IDC_MONITOR_STRIP);
+                POINT pt     = {};
+                RECT  rc     = {};
+                GetCursorPos(&pt);
+                ScreenToClient(hStrip, &pt);
+                GetClientRect(hStrip, &rc);
+                const int count = static_cast<int>(g_monitors.size());
+                for (int i = 0; i < count; ++i) {
+                    RECT cell = StripCell(i, count, SIZE{ rc.right, rc.bottom });
+                    if (PtInRect(&cell, pt)) { SelectPreviewMonitor(hDlg, i); break; }
+                }
+            }
+            break;
+
         case IDC_CHK_SHOW_CURSOR:
             // Keep the atomic in sync so the capture worker reads the new value
             // on the very next frame without any channel round-trip.
@@ -1794,36 +3400,15 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
 
         case IDC_BTN_WATCH_ADD:
         {
-            wchar_t buf[MAX_PATH] = {};
-            GetDlgItemTextW(hDlg, IDC_WATCH_EDIT, buf, MAX_PATH);
-            std::wstring name(buf);
-            // Trim whitespace
-            while (!name.empty() && iswspace(name.front())) name.erase(name.begin());
-            while (!name.empty() && iswspace(name.back()))  name.pop_back();
-            if (name.empty()) { SetStatus(hDlg, L"Enter an exe name to watch."); break; }
-
-            // Deduplicate (case-insensitive)
-            {
-                std::lock_guard<std::mutex> lk(g_watchedExeMutex);
-                for (const auto& e : g_watchedExeNames)
-                    if (_wcsicmp(e.c_str(), name.c_str()) == 0) {
-                        SetStatus(hDlg, L"Already watching: " + name);
-                        goto done_watch_add;
-                    }
-                g_watchedExeNames.push_back(name);
-            }
-            {
-                HWND hList = GetDlgItem(hDlg, IDC_WATCH_LIST);
-                LVITEMW lvi = {};
-                lvi.mask    = LVIF_TEXT;
-                lvi.iItem   = ListView_GetItemCount(hList);
-                lvi.pszText = const_cast<LPWSTR>(name.c_str());
-                ListView_InsertItem(hList, &lvi);
-            }
+            // "name.exe", "*meet*.exe", "C:\Apps\*.exe", optionally followed
+            // by "| title=GLOB" and "| include" (see WatchRuleFromText).
+            wchar_t buf[1024] = {};
+            GetDlgItemTextW(hDlg, IDC_WATCH_EDIT, buf, 1024);
+            WatchRule    rule;
+            std::wstring error;
+            if (!WatchRuleFromText(buf, rule, error)) { SetStatus(hDlg, error); break; }
             SetDlgItemTextW(hDlg, IDC_WATCH_EDIT, L"");
-            SetStatus(hDlg, L"Watching: " + name);
-            SaveSettings();
-        done_watch_add:;
+            AddWatchRule(hDlg, rule);
             break;
         }
 
@@ -1833,13 +3418,14 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
             int sel = ListView_GetNextItem(hList, -1, LVNI_SELECTED);
             if (sel < 0) { SetStatus(hDlg, L"No entry selected."); break; }
             {
-                std::lock_guard<std::mutex> lk(g_watchedExeMutex);
-                if (sel < static_cast<int>(g_watchedExeNames.size()))
-                    g_watchedExeNames.erase(g_watchedExeNames.begin() + sel);
+                std::lock_guard<std::mutex> lk(g_watchRulesMutex);
+                if (sel < static_cast<int>(g_watchRules.size()))
+                    g_watchRules.erase(g_watchRules.begin() + sel);
             }
             ListView_DeleteItem(hList, sel);
             SetStatus(hDlg, L"Watch entry removed.");
             SaveSettings();
+            OnWatchListChanged();
             break;
         }
 
@@ -1856,8 +3442,41 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
             SetAutoStart(!IsAutoStartEnabled());
             break;
 
+        case IDM_TRAY_UNLOAD_ALL:
+        {
+            if (g_unloadAllRunning) break;
+            g_unloadAllRunning = true;
+            SetStatus(hDlg, L"Unloading DLL from all processes \u2026");
+            // Runs on the inject pool; the result comes back as
+            // WM_APP_UNLOAD_ALL_DONE so the UI thread never blocks.
+            SubmitUnloadAll(UNLOAD_ALL_TIMEOUT_MS, [](const UnloadAllResult& r) {
+                HWND hDlg = g_hDlg;
+                auto* copy = new UnloadAllResult(r);
+                if (!hDlg || !PostMessage(hDlg, WM_APP_UNLOAD_ALL_DONE, 0,
+                                          reinterpret_cast<LPARAM>(copy)))
+                    delete copy;
+            });
+            break;
+        }
+
+        case IDM_TRAY_UNLOAD_ON_EXIT:
+            g_unloadAllOnExit = !g_unloadAllOnExit;
+            SaveSettings();
+            break;
+
+        case IDM_TRAY_CAPTURE_CHECK:
+            g_captureCheck = !g_captureCheck.load();
+            if (!g_captureCheck.load() && !g_captureChecks.empty()) {
+                // Results still in flight are ignored (see WM_APP_CAPTURE_CHECKED).
+                g_captureChecks.clear();
+                InvalidateRect(GetDlgItem(hDlg, IDC_WINDOW_LIST), nullptr, FALSE);
+            }
+            SaveSettings();
+            break;
+
         case IDM_TRAY_EXIT:
             RestoreAllHiddenWindows();
+            // Resident agents are shut down in WM_DESTROY, on the inject pool.
             DestroyTrayIcon();
             EndDialog(hDlg, 0);
             break;
@@ -1871,13 +3490,25 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
     }
 
     // --------------------------------------------------------------------
-    // Process watch timer: trigger a watch-check in the injector thread.
+    // Process watch timer (only without WinEvent hooks): trigger a watch-check
+    // in the injector thread.
+    // Window resync timer: full enumeration as a consistency check.
+    // Startup timer (once, after the first paint): start capturing, fetch the
+    // icons and run the first watch sweep.
     case WM_TIMER:
+        if (wParam == IDT_STARTUP) {
+            KillTimer(hDlg, IDT_STARTUP);
+            if (!g_captureThread.joinable())
+                g_captureThread = std::thread(CaptureWorkerProc);
+            g_injectorChannel.send(InjectorEvent{InjectorEventType::Warmup});
+        }
+        if (wParam == IDT_WINDOW_RESYNC)
+            g_injectorChannel.send(InjectorEvent{InjectorEventType::Update});
         if (wParam == IDT_WATCH) {
             bool hasEntries;
             {
-                std::lock_guard<std::mutex> lk(g_watchedExeMutex);
-                hasEntries = !g_watchedExeNames.empty();
+                std::lock_guard<std::mutex> lk(g_watchRulesMutex);
+                hasEntries = !g_watchRules.empty();
             }
             if (hasEntries)
                 g_injectorChannel.send(InjectorEvent{InjectorEventType::WatchCheck});
@@ -1889,44 +3520,208 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
     case WM_APP_WATCH_APPLIED:
     {
         WPARAM count = wParam;
-        SetStatus(hDlg, L"Watch: applied ExcludeCapture to "
+        SetStatus(hDlg, L"Watch: applied rules to windows of "
                         + std::to_wstring(count)
-                        + (count == 1 ? L" new process." : L" new processes."));
-        // Refresh the window list so the checkboxes reflect the new state.
-        g_injectorChannel.send(InjectorEvent{InjectorEventType::Update});
+                        + (count == 1 ? L" process." : L" processes."));
+        // The rows themselves are refreshed per window by the injector thread.
+        return TRUE;
+    }
+
+    // --------------------------------------------------------------------
+    // Inject pool: a checkbox / context-menu injection finished.  The row is
+    // looked up by HWND because the list may have been refreshed meanwhile.
+    case WM_APP_INJECT_DONE:
+    {
+        std::unique_ptr<InjectResult> res(reinterpret_cast<InjectResult*>(lParam));
+        if (!res || res->hwnds.empty()) return TRUE;
+
+        HWND  target  = res->hwnds[0];
+        bool  ok      = !res->ok.empty() && res->ok[0];
+        bool  exclude = (res->affinity == WDA_EXCLUDEFROMCAPTURE);
+
+        std::wstring title;
+        int row = FindWindowRow(target);
+        if (row >= 0) {
+            title = g_windows[row].title;
+            // Show the requested state on success, revert it on failure.
+            g_windows[row].isExcluded = (ok == exclude);
+            if (ok && res->affinity == WDA_NONE)
+                g_captureChecks.erase(target);   // back in captures: nothing to verify
+            RedrawWindowRow(hDlg, row);
+        }
+
+        if (ok) {
+            SetStatus(hDlg, exclude
+                ? L"ExcludeCapture enabled: \""  + title + L"\""
+                : L"ExcludeCapture disabled: \"" + title + L"\"");
+        } else {
+            SetStatus(hDlg, L"Injection failed (error "
+                      + std::to_wstring(res->lastError)
+                      + L"). Run as Administrator, ensure "
+                        L"wda_inject_x64.dll / wda_inject_x86.dll and "
+                        L"wda_launcher_x86.exe / wda_launcher_x64.exe "
+                        L"are beside the exe. Check window_mod.log for details.");
+        }
+        return TRUE;
+    }
+
+    // --------------------------------------------------------------------
+    // Capture thread: a capture-leak check started or finished for the
+    // window in wParam (lParam = CaptureCheck).
+    case WM_APP_CAPTURE_CHECKED:
+    {
+        HWND         target = reinterpret_cast<HWND>(wParam);
+        CaptureCheck state  = static_cast<CaptureCheck>(lParam);
+        if (!g_captureCheck.load()) return TRUE;   // turned off meanwhile
+
+        // Drop the results of windows that are gone.
+        for (auto it = g_captureChecks.begin(); it != g_captureChecks.end(); )
+            it = IsWindow(it->first) ? std::next(it) : g_captureChecks.erase(it);
+        if (state == CaptureCheck::None)
+            g_captureChecks.erase(target);
+        else
+            g_captureChecks[target] = state;
+
+        int row = FindWindowRow(target);
+        RedrawWindowRow(hDlg, row);
+        if (state == CaptureCheck::Visible) {
+            std::wstring title = (row >= 0) ? g_windows[row].title : FmtHandle(target);
+            SetStatus(hDlg, L"Capture check: \"" + title + L"\" is still visible in captures.");
+        }
+        return TRUE;
+    }
+
+    // --------------------------------------------------------------------
+    // Inject pool: context-menu "Unload DLL" finished.
+    case WM_APP_UNLOAD_DONE:
+    {
+        HWND  target = reinterpret_cast<HWND>(wParam);
+        DWORD err    = static_cast<DWORD>(lParam);
+        int   row    = FindWindowRow(target);
+        std::wstring title = (row >= 0) ? g_windows[row].title : FmtHandle(target);
+        if (err == ERROR_SUCCESS) {
+            SetStatus(hDlg, L"DLL unloaded from: \"" + title + L"\"");
+        } else {
+            SetStatus(hDlg, L"Unload failed (error " + std::to_wstring(err)
+                            + L"). Run as Administrator and check window_mod.log.");
+        }
+        return TRUE;
+    }
+
+    // --------------------------------------------------------------------
+    // Inject pool: "Unload DLL from All Processes" finished.
+    case WM_APP_UNLOAD_ALL_DONE:
+    {
+        std::unique_ptr<UnloadAllResult> res(reinterpret_cast<UnloadAllResult*>(lParam));
+        g_unloadAllRunning = false;
+        if (!res) return TRUE;
+
+        if (res->processes == 0) {
+            SetStatus(hDlg, L"No process has the DLL loaded.");
+        } else if (res->failed == 0 && res->unfinished == 0) {
+            SetStatus(hDlg, L"DLL unloaded from " + std::to_wstring(res->unloaded)
+                            + (res->unloaded == 1 ? L" process." : L" processes."));
+        } else {
+            SetStatus(hDlg, L"DLL unloaded from " + std::to_wstring(res->unloaded)
+                            + L" of " + std::to_wstring(res->processes)
+                            + L" processes (" + std::to_wstring(res->failed) + L" failed, "
+                            + std::to_wstring(res->unfinished)
+                            + L" timed out). Check window_mod.log for details.");
+        }
         return TRUE;
     }
 
     // --------------------------------------------------------------------
-    // Injector thread: window list ready – swap and refresh the ListView.
+    // Injector thread: window model changed – apply the deltas to g_windows.
     case WM_APP_WINDOWS_READY:
     {
-        std::vector<WindowInfo> newWindows;
+        std::vector<WindowDelta> deltas;
         {
-            std::lock_guard<std::mutex> lk(g_pendingWindowsMutex);
-            newWindows = std::move(g_pendingWindows);
+            std::lock_guard<std::mutex> lk(g_pendingDeltasMutex);
+            deltas.swap(g_pendingDeltas);
         }
-        // Build set of enumerated HWNDs
-        std::set<HWND> enumSet;
-        for (const auto& w : newWindows) enumSet.insert(w.hwnd);
+        if (deltas.empty()) return TRUE;
+
+        auto isOurHidden = [](HWND hwnd) {
+            for (const auto& h : g_hiddenWindows)
+                if (h.hwnd == hwnd) return true;
+            return false;
+        };
+        auto forgetHidden = [](HWND hwnd) {
+            g_hiddenWindows.erase(
+                std::remove_if(g_hiddenWindows.begin(), g_hiddenWindows.end(),
+                    [hwnd](const WindowInfo& h){ return h.hwnd == hwnd; }),
+                g_hiddenWindows.end());
+        };
+
+        // Rows at or below firstDirty moved or changed; the rest repaint
+        // only if they appear in `changed`.
+        int firstDirty = static_cast<int>(g_windows.size());
+        std::vector<HWND> changed;
+        bool iconReplaced = false;   // a shared image changed: repaint every row
+        for (auto& d : deltas) {
+            int row = FindWindowRow(d.info.hwnd);
+            g_seededWindows.erase(d.info.hwnd);
+
+            if (d.type == WindowDeltaType::Removed) {
+                if (row < 0) continue;
+                // Windows we hid stay listed (marked hidden) until they are
+                // restored or destroyed.
+                if (IsWindow(d.info.hwnd) && isOurHidden(d.info.hwnd)) {
+                    g_windows[row].isHidden = true;
+                    changed.push_back(d.info.hwnd);
+                } else {
+                    forgetHidden(d.info.hwnd);
+                    IconCacheRelease(d.info.hwnd);
+                    g_windows.erase(g_windows.begin() + row);
+                    firstDirty = (std::min)(firstDirty, row);
+                }
+                continue;
+            }
 
-        // Check if any hidden windows were shown by external means
-        // (they appear in the new enumeration → remove from g_hiddenWindows).
-        g_hiddenWindows.erase(
-            std::remove_if(g_hiddenWindows.begin(), g_hiddenWindows.end(),
-                [&enumSet](const WindowInfo& h){ return enumSet.count(h.hwnd) > 0; }),
-            g_hiddenWindows.end());
+            // Added / Changed.  A hidden window that shows up again was shown
+            // by external means → no longer ours to restore.
+            forgetHidden(d.info.hwnd);
+            if (row < 0) {
+                firstDirty = (std::min)(firstDirty, static_cast<int>(g_windows.size()));
+                IconCacheAcquire(d.info, &iconReplaced);
+                g_windows.push_back(std::move(d.info));
+            } else {
+                changed.push_back(d.info.hwnd);
+                IconCacheAcquire(d.info, &iconReplaced);   // cheap once the row has an icon
+                g_windows[row] = std::move(d.info);
+            }
+        }
 
-        // Append hidden windows (not in enumeration) with isHidden=true
-        g_windows = std::move(newWindows);
-        for (const auto& h : g_hiddenWindows) {
-            WindowInfo hi = h;
-            hi.isHidden = true;
-            g_windows.push_back(hi);
+        SyncWindowListCount(hDlg, iconReplaced ? 0 : firstDirty);
+        for (HWND hwnd : changed) {
+            int row = FindWindowRow(hwnd);
+            if (row >= 0 && row < firstDirty && !iconReplaced) RedrawWindowRow(hDlg, row);
         }
+        UpdateSelectedInfo(hDlg);
+        UpdatePreviewMode(hDlg);   // the selected window may be gone or hidden
+        return TRUE;
+    }
 
-        PopulateWindowList(hDlg);
+    // --------------------------------------------------------------------
+    // Injector thread: the startup enumeration has been published (its
+    // deltas were queued before this message).  Snapshot rows it did not
+    // list belong to windows that closed or were hidden meanwhile.
+    case WM_APP_WINDOWS_LISTED:
+    {
+        SendMessageW(hDlg, WM_APP_WINDOWS_READY, 0, 0);
+        if (g_seededWindows.empty()) return TRUE;
+        int firstDirty = static_cast<int>(g_windows.size());
+        for (HWND hwnd : g_seededWindows) {
+            int row = FindWindowRow(hwnd);
+            if (row < 0) continue;
+            g_windows.erase(g_windows.begin() + row);
+            firstDirty = (std::min)(firstDirty, row);
+        }
+        g_seededWindows.clear();
+        SyncWindowListCount(hDlg, firstDirty);
         UpdateSelectedInfo(hDlg);
+        UpdatePreviewMode(hDlg);
         return TRUE;
     }
 
@@ -1934,45 +3729,86 @@ INT_PTR CALLBACK DlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
     // Capture thread: new preview bitmap ready – swap and repaint.
     case WM_APP_PREVIEW_READY:
     {
-        HBITMAP newBmp = nullptr;
-        {
-            std::lock_guard<std::mutex> lk(g_pendingPreviewMutex);
-            newBmp = g_pendingPreviewBmp;
-            g_pendingPreviewBmp = nullptr;
-        }
-        if (newBmp) {
-            if (g_previewBmp) DeleteObject(g_previewBmp);
-            g_previewBmp = newBmp;
+        if (PooledDib* frame = g_pendingPreview.take()) {
+            if (frame->tag != g_previewTag) {   // the old monitor's, from before a switch
+                g_previewPool.Release(frame);
+                return TRUE;
+            }
+            ClearPreviewFrame();   // back to the pool for the next frame
+            g_previewFrame = frame;
             if (HWND hPrev = GetDlgItem(hDlg, IDC_PREVIEW_STATIC))
                 InvalidateRect(hPrev, nullptr, FALSE);
         }
         return TRUE;
     }
 
+    // --------------------------------------------------------------------
+    // Capture thread: new thumbnail strip ready – swap and repaint.
+    case WM_APP_STRIP_READY:
+    {
+        if (PooledDib* strip = g_pendingStrip.take()) {
+            ClearStripFrame();
+            g_stripFrame = strip;
+            if (HWND hStrip = GetDlgItem(hDlg, IDC_MONITOR_STRIP))
+                InvalidateRect(hStrip, nullptr, FALSE);
+            if (!g_previewFrame)   // the preview is showing a thumbnail
+                InvalidateRect(GetDlgItem(hDlg, IDC_PREVIEW_STATIC), nullptr, FALSE);
+        }
+        return TRUE;
+    }
+
     // --------------------------------------------------------------------
     case WM_DESTROY:
+        KillTimer(hDlg, IDT_STARTUP);
         KillTimer(hDlg, IDT_WATCH);
+        KillTimer(hDlg, IDT_WINDOW_RESYNC);
+        SaveWindowSnapshot();
+        RemoveWinEventHooks();
+        g_windowThumb.Stop();
         // Shut down worker threads cleanly before releasing GDI resources.
         g_hDlg = nullptr;   // prevent PostMessage from racing during teardown
         g_injectorChannel.send(InjectorEvent{InjectorEventType::Quit});
         g_captureChannel.send(CaptureEvent{CaptureEventType::Quit});
         if (g_injectorThread.joinable()) g_injectorThread.join();
         if (g_captureThread.joinable())  g_captureThread.join();
-        // Clean up any pending preview bitmap that was never consumed.
-        {
-            std::lock_guard<std::mutex> lk(g_pendingPreviewMutex);
-            if (g_pendingPreviewBmp) { DeleteObject(g_pendingPreviewBmp); g_pendingPreviewBmp = nullptr; }
-        }
+        g_captureChannel.close();   // late CheckAfter sends from the pool return at once
+        // Parallel on the inject pool, bounded by one short deadline: every
+        // process with the DLL, or at least those this session left an agent in.
+        if (g_unloadAllOnExit) UnloadFromAllProcesses(EXIT_UNLOAD_TIMEOUT_MS);
+        else                   UnloadFromProcesses(ResidentAgentPids(), EXIT_UNLOAD_TIMEOUT_MS);
+        // After the injector thread: no more submitters.  Abandoned jobs may
+        // still hold process handles, so the cache is left to process exit.
+        g_injectPoolAbandoned = !StopInjectPool(EXIT_POOL_TIMEOUT_MS);
+        if (!g_injectPoolAbandoned) ClearProcessCache();
+        // Return any pending preview frame that was never consumed, then
+        // free the pool (the capture thread is gone).
+        g_previewPool.Release(g_pendingPreview.take());
+        ClearPreviewFrame();
+        g_previewPool.Clear();
+        g_stripPool.Release(g_pendingStrip.take());
+        ClearStripFrame();
+        g_stripPool.Clear();
         if (g_hbrBg)            { DeleteObject(g_hbrBg);            g_hbrBg            = nullptr; }
         if (g_hbrListBg)        { DeleteObject(g_hbrListBg);        g_hbrListBg        = nullptr; }
         if (g_hFontBold)        { DeleteObject(g_hFontBold);        g_hFontBold        = nullptr; }
         if (g_hFontPlaceholder) { DeleteObject(g_hFontPlaceholder); g_hFontPlaceholder = nullptr; }
-        if (g_previewBmp)       { DeleteObject(g_previewBmp);       g_previewBmp       = nullptr; }
+        if (g_hFontPreviewPh)   { DeleteObject(g_hFontPreviewPh);   g_hFontPreviewPh   = nullptr; }
+        if (g_hStatsTip)        { DestroyWindow(g_hStatsTip);       g_hStatsTip        = nullptr; }
+        if (g_hFontMono)        { DeleteObject(g_hFontMono);        g_hFontMono        = nullptr; }
+        if (g_hbrSep)           { DeleteObject(g_hbrSep);           g_hbrSep           = nullptr; }
+        if (g_hbrBtnBg)         { DeleteObject(g_hbrBtnBg);         g_hbrBtnBg         = nullptr; }
+        if (g_hbrBtnPress)      { DeleteObject(g_hbrBtnPress);      g_hbrBtnPress      = nullptr; }
+        if (g_hpenBtnBorder)    { DeleteObject(g_hpenBtnBorder);    g_hpenBtnBorder    = nullptr; }
+        if (g_hpenBtnFocus)     { DeleteObject(g_hpenBtnFocus);     g_hpenBtnFocus     = nullptr; }
+        if (g_hbrAccent)        { DeleteObject(g_hbrAccent);        g_hbrAccent        = nullptr; }
+        if (g_hdcPreviewFrame)  { DeleteDC(g_hdcPreviewFrame);      g_hdcPreviewFrame  = nullptr; }
+        g_previewBuf.Destroy();
+        g_stripBuf.Destroy();
+        g_buttonBuf.Destroy();
         // Release the image list attached to the window list view.
-        if (HWND hList = GetDlgItem(hDlg, IDC_WINDOW_LIST)) {
-            HIMAGELIST hImgList = ListView_GetImageList(hList, LVSIL_SMALL);
-            if (hImgList) ImageList_Destroy(hImgList);
-        }
+        if (HWND hList = GetDlgItem(hDlg, IDC_WINDOW_LIST))
+            ListView_SetImageList(hList, nullptr, LVSIL_SMALL);
+        IconCacheDestroy();
         break;
 
     // --------------------------------------------------------------------
@@ -0,0 +1,196 @@
+#include "process_cache.h"
+#include <winternl.h>
+#include <tlhelp32.h>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+// Invalid (unopenable) entries are re-queried after this long, since without
+// a handle their exit cannot be observed.
+static const ULONGLONG PROCESS_CACHE_NEGATIVE_TTL_MS = 5000;
+
+// Exited processes are swept out at most this often.
+static const ULONGLONG PROCESS_CACHE_PRUNE_INTERVAL_MS = 1000;
+
+struct CacheEntry {
+    ProcessInfo info;
+    HANDLE      hProcess  = nullptr;   // SYNCHRONIZE; nullptr for invalid entries
+    ULONGLONG   queriedAt = 0;         // GetTickCount64() of the query
+};
+
+static std::mutex                             g_cacheMutex;
+static std::unordered_map<DWORD, CacheEntry>  g_cache;
+static ULONGLONG                              g_lastPrune = 0;
+
+// ---------------------------------------------------------------------------
+// Open pid and collect everything ProcessInfo holds.
+static CacheEntry QueryProcess(DWORD pid)
+{
+    CacheEntry e;
+    e.info.pid       = pid;
+    e.info.imageName = L"<unknown>";
+    e.queriedAt      = GetTickCount64();
+
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+    if (!hProcess)
+        return e;
+
+    FILETIME ftCreate = {}, ftExit = {}, ftKernel = {}, ftUser = {};
+    if (GetProcessTimes(hProcess, &ftCreate, &ftExit, &ftKernel, &ftUser))
+        e.info.createTime = (static_cast<ULONGLONG>(ftCreate.dwHighDateTime) << 32)
+                          | ftCreate.dwLowDateTime;
+
+    wchar_t path[MAX_PATH] = {};
+    DWORD   size = MAX_PATH;
+    if (QueryFullProcessImageNameW(hProcess, 0, path, &size)) {
+        e.info.imagePath = path;
+        auto pos = e.info.imagePath.rfind(L'\\');
+        e.info.imageName = (pos != std::wstring::npos)
+                         ? e.info.imagePath.substr(pos + 1) : e.info.imagePath;
+    }
+
+    BOOL wow64 = FALSE;
+    if (IsWow64Process(hProcess, &wow64))
+        e.info.isWow64 = (wow64 != FALSE);
+
+    HANDLE hToken = nullptr;
+    if (OpenProcessToken(hProcess, TOKEN_QUERY, &hToken)) {
+        TOKEN_ELEVATION elev = {};
+        DWORD len = 0;
+        if (GetTokenInformation(hToken, TokenElevation, &elev, sizeof(elev), &len))
+            e.info.isElevated = (elev.TokenIsElevated != 0);
+        CloseHandle(hToken);
+    }
+
+    e.info.valid = true;
+    e.hProcess   = hProcess;
+    return e;
+}
+
+static bool IsStale(const CacheEntry& e, ULONGLONG now)
+{
+    if (!e.hProcess)
+        return now - e.queriedAt >= PROCESS_CACHE_NEGATIVE_TTL_MS;
+    return WaitForSingleObject(e.hProcess, 0) != WAIT_TIMEOUT;   // exited
+}
+
+// Caller holds g_cacheMutex.
+static void PruneLocked(ULONGLONG now)
+{
+    for (auto it = g_cache.begin(); it != g_cache.end(); ) {
+        if (IsStale(it->second, now)) {
+            if (it->second.hProcess) CloseHandle(it->second.hProcess);
+            it = g_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    g_lastPrune = now;
+}
+
+// ---------------------------------------------------------------------------
+ProcessInfo GetProcessInfo(DWORD pid)
+{
+    const ULONGLONG now = GetTickCount64();
+    {
+        std::lock_guard<std::mutex> lk(g_cacheMutex);
+        if (now - g_lastPrune >= PROCESS_CACHE_PRUNE_INTERVAL_MS)
+            PruneLocked(now);
+
+        auto it = g_cache.find(pid);
+        if (it != g_cache.end()) {
+            if (!IsStale(it->second, now))
+                return it->second.info;
+            if (it->second.hProcess) CloseHandle(it->second.hProcess);
+            g_cache.erase(it);
+        }
+    }
+
+    // Query outside the lock; OpenProcess on a busy system is not free.
+    CacheEntry fresh = QueryProcess(pid);
+
+    std::lock_guard<std::mutex> lk(g_cacheMutex);
+    auto ins = g_cache.emplace(pid, fresh);
+    if (!ins.second) {
+        // Another thread cached it meanwhile; keep theirs.
+        if (fresh.hProcess) CloseHandle(fresh.hProcess);
+        return ins.first->second.info;
+    }
+    return fresh.info;
+}
+
+// ---------------------------------------------------------------------------
+void ClearProcessCache()
+{
+    std::lock_guard<std::mutex> lk(g_cacheMutex);
+    for (auto& kv : g_cache)
+        if (kv.second.hProcess) CloseHandle(kv.second.hProcess);
+    g_cache.clear();
+}
+
+// ---------------------------------------------------------------------------
+// Process snapshot
+
+#ifndef NT_SUCCESS
+#define NT_SUCCESS(status) (((NTSTATUS)(status)) >= 0)
+#endif
+#ifndef STATUS_INFO_LENGTH_MISMATCH
+#define STATUS_INFO_LENGTH_MISMATCH ((NTSTATUS)0xC0000004L)
+#endif
+
+typedef NTSTATUS (NTAPI* PFN_NtQuerySystemInformation)(
+    SYSTEM_INFORMATION_CLASS, PVOID, ULONG, PULONG);
+
+static bool SnapshotViaNtQuery(std::vector<ProcessEntry>& out)
+{
+    static PFN_NtQuerySystemInformation pfn =
+        reinterpret_cast<PFN_NtQuerySystemInformation>(
+            GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQuerySystemInformation"));
+    if (!pfn) return false;
+
+    // Reused between calls on the same thread; grown until the snapshot fits.
+    thread_local std::vector<BYTE> buf(256 * 1024);
+    NTSTATUS status = STATUS_INFO_LENGTH_MISMATCH;
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        ULONG needed = 0;
+        status = pfn(SystemProcessInformation, buf.data(),
+                     static_cast<ULONG>(buf.size()), &needed);
+        if (status != STATUS_INFO_LENGTH_MISMATCH) break;
+        // Processes may start between the two calls; leave headroom.
+        buf.resize(std::max<size_t>(buf.size() * 2, needed + 64 * 1024));
+    }
+    if (!NT_SUCCESS(status)) return false;
+
+    out.clear();
+    const BYTE* p = buf.data();
+    while (true) {
+        auto* spi = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION*>(p);
+        DWORD pid = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(spi->UniqueProcessId));
+        if (pid && spi->ImageName.Buffer)
+            out.push_back({ pid, std::wstring(spi->ImageName.Buffer,
+                                              spi->ImageName.Length / sizeof(wchar_t)) });
+        if (!spi->NextEntryOffset) break;
+        p += spi->NextEntryOffset;
+    }
+    return true;
+}
+
+static bool SnapshotViaToolhelp(std::vector<ProcessEntry>& out)
+{
+    HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (hSnap == INVALID_HANDLE_VALUE) return false;
+
+    out.clear();
+    PROCESSENTRY32W pe = {};
+    pe.dwSize = sizeof(pe);
+    for (BOOL ok = Process32FirstW(hSnap, &pe); ok; ok = Process32NextW(hSnap, &pe))
+        if (pe.th32ProcessID)
+            out.push_back({ pe.th32ProcessID, pe.szExeFile });
+    CloseHandle(hSnap);
+    return true;
+}
+
+bool SnapshotProcesses(std::vector<ProcessEntry>& out)
+{
+    return SnapshotViaNtQuery(out) || SnapshotViaToolhelp(out);
+}
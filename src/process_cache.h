@@ -0,0 +1,37 @@
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+
+/// Per-process facts that never change for the lifetime of a process.
+struct ProcessInfo {
+    DWORD        pid        = 0;
+    ULONGLONG    createTime = 0;      // creation FILETIME; (pid, createTime) names one process
+    std::wstring imagePath;           // full image path, empty if not queryable
+    std::wstring imageName;           // filename part, or L"<unknown>"
+    bool         isWow64    = false;  // 32-bit process on 64-bit Windows
+    bool         isElevated = false;  // token is elevated (TokenElevation)
+    bool         valid      = false;  // false if the process could not be opened
+};
+
+/// Return the cached info for pid, querying the process on first use.
+/// Thread-safe.  The cache keeps a SYNCHRONIZE handle to every live entry, so
+/// a PID cannot be reused while it is cached; entries are evicted as soon as
+/// their process has exited.  Processes that cannot be opened are cached as
+/// invalid for a few seconds.
+ProcessInfo GetProcessInfo(DWORD pid);
+
+/// Drop every entry and close the cached handles (e.g. on exit).
+void ClearProcessCache();
+
+/// One row of a system-wide process snapshot.
+struct ProcessEntry {
+    DWORD        pid;
+    std::wstring imageName;   // filename only, e.g. L"notepad.exe"
+};
+
+/// Fill `out` with every running process (PID 0 excluded) using a single
+/// NtQuerySystemInformation(SystemProcessInformation) call, falling back to a
+/// Toolhelp snapshot.  No process is opened.  Returns false if both fail.
+bool SnapshotProcesses(std::vector<ProcessEntry>& out);
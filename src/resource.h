@@ -18,12 +18,16 @@
 #define IDC_TAB_SCREENS         1063
 #define IDC_HIDE_APPS_LABEL     1064
 #define IDC_HIDE_APPS_SUB       1065
+#define IDC_CHK_PREVIEW_WINDOW  1066
 #define IDC_CHK_SHOW_CURSOR     1067
 #define IDC_PLACEHOLDER_LABEL   1068
 #define IDC_CHK_SHOW_PREVIEW    1069
+#define IDC_MONITOR_STRIP       1070
+#define IDC_CHK_MONITOR_STRIP   1073
 
 // DLL management controls
 #define IDC_CHK_AUTO_UNLOAD     1071
+#define IDC_CHK_RESIDENT_AGENT  1072
 
 // Process watch controls
 #define IDC_GRP_WATCH           1080
@@ -34,12 +38,17 @@
 
 // Timers
 #define IDT_WATCH               3
+#define IDT_WINDOW_RESYNC       4
+#define IDT_STARTUP             5
 
 // Tray icon
 #define WM_TRAYICON             (WM_USER + 1)
 #define IDM_TRAY_SHOW           2001
 #define IDM_TRAY_EXIT           2002
 #define IDM_TRAY_AUTOSTART      2003
+#define IDM_TRAY_UNLOAD_ALL     2004
+#define IDM_TRAY_UNLOAD_ON_EXIT 2005
+#define IDM_TRAY_CAPTURE_CHECK  2006
 
 // Window list context menu
 #define IDM_CTX_HIDE_WINDOW     3001
@@ -0,0 +1,157 @@
+#include "stats.h"
+
+#include <atomic>
+#include <cstdio>
+#include <spdlog/spdlog.h>
+
+// Bucket b < 4 holds exactly b µs; above that, octave [2^e, 2^(e+1)) is split
+// into 4 equal buckets.  40 octaves reach ~12 days, far beyond anything timed.
+static const int SUB_BUCKETS = 4;
+static const int OCTAVES     = 40;
+static const int BUCKETS     = SUB_BUCKETS * OCTAVES;
+
+struct Histogram {
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> max{0};
+};
+
+static Histogram g_histograms[static_cast<int>(Stat::Count)];
+
+static int BucketOf(uint64_t v)
+{
+    if (v < SUB_BUCKETS) return static_cast<int>(v);
+    int e = 63;
+    while (!(v >> e)) --e;                           // e >= 2
+    int sub = static_cast<int>((v >> (e - 2)) & 3);
+    int b   = (e - 1) * SUB_BUCKETS + sub;
+    return b < BUCKETS ? b : BUCKETS - 1;
+}
+
+// Largest value that falls in bucket b.
+static uint64_t BucketUpper(int b)
+{
+    if (b < SUB_BUCKETS) return static_cast<uint64_t>(b);
+    int      e     = b / SUB_BUCKETS + 1;
+    uint64_t sub   = static_cast<uint64_t>(b % SUB_BUCKETS);
+    uint64_t width = 1ull << (e - 2);
+    return (1ull << e) + (sub + 1) * width - 1;
+}
+
+// ---------------------------------------------------------------------------
+void StatsRecord(Stat stat, uint64_t micros)
+{
+    Histogram& h = g_histograms[static_cast<int>(stat)];
+    h.buckets[BucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    uint64_t cur = h.max.load(std::memory_order_relaxed);
+    while (micros > cur
+           && !h.max.compare_exchange_weak(cur, micros, std::memory_order_relaxed)) {
+    }
+}
+
+ScopedStat::~ScopedStat()
+{
+    static const LONGLONG freq = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return f.QuadPart;
+    }();
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&end);
+    LONGLONG ticks = end.QuadPart - start_.QuadPart;
+    if (ticks < 0) ticks = 0;
+    StatsRecord(stat_, static_cast<uint64_t>(ticks / freq * 1000000
+                                             + ticks % freq * 1000000 / freq));
+}
+
+StatSummary StatsGet(Stat stat)
+{
+    const Histogram& h = g_histograms[static_cast<int>(stat)];
+    uint64_t counts[BUCKETS];
+    uint64_t total = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        counts[b] = h.buckets[b].load(std::memory_order_relaxed);
+        total    += counts[b];
+    }
+
+    StatSummary s;
+    s.count = total;
+    s.max   = h.max.load(std::memory_order_relaxed);
+    if (!total) return s;
+
+    // Smallest bucket whose cumulative count reaches each rank; capped at the
+    // exact maximum so a bucket bound never exceeds a real sample.
+    auto percentile = [&](unsigned pct) {
+        uint64_t rank = (total * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += counts[b];
+            if (seen >= rank) {
+                uint64_t v = BucketUpper(b);
+                return v < s.max ? v : s.max;
+            }
+        }
+        return s.max;
+    };
+    s.p50 = percentile(50);
+    s.p95 = percentile(95);
+    s.p99 = percentile(99);
+    return s;
+}
+
+const char* StatName(Stat stat)
+{
+    switch (stat) {
+    case Stat::EnumerateWindows:        return "EnumerateWindows";
+    case Stat::PopulateWindowList:      return "PopulateWindowList";
+    case Stat::CaptureFrame:            return "CaptureFrame";
+    case Stat::CaptureCheck:            return "CaptureCheck";
+    case Stat::InjectTotal:             return "Inject (total)";
+    case Stat::InjectAgentCall:         return "  agent call";
+    case Stat::InjectOpenProcess:       return "  OpenProcess";
+    case Stat::InjectFindRemoteDll:     return "  FindRemoteDll";
+    case Stat::InjectRemoteLoadLibrary: return "  RemoteLoadLibrary";
+    case Stat::InjectVerify:            return "  verify";
+    case Stat::InjectUnload:            return "  unload";
+    case Stat::SpawnLauncher:           return "  SpawnLauncher";
+    case Stat::Count:                   break;
+    }
+    return "?";
+}
+
+// "850us", "12.3ms", "1.20s"
+static std::string FormatMicros(uint64_t us)
+{
+    char buf[32];
+    if (us < 1000)
+        snprintf(buf, sizeof(buf), "%lluus", static_cast<unsigned long long>(us));
+    else if (us < 1000000)
+        snprintf(buf, sizeof(buf), "%.1fms", us / 1000.0);
+    else
+        snprintf(buf, sizeof(buf), "%.2fs", us / 1000000.0);
+    return buf;
+}
+
+std::string StatsReport()
+{
+    std::string out;
+    for (int i = 0; i < static_cast<int>(Stat::Count); ++i) {
+        StatSummary s = StatsGet(static_cast<Stat>(i));
+        if (!s.count) continue;
+        char line[160];
+        snprintf(line, sizeof(line), "%-20s n=%-6llu p50 %-8s p95 %-8s p99 %-8s max %s\n",
+                 StatName(static_cast<Stat>(i)), static_cast<unsigned long long>(s.count),
+                 FormatMicros(s.p50).c_str(), FormatMicros(s.p95).c_str(),
+                 FormatMicros(s.p99).c_str(), FormatMicros(s.max).c_str());
+        out += line;
+    }
+    if (out.empty()) return "No timings recorded yet.";
+    out.pop_back();   // trailing newline
+    return out;
+}
+
+void StatsDumpToLog()
+{
+    spdlog::info("Latency stats:\n{}", StatsReport());
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <windows.h>
+#include <cstdint>
+#include <string>
+
+/// Timed operations.  Keep StatName() in stats.cpp in sync.
+enum class Stat {
+    EnumerateWindows,        // window_list: one full enumeration
+    PopulateWindowList,      // main: rebuild of the virtual list
+    CaptureFrame,            // capture worker: one takeFrame tick
+    CaptureCheck,            // capture worker: one capture-leak grab or comparison
+    InjectTotal,             // injector: ApplyEntriesToPid for one process
+    InjectAgentCall,         //   resident-agent round trip
+    InjectOpenProcess,
+    InjectFindRemoteDll,
+    InjectRemoteLoadLibrary,
+    InjectVerify,            //   reading back / verifying per-HWND results
+    InjectUnload,            //   FreeLibrary or agent shutdown after applying
+    SpawnLauncher,           //   one-shot cross-arch launcher process
+    Count
+};
+
+/// Record one sample, in microseconds.  Lock-free and wait-free: each
+/// operation has a fixed log-scale histogram (4 buckets per power of two,
+/// so percentiles are within 25%) of relaxed atomic counters, plus an exact
+/// maximum.  Safe from any thread.
+void StatsRecord(Stat stat, uint64_t micros);
+
+/// Times the enclosing scope into `stat`.
+class ScopedStat {
+public:
+    explicit ScopedStat(Stat stat) : stat_(stat) { QueryPerformanceCounter(&start_); }
+    ~ScopedStat();
+    ScopedStat(const ScopedStat&) = delete;
+    ScopedStat& operator=(const ScopedStat&) = delete;
+
+private:
+    Stat          stat_;
+    LARGE_INTEGER start_;
+};
+
+struct StatSummary {
+    uint64_t count = 0;
+    uint64_t p50 = 0, p95 = 0, p99 = 0, max = 0;   // microseconds
+};
+
+/// Snapshot of one histogram (counts read while others may be recording).
+StatSummary StatsGet(Stat stat);
+
+/// Display name, e.g. "EnumerateWindows".
+const char* StatName(Stat stat);
+
+/// One line per operation with samples: count, p50 / p95 / p99 / max.
+/// "No timings recorded yet." when there are none.  ASCII only.
+std::string StatsReport();
+
+/// Write StatsReport() to the log at info level.
+void StatsDumpToLog();
@@ -0,0 +1,155 @@
+#include "tile_diff.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "cpu_features.h"
+
+static const size_t TILE_BYTES = static_cast<size_t>(TILE_DIFF_SIZE) * 4;   // one tile row
+
+// ---------------------------------------------------------------------------
+// Add the sum of absolute differences of one image row to the per-tile sums:
+// sums[t] += SAD of bytes [t * TILE_BYTES, (t + 1) * TILE_BYTES) of the row.
+// `bytes` is the row length (width * 4); the last tile may be partial.
+
+typedef void (*SadRowFn)(const uint8_t* a, const uint8_t* b, size_t bytes, uint32_t* sums);
+
+static uint32_t SadScalar(const uint8_t* a, const uint8_t* b, size_t bytes)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        sum += static_cast<uint32_t>(a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]);
+    return sum;
+}
+
+static void SadRowScalar(const uint8_t* a, const uint8_t* b, size_t bytes, uint32_t* sums)
+{
+    for (size_t off = 0; off < bytes; off += TILE_BYTES, ++sums) {
+        size_t n = (bytes - off < TILE_BYTES) ? bytes - off : TILE_BYTES;
+        *sums += SadScalar(a + off, b + off, n);
+    }
+}
+
+#ifdef CPU_X86
+CPU_TARGET_SSE2
+static void SadRowSse2(const uint8_t* a, const uint8_t* b, size_t bytes, uint32_t* sums)
+{
+    size_t off = 0;
+    // Full tiles: 128 bytes = 8 × _mm_sad_epu8, each leaving two 64-bit sums.
+    for (; off + TILE_BYTES <= bytes; off += TILE_BYTES, ++sums) {
+        __m128i acc = _mm_setzero_si128();
+        for (size_t i = 0; i < TILE_BYTES; i += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + off + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + off + i));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+        }
+        acc = _mm_add_epi64(acc, _mm_srli_si128(acc, 8));
+        *sums += static_cast<uint32_t>(_mm_cvtsi128_si32(acc));
+    }
+    if (off < bytes)
+        *sums += SadScalar(a + off, b + off, bytes - off);
+}
+
+CPU_TARGET_AVX2
+static void SadRowAvx2(const uint8_t* a, const uint8_t* b, size_t bytes, uint32_t* sums)
+{
+    size_t off = 0;
+    // Full tiles: 4 × _mm256_sad_epu8 (four 64-bit sums each).
+    for (; off + TILE_BYTES <= bytes; off += TILE_BYTES, ++sums) {
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t i = 0; i < TILE_BYTES; i += 32) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + off + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + off + i));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+        }
+        __m128i s = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        s = _mm_add_epi64(s, _mm_srli_si128(s, 8));
+        *sums += static_cast<uint32_t>(_mm_cvtsi128_si32(s));
+    }
+    if (off < bytes)
+        *sums += SadScalar(a + off, b + off, bytes - off);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+
+struct TileDiffImpl {
+    const char* name;
+    SadRowFn    sadRow;
+};
+
+static const TileDiffImpl s_scalarImpl = { "scalar", SadRowScalar };
+#ifdef CPU_X86
+static const TileDiffImpl s_sse2Impl   = { "sse2",   SadRowSse2 };
+static const TileDiffImpl s_avx2Impl   = { "avx2",   SadRowAvx2 };
+#endif
+
+static const TileDiffImpl* const s_impls[CPU_LEVEL_COUNT] = {
+    &s_scalarImpl,
+#ifdef CPU_X86
+    &s_sse2Impl,
+    &s_avx2Impl,
+#else
+    nullptr,
+    nullptr,
+#endif
+};
+
+static const TileDiffImpl* g_impl = CpuDetectImpl(s_impls);
+
+const char* TileDiffImplName()
+{
+    return g_impl->name;
+}
+
+bool TileDiffSelectImpl(const char* name)
+{
+    const TileDiffImpl* want = CpuFindImpl(s_impls, name);
+    if (!want) return false;
+    g_impl = want;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+size_t CountDifferentTiles(const uint8_t* a, const uint8_t* b, int width, int height,
+                           size_t stride, unsigned threshold, const uint8_t* skip)
+{
+    if (width <= 0 || height <= 0) return 0;
+    const int    cols     = TileDiffCols(width);
+    const int    rows     = TileDiffRows(height);
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+
+    // One band of tiles at a time; a tile's sum stays below 2^32
+    // (32 × 128 bytes × 255).  Scratch is per thread.
+    thread_local std::vector<uint32_t> sums;
+    sums.resize(cols);
+
+    size_t different = 0;
+    for (int ty = 0; ty < rows; ++ty) {
+        const int y0 = ty * TILE_DIFF_SIZE;
+        const int th = (height - y0 < TILE_DIFF_SIZE) ? height - y0 : TILE_DIFF_SIZE;
+        const uint8_t* skipRow = skip ? skip + static_cast<size_t>(ty) * cols : nullptr;
+
+        // A band that is skipped entirely costs nothing.
+        if (skipRow) {
+            int tx = 0;
+            while (tx < cols && skipRow[tx]) ++tx;
+            if (tx == cols) continue;
+        }
+
+        std::fill(sums.begin(), sums.end(), 0u);
+        for (int y = y0; y < y0 + th; ++y) {
+            const size_t off = static_cast<size_t>(y) * stride;
+            g_impl->sadRow(a + off, b + off, rowBytes, sums.data());
+        }
+        for (int tx = 0; tx < cols; ++tx) {
+            if (skipRow && skipRow[tx]) continue;
+            const int    tw    = (width - tx * TILE_DIFF_SIZE < TILE_DIFF_SIZE)
+                               ? width - tx * TILE_DIFF_SIZE : TILE_DIFF_SIZE;
+            const uint64_t limit = static_cast<uint64_t>(threshold) * tw * th * 4;
+            if (sums[tx] > limit) ++different;
+        }
+    }
+    return different;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Tile-by-tile comparison of two same-sized top-down 32-bit images, used by
+/// the capture-leak check to tell whether a window's pixels are still in a
+/// capture after it was excluded.
+///
+/// Each TILE × TILE tile is reduced to the sum of absolute byte differences
+/// between the two images (SSE2 / AVX2 SAD, picked once at runtime like the
+/// downscaler) and counts as different when the mean difference per byte is
+/// above `threshold`, so capture noise and a blinking caret do not count.
+static const int TILE_DIFF_SIZE      = 32;
+static const unsigned TILE_DIFF_THRESHOLD = 8;
+
+/// Tiles across and down for a width × height image (partial tiles count).
+inline int TileDiffCols(int width)  { return (width  + TILE_DIFF_SIZE - 1) / TILE_DIFF_SIZE; }
+inline int TileDiffRows(int height) { return (height + TILE_DIFF_SIZE - 1) / TILE_DIFF_SIZE; }
+
+/// Number of tiles that differ between a and b (both width × height, `stride`
+/// bytes per row).  `skip`, if given, holds TileDiffCols × TileDiffRows bytes
+/// in row-major order; tiles with a non-zero entry are not compared.
+size_t CountDifferentTiles(const uint8_t* a, const uint8_t* b, int width, int height,
+                           size_t stride, unsigned threshold = TILE_DIFF_THRESHOLD,
+                           const uint8_t* skip = nullptr);
+
+/// Kernel selected for this CPU: "avx2", "sse2" or "scalar".
+const char* TileDiffImplName();
+
+/// Force a kernel ("avx2", "sse2", "scalar"), e.g. to compare them in a
+/// benchmark.  Returns false (and keeps the current one) if the CPU does not
+/// support it.
+bool TileDiffSelectImpl(const char* name);
@@ -0,0 +1,79 @@
+#include "tile_hash.h"
+#include <algorithm>
+#include <cstring>
+
+static inline uint64_t Mix(uint64_t h, uint64_t v)
+{
+    h ^= v;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+// Fold `bytes` (a multiple of 4) into h.  Four independent lanes keep the
+// multiplies from serialising.
+static uint64_t HashSpan(uint64_t h, const uint8_t* p, size_t bytes)
+{
+    uint64_t a = h, b = ~h, c = h + 1, d = h - 1;
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        uint64_t w[4];
+        memcpy(w, p + i, sizeof(w));
+        a = Mix(a, w[0]);
+        b = Mix(b, w[1]);
+        c = Mix(c, w[2]);
+        d = Mix(d, w[3]);
+    }
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        a = Mix(a, w);
+    }
+    if (i < bytes) {
+        uint32_t w;
+        memcpy(&w, p + i, sizeof(w));
+        b = Mix(b, w);
+    }
+    return Mix(Mix(a, b), Mix(c, d));
+}
+
+// ---------------------------------------------------------------------------
+size_t TileHasher::Update(const uint8_t* pixels, int width, int height, size_t stride)
+{
+    if (width <= 0 || height <= 0) {
+        Reset();
+        return 0;
+    }
+    const int tilesX = (width  + TILE - 1) / TILE;
+    const int tilesY = (height + TILE - 1) / TILE;
+    current_.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+
+    // Walk the image row by row (sequential memory access), folding each
+    // row's span of every tile into that tile's hash.
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row  = pixels + static_cast<size_t>(y) * stride;
+        uint64_t*      hash = &current_[static_cast<size_t>(y / TILE) * tilesX];
+        for (int tx = 0; tx < tilesX; ++tx) {
+            int x0 = tx * TILE;
+            int x1 = (std::min)(x0 + TILE, width);
+            hash[tx] = HashSpan(hash[tx], row + static_cast<size_t>(x0) * 4,
+                                static_cast<size_t>(x1 - x0) * 4);
+        }
+    }
+
+    size_t changed = current_.size();
+    if (width == width_ && height == height_ && hashes_.size() == current_.size()) {
+        changed = 0;
+        for (size_t i = 0; i < current_.size(); ++i)
+            changed += (current_[i] != hashes_[i]);
+    }
+    width_  = width;
+    height_ = height;
+    hashes_.swap(current_);
+    return changed;
+}
+
+void TileHasher::Reset()
+{
+    width_ = height_ = 0;
+    hashes_.clear();
+}
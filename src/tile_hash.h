@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Cheap change detection for the BitBlt preview path: the image is split into
+/// TILE × TILE pixel tiles, each tile is reduced to a 64-bit hash, and the
+/// hashes are compared with those of the previous image.  Reading the image
+/// once costs far less than downscaling, posting and repainting it, so an
+/// unchanged screen can be skipped before any of that happens.
+///
+/// Not thread-safe: owned by the capture thread.
+class TileHasher {
+public:
+    static const int TILE = 64;
+
+    /// Hash a top-down 32-bit image and compare with the previous call.
+    /// Returns the number of tiles that changed; every tile counts as changed
+    /// on the first call and after Reset() or a size change.
+    size_t Update(const uint8_t* pixels, int width, int height, size_t stride);
+
+    /// Forget the previous image (the next Update reports a full change).
+    void Reset();
+
+private:
+    int                   width_  = 0;
+    int                   height_ = 0;
+    std::vector<uint64_t> hashes_;   // previous image, row-major tiles
+    std::vector<uint64_t> current_;  // scratch for the image being hashed
+};
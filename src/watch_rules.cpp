@@ -0,0 +1,308 @@
+#include "watch_rules.h"
+#include <algorithm>
+#include <cwchar>
+#include <deque>
+
+#ifndef WDA_MONITOR
+#define WDA_MONITOR 0x00000001
+#endif
+
+// ---------------------------------------------------------------------------
+std::wstring WatchLower(std::wstring s)
+{
+    if (!s.empty())
+        CharLowerBuffW(&s[0], static_cast<DWORD>(s.size()));
+    return s;
+}
+
+static std::wstring Trim(const std::wstring& s)
+{
+    size_t b = 0, e = s.size();
+    while (b < e && iswspace(s[b]))     ++b;
+    while (e > b && iswspace(s[e - 1])) --e;
+    return s.substr(b, e - b);
+}
+
+static std::vector<std::wstring> Split(const std::wstring& s, wchar_t sep)
+{
+    std::vector<std::wstring> parts;
+    size_t start = 0;
+    for (;;) {
+        size_t pos = s.find(sep, start);
+        parts.push_back(s.substr(start, pos - start));
+        if (pos == std::wstring::npos) break;
+        start = pos + 1;
+    }
+    return parts;
+}
+
+// ---------------------------------------------------------------------------
+// Iterative wildcard match: on a mismatch, only the most recent '*' is
+// widened by one character, which is enough for '*' / '?' globs and keeps the
+// cost at O(pattern * text) in the worst case with no recursion.
+bool WatchGlobMatch(const std::wstring& g, const std::wstring& t, bool pathMode)
+{
+    size_t gi = 0, ti = 0;
+    size_t star = std::wstring::npos, mark = 0;
+    while (ti < t.size()) {
+        const bool sep = pathMode && t[ti] == L'\\';
+        if (gi < g.size() && (g[gi] == t[ti] || (g[gi] == L'?' && !sep))) {
+            ++gi; ++ti;
+        } else if (gi < g.size() && g[gi] == L'*') {
+            star = gi++;
+            mark = ti;
+        } else if (star != std::wstring::npos && !(pathMode && t[mark] == L'\\')) {
+            gi = star + 1;
+            ti = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while (gi < g.size() && g[gi] == L'*') ++gi;
+    return gi == g.size();
+}
+
+// ---------------------------------------------------------------------------
+bool WatchRuleFromText(const std::wstring& text, WatchRule& out, std::wstring& error)
+{
+    std::vector<std::wstring> fields = Split(text, L'|');
+    WatchRule rule;
+    rule.pattern = Trim(fields[0]);
+    if (rule.pattern.empty() || rule.pattern.find(L'\t') != std::wstring::npos) {
+        error = L"Enter an exe name, glob or path to watch.";
+        return false;
+    }
+    for (size_t i = 1; i < fields.size(); ++i) {
+        std::wstring f     = Trim(fields[i]);
+        std::wstring lower = WatchLower(f);
+        if (lower == L"exclude") {
+            rule.affinity = WDA_EXCLUDEFROMCAPTURE;
+        } else if (lower == L"include") {
+            rule.affinity = WDA_NONE;
+        } else if (lower == L"monitor") {
+            rule.affinity = WDA_MONITOR;
+        } else if (lower.compare(0, 6, L"title=") == 0) {
+            rule.titleFilter = Trim(f.substr(6));
+        } else if (lower.compare(0, 2, L"0x") == 0 && lower.size() > 2) {
+            rule.affinity = static_cast<DWORD>(wcstoul(lower.c_str(), nullptr, 16));
+        } else {
+            error = L"Unknown watch rule field: " + f;
+            return false;
+        }
+    }
+    if (rule.titleFilter.find(L'\t') != std::wstring::npos) {
+        error = L"A title filter cannot contain a tab.";
+        return false;
+    }
+    out = std::move(rule);
+    return true;
+}
+
+std::wstring WatchRuleToText(const WatchRule& rule)
+{
+    std::wstring text = rule.pattern;
+    if (!rule.titleFilter.empty())
+        text += L" | title=" + rule.titleFilter;
+    switch (rule.affinity) {
+    case WDA_EXCLUDEFROMCAPTURE:                     break;
+    case WDA_NONE:    text += L" | include";         break;
+    case WDA_MONITOR: text += L" | monitor";         break;
+    default: {
+        wchar_t hex[16];
+        swprintf(hex, 16, L" | 0x%X", rule.affinity);
+        text += hex;
+        break;
+    }
+    }
+    return text;
+}
+
+// ---------------------------------------------------------------------------
+std::wstring WatchRuleToRow(const WatchRule& rule)
+{
+    wchar_t hex[16];
+    swprintf(hex, 16, L"%X", rule.affinity);
+    return rule.pattern + L'\t' + hex + L'\t' + rule.titleFilter;
+}
+
+bool WatchRuleFromRow(const std::wstring& row, WatchRule& out)
+{
+    std::vector<std::wstring> cols = Split(row, L'\t');
+    if (cols[0].empty()) return false;
+    WatchRule rule;
+    rule.pattern = cols[0];
+    if (cols.size() > 1 && !cols[1].empty())
+        rule.affinity = static_cast<DWORD>(wcstoul(cols[1].c_str(), nullptr, 16));
+    if (cols.size() > 2)
+        rule.titleFilter = cols[2];
+    out = std::move(rule);
+    return true;
+}
+
+bool SameWatchTarget(const WatchRule& a, const WatchRule& b)
+{
+    return _wcsicmp(a.pattern.c_str(), b.pattern.c_str()) == 0
+        && _wcsicmp(a.titleFilter.c_str(), b.titleFilter.c_str()) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// WatchRuleSet
+// ---------------------------------------------------------------------------
+WatchRuleSet::WatchRuleSet(std::vector<WatchRule> rules)
+    : rules_(std::move(rules))
+{
+    ac_.emplace_back();   // root
+
+    compiled_.resize(rules_.size());
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        const int idx = static_cast<int>(i);
+        Compiled& c   = compiled_[i];
+        std::wstring lower = WatchLower(rules_[i].pattern);
+        size_t slash = lower.rfind(L'\\');
+        if (slash != std::wstring::npos) {
+            c.pathGlob = lower;
+            c.nameGlob = lower.substr(slash + 1);
+        } else {
+            c.nameGlob = lower;
+        }
+        c.titleGlob = WatchLower(rules_[i].titleFilter);
+        if (!c.titleGlob.empty()) hasTitleFilters_ = true;
+
+        if (c.nameGlob.find_first_of(L"*?") == std::wstring::npos) {
+            exact_[c.nameGlob].push_back(idx);
+            continue;
+        }
+
+        // Anchor: the longest wildcard-free run of the file-name glob.
+        size_t bestPos = 0, bestLen = 0;
+        for (size_t pos = 0; pos < c.nameGlob.size(); ) {
+            size_t end = c.nameGlob.find_first_of(L"*?", pos);
+            if (end == std::wstring::npos) end = c.nameGlob.size();
+            if (end - pos > bestLen) { bestPos = pos; bestLen = end - pos; }
+            pos = end + 1;
+        }
+        if (bestLen == 0) {
+            always_.push_back(idx);
+            continue;
+        }
+        int node = 0;
+        for (size_t k = bestPos; k < bestPos + bestLen; ++k) {
+            wchar_t ch   = c.nameGlob[k];
+            int     next = AcChild(node, ch);
+            if (next < 0) {
+                next = static_cast<int>(ac_.size());
+                ac_.emplace_back();
+                auto& edges = ac_[node].next;
+                edges.insert(std::lower_bound(edges.begin(), edges.end(),
+                                              std::make_pair(ch, 0)),
+                             std::make_pair(ch, next));
+            }
+            node = next;
+        }
+        ac_[node].out.push_back(idx);
+    }
+
+    // Breadth-first: a node's failure link is the longest proper suffix of
+    // its string that is also in the trie.
+    std::deque<int> queue;
+    for (const auto& e : ac_[0].next) queue.push_back(e.second);
+    while (!queue.empty()) {
+        int u = queue.front();
+        queue.pop_front();
+        for (const auto& e : ac_[u].next) {
+            int v = e.second;
+            int f = ac_[u].fail;
+            int w = AcChild(f, e.first);
+            while (w < 0 && f != 0) {
+                f = ac_[f].fail;
+                w = AcChild(f, e.first);
+            }
+            if (u == 0 || w < 0) w = 0;
+            ac_[v].fail    = w;
+            ac_[v].outLink = !ac_[w].out.empty() ? w : ac_[w].outLink;
+            queue.push_back(v);
+        }
+    }
+}
+
+int WatchRuleSet::AcChild(int node, wchar_t c) const
+{
+    const auto& edges = ac_[node].next;
+    auto it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(c, 0));
+    return (it != edges.end() && it->first == c) ? it->second : -1;
+}
+
+bool WatchRuleSet::Verify(int index, const std::wstring& name,
+                          const std::function<std::wstring()>& imagePath,
+                          std::wstring& path, bool& pathFetched) const
+{
+    const Compiled& c = compiled_[index];
+    if (!WatchGlobMatch(c.nameGlob, name)) return false;
+    if (c.pathGlob.empty()) return true;
+    if (!pathFetched) {
+        path        = imagePath ? WatchLower(imagePath()) : std::wstring();
+        pathFetched = true;
+    }
+    return !path.empty() && WatchGlobMatch(c.pathGlob, path, /*pathMode=*/true);
+}
+
+void WatchRuleSet::MatchProcess(const std::wstring& imageName,
+                                const std::function<std::wstring()>& imagePath,
+                                std::vector<int>& out) const
+{
+    out.clear();
+    if (rules_.empty() || imageName.empty() || imageName == L"<unknown>") return;
+
+    const std::wstring name = WatchLower(imageName);
+    std::vector<int> candidates(always_);
+
+    auto it = exact_.find(name);
+    if (it != exact_.end())
+        candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+
+    if (ac_.size() > 1) {
+        int node = 0;
+        for (wchar_t ch : name) {
+            int next = AcChild(node, ch);
+            while (next < 0 && node != 0) {
+                node = ac_[node].fail;
+                next = AcChild(node, ch);
+            }
+            node = (next < 0) ? 0 : next;
+            for (int n = ac_[node].out.empty() ? ac_[node].outLink : node; n >= 0;
+                 n = ac_[n].outLink)
+                candidates.insert(candidates.end(), ac_[n].out.begin(), ac_[n].out.end());
+        }
+    }
+    if (candidates.empty()) return;
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::wstring path;
+    bool         pathFetched = false;
+    for (int idx : candidates)
+        if (Verify(idx, name, imagePath, path, pathFetched))
+            out.push_back(idx);
+}
+
+bool WatchRuleSet::NeedsTitle(const std::vector<int>& candidates) const
+{
+    for (int idx : candidates)
+        if (!compiled_[idx].titleGlob.empty()) return true;
+    return false;
+}
+
+const WatchRule* WatchRuleSet::MatchWindow(const std::vector<int>& candidates,
+                                           const std::wstring& title) const
+{
+    std::wstring lowerTitle;
+    bool         lowered = false;
+    for (int idx : candidates) {
+        const Compiled& c = compiled_[idx];
+        if (c.titleGlob.empty()) return &rules_[idx];
+        if (!lowered) { lowerTitle = WatchLower(title); lowered = true; }
+        if (WatchGlobMatch(c.titleGlob, lowerTitle)) return &rules_[idx];
+    }
+    return nullptr;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <windows.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "window_ops.h"
+
+/// One Process Watch rule.
+///
+/// `pattern` is matched case-insensitively against the process image: a plain
+/// file name (`obs64.exe`), a glob (`*meet*.exe`; `*` matches any run, `?` one
+/// character) or, when it contains a backslash, a glob over the full image
+/// path (`C:\Program Files\Zoom\*.exe`, where a wildcard never spans a
+/// backslash).  Windows of a matching process get
+/// `affinity` if their title also matches `titleFilter` (same glob syntax;
+/// empty matches every window).
+struct WatchRule {
+    std::wstring pattern;
+    DWORD        affinity = WDA_EXCLUDEFROMCAPTURE;
+    std::wstring titleFilter;
+};
+
+/// Text form shown in the watch list and accepted by the watch edit box:
+///
+///   PATTERN [| title=GLOB] [| exclude | include | monitor]
+///
+/// e.g. `*meet*.exe | title=*Meet* | exclude`.  The affinity defaults to
+/// exclude.  Returns false and sets `error` for an empty pattern or an
+/// unknown field.
+bool WatchRuleFromText(const std::wstring& text, WatchRule& out, std::wstring& error);
+std::wstring WatchRuleToText(const WatchRule& rule);
+
+/// Registry form (one REG_MULTI_SZ row per rule): "pattern\taffinity\ttitle",
+/// affinity in hex.  WatchRuleFromRow also accepts a bare exe name (the old
+/// WatchedExeNames rows) as an exclude rule.
+std::wstring WatchRuleToRow(const WatchRule& rule);
+bool WatchRuleFromRow(const std::wstring& row, WatchRule& out);
+
+/// True if a and b select the same windows (pattern and title filter compared
+/// case-insensitively); the affinity is ignored.
+bool SameWatchTarget(const WatchRule& a, const WatchRule& b);
+
+/// The watch list compiled for matching, built once whenever the list changes
+/// and then shared read-only between threads.
+///
+/// Rules whose file-name part has no wildcard go into a hash map keyed by that
+/// name.  The other rules are indexed by the longest literal run of their
+/// file-name glob in one Aho-Corasick automaton, so a single scan of the image
+/// name yields the few globs that can match, which are then verified.  Globs
+/// with no literal at all are always verified.  Matching cost therefore
+/// depends on the length of the name and the number of candidates, not on the
+/// size of the list.
+class WatchRuleSet {
+public:
+    WatchRuleSet() = default;
+    explicit WatchRuleSet(std::vector<WatchRule> rules);
+
+    bool   empty() const { return rules_.empty(); }
+    size_t size()  const { return rules_.size(); }
+    const WatchRule& rule(int index) const { return rules_[index]; }
+
+    /// True if any rule has a title filter (title changes then matter).
+    bool HasTitleFilters() const { return hasTitleFilters_; }
+
+    /// Indices of the rules whose pattern matches the process, in list order
+    /// (cleared first).  imagePath is only called, at most once, when a
+    /// full-path rule is a candidate; it may return an empty string.
+    void MatchProcess(const std::wstring& imageName,
+                      const std::function<std::wstring()>& imagePath,
+                      std::vector<int>& out) const;
+
+    /// True if any of `candidates` has a title filter.
+    bool NeedsTitle(const std::vector<int>& candidates) const;
+
+    /// The first of `candidates` (from MatchProcess) whose title filter
+    /// matches `title`, or nullptr.  An earlier rule in the list wins.
+    const WatchRule* MatchWindow(const std::vector<int>& candidates,
+                                 const std::wstring& title) const;
+
+private:
+    struct Compiled {
+        std::wstring nameGlob;    // lower-case file-name part of the pattern
+        std::wstring pathGlob;    // lower-case full pattern for path rules, else empty
+        std::wstring titleGlob;   // lower-case title filter
+    };
+    struct AcNode {
+        std::vector<std::pair<wchar_t, int>> next;   // sorted by character
+        int              fail    = 0;
+        int              outLink = -1;   // nearest fail-chain node with outputs
+        std::vector<int> out;            // rules whose anchor ends here
+    };
+
+    int  AcChild(int node, wchar_t c) const;
+    bool Verify(int index, const std::wstring& name,
+                const std::function<std::wstring()>& imagePath,
+                std::wstring& path, bool& pathFetched) const;
+
+    std::vector<WatchRule>                            rules_;
+    std::vector<Compiled>                             compiled_;
+    std::unordered_map<std::wstring, std::vector<int>> exact_;   // literal file name
+    std::vector<AcNode>                               ac_;        // ac_[0] is the root
+    std::vector<int>                                  always_;    // globs with no literal
+    bool                                              hasTitleFilters_ = false;
+};
+
+/// Glob match (`*`, `?`) of an already lower-cased pattern against lower-cased
+/// text.  With pathMode the wildcards do not match a backslash, so `*` stays
+/// within one path component.
+bool WatchGlobMatch(const std::wstring& lowerGlob, const std::wstring& lowerText,
+                    bool pathMode = false);
+
+/// Lower-case a string the way file names compare (CharLowerBuffW).
+std::wstring WatchLower(std::wstring s);
@@ -1,66 +1,100 @@
 #include "window_list.h"
-#include <psapi.h>
+#include "process_cache.h"
+#include "window_ops.h"
+#include "stats.h"
 
 std::wstring GetProcessName(DWORD pid)
 {
-    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-    if (!hProcess)
-        return L"<unknown>";
-
-    wchar_t path[MAX_PATH] = {};
-    DWORD   size = MAX_PATH;
-    if (!QueryFullProcessImageNameW(hProcess, 0, path, &size)) {
-        CloseHandle(hProcess);
-        return L"<unknown>";
-    }
-    CloseHandle(hProcess);
-
-    // Return only the filename portion.
-    std::wstring full(path);
-    auto pos = full.rfind(L'\\');
-    return (pos != std::wstring::npos) ? full.substr(pos + 1) : full;
+    // Served from the process cache: one OpenProcess per process instead of
+    // one per window on every refresh.
+    return GetProcessInfo(pid).imageName;
 }
 
 struct EnumCtx {
     std::vector<WindowInfo>* list;
     HWND                     skipHwnd; // our own dialog – skip it
+    ULONGLONG                deadline; // GetTickCount64() after which no message is sent
 };
 
-static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam)
+// WM_GETICON with a time limit.  Returns false if the window did not answer
+// (hung or timed out); hIcon is then left untouched.
+static bool GetWindowIconTimeout(HWND hwnd, WPARAM type, DWORD timeoutMs, HICON& hIcon)
 {
-    auto* ctx = reinterpret_cast<EnumCtx*>(lParam);
+    DWORD_PTR result = 0;
+    if (!SendMessageTimeoutW(hwnd, WM_GETICON, type, 0,
+                             SMTO_ABORTIFHUNG | SMTO_BLOCK, timeoutMs, &result))
+        return false;
+    hIcon = reinterpret_cast<HICON>(result);
+    return true;
+}
 
+bool QueryWindowInfo(HWND hwnd, WindowInfo& out, DWORD msgTimeoutMs)
+{
     if (!IsWindowVisible(hwnd))
-        return TRUE;
-    if (hwnd == ctx->skipHwnd)
-        return TRUE;
+        return false;
 
+    // InternalGetWindowText reads the stored title and never sends WM_GETTEXT.
     wchar_t title[256] = {};
-    GetWindowTextW(hwnd, title, 256);
+    InternalGetWindowText(hwnd, title, 256);
     if (title[0] == L'\0')
-        return TRUE;
+        return false;
 
     DWORD pid = 0;
     GetWindowThreadProcessId(hwnd, &pid);
 
     // Try to get the window's small icon (do not destroy – shared handle).
-    HICON hIcon = reinterpret_cast<HICON>(
-        SendMessageW(hwnd, WM_GETICON, ICON_SMALL2, 0));
-    if (!hIcon)
-        hIcon = reinterpret_cast<HICON>(
-            SendMessageW(hwnd, WM_GETICON, ICON_SMALL, 0));
+    // Both requests share msgTimeoutMs (the caller's share of the
+    // enumeration budget): the ICON_SMALL fallback only gets what the first
+    // one left, and is not sent at all once that is spent.
+    HICON hIcon   = nullptr;
+    bool  pending = (msgTimeoutMs == 0) || IsHungAppWindow(hwnd);
+    if (!pending) {
+        const ULONGLONG deadline = GetTickCount64() + msgTimeoutMs;
+        pending = !GetWindowIconTimeout(hwnd, ICON_SMALL2, msgTimeoutMs, hIcon);
+        if (!pending && !hIcon) {
+            ULONGLONG now = GetTickCount64();
+            pending = (now >= deadline)
+                   || !GetWindowIconTimeout(hwnd, ICON_SMALL,
+                                            static_cast<DWORD>(deadline - now), hIcon);
+        }
+    }
     if (!hIcon)
         hIcon = reinterpret_cast<HICON>(
             GetClassLongPtrW(hwnd, GCLP_HICONSM));
 
-    ctx->list->push_back({ hwnd, title, GetProcessName(pid), pid, hIcon });
+    out = { hwnd, title, GetProcessName(pid), pid, hIcon };
+    out.isTopMost  = IsWindowTopMost(hwnd);
+    out.isExcluded = IsWindowExcludeFromCapture(hwnd);
+    out.isPending  = pending;
+    return true;
+}
+
+static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam)
+{
+    auto* ctx = reinterpret_cast<EnumCtx*>(lParam);
+
+    if (hwnd == ctx->skipHwnd)
+        return TRUE;
+
+    // Whatever is left of the budget, capped per window.
+    ULONGLONG now     = GetTickCount64();
+    DWORD     timeout = 0;
+    if (now < ctx->deadline)
+        timeout = static_cast<DWORD>(ctx->deadline - now);
+    if (timeout > WINDOW_QUERY_TIMEOUT_MS)
+        timeout = WINDOW_QUERY_TIMEOUT_MS;
+
+    WindowInfo info;
+    if (QueryWindowInfo(hwnd, info, timeout))
+        ctx->list->push_back(std::move(info));
     return TRUE;
 }
 
-std::vector<WindowInfo> EnumerateWindows(HWND skipHwnd)
+std::vector<WindowInfo> EnumerateWindows(HWND skipHwnd, DWORD budgetMs)
 {
+    ScopedStat timer(Stat::EnumerateWindows);
     std::vector<WindowInfo> windows;
-    EnumCtx ctx{ &windows, skipHwnd };
+    EnumCtx ctx{ &windows, skipHwnd, GetTickCount64() + budgetMs };
     EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&ctx));
     return windows;
 }
@@ -5,19 +5,42 @@
 #include <vector>
 
 struct WindowInfo {
-    HWND        hwnd;
+    HWND        hwnd = nullptr;
     std::wstring title;
     std::wstring processName;
-    DWORD       pid;
-    HICON       hIcon;     // small icon, nullptr if none
+    DWORD       pid  = 0;
+    HICON       hIcon = nullptr; // small icon, nullptr if none
+    bool        isTopMost  = false; // WS_EX_TOPMOST (sampled off the UI thread)
+    bool        isExcluded = false; // WDA_EXCLUDEFROMCAPTURE (sampled off the UI thread)
     bool        isHidden = false; // true when we've hidden this window
+    bool        isPending = false; // icon not fetched (owner hung / budget spent); retried later
 };
 
+/// Longest a single window may take to answer WM_GETICON.
+static const DWORD WINDOW_QUERY_TIMEOUT_MS = 100;
+
+/// Total time one enumeration may spend waiting on other processes; windows
+/// reached after it is spent are listed as pending without being asked.
+static const DWORD WINDOW_ENUM_BUDGET_MS = 500;
+
+/// Fill `out` for one top-level window.  Returns false if the window would not
+/// be listed (invisible or untitled).  The title is read without sending a
+/// message; the icon requests (ICON_SMALL2, then ICON_SMALL) wait at most
+/// msgTimeoutMs in total (0 = do not ask) and are abandoned if the owner is
+/// hung or the time runs out, in which case the class icon is used and
+/// out.isPending is set.
+bool QueryWindowInfo(HWND hwnd, WindowInfo& out,
+                     DWORD msgTimeoutMs = WINDOW_QUERY_TIMEOUT_MS);
+
 /// Return a snapshot of all visible top-level windows that have a title.
+/// Finishes in bounded time: at most WINDOW_ENUM_BUDGET_MS is spent waiting.
 std::vector<WindowInfo> EnumerateWindows();
 
-/// Same, but omit skipHwnd (e.g. our own dialog).
-std::vector<WindowInfo> EnumerateWindows(HWND skipHwnd);
+/// Same, but omit skipHwnd (e.g. our own dialog) and spend at most budgetMs
+/// waiting on other processes.
+std::vector<WindowInfo> EnumerateWindows(HWND skipHwnd,
+                                         DWORD budgetMs = WINDOW_ENUM_BUDGET_MS);
 
-/// Return just the filename (e.g. "notepad.exe") for the given process id.
+/// Return just the filename (e.g. "notepad.exe") for the given process id,
+/// or L"<unknown>".  Cached per process (see process_cache.h).
 std::wstring GetProcessName(DWORD pid);
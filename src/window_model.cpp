@@ -0,0 +1,95 @@
+#include "window_model.h"
+#include <algorithm>
+#include <unordered_set>
+
+// Fields a delta reports; isHidden is UI-side state and not compared.
+static bool SameListing(const WindowInfo& a, const WindowInfo& b)
+{
+    return a.title == b.title && a.processName == b.processName
+        && a.pid == b.pid && a.hIcon == b.hIcon
+        && a.isTopMost == b.isTopMost && a.isExcluded == b.isExcluded
+        && a.isPending == b.isPending;
+}
+
+// ---------------------------------------------------------------------------
+void WindowModel::Update(HWND hwnd, bool listable, WindowInfo&& info,
+                         std::vector<WindowDelta>& out)
+{
+    auto it = windows_.find(hwnd);
+    if (!listable) {
+        if (it == windows_.end()) return;
+        WindowDelta d;
+        d.type      = WindowDeltaType::Removed;
+        d.info.hwnd = hwnd;
+        windows_.erase(it);
+        out.push_back(std::move(d));
+        return;
+    }
+
+    if (it == windows_.end()) {
+        windows_.emplace(hwnd, info);
+        out.push_back({ WindowDeltaType::Added, std::move(info) });
+    } else if (!SameListing(it->second, info)) {
+        it->second = info;
+        out.push_back({ WindowDeltaType::Changed, std::move(info) });
+    }
+}
+
+// ---------------------------------------------------------------------------
+void WindowModel::Resync(std::vector<WindowDelta>& out, DWORD budgetMs)
+{
+    std::vector<WindowInfo> fresh = EnumerateWindows(nullptr, budgetMs);
+
+    std::unordered_set<HWND> seen;
+    seen.reserve(fresh.size());
+    for (auto& w : fresh) {
+        seen.insert(w.hwnd);
+        HWND hwnd = w.hwnd;
+        Update(hwnd, true, std::move(w), out);
+    }
+
+    // Windows whose destroy / hide event was missed.
+    std::vector<HWND> gone;
+    for (const auto& kv : windows_)
+        if (!seen.count(kv.first)) gone.push_back(kv.first);
+    for (HWND hwnd : gone)
+        Update(hwnd, false, WindowInfo{}, out);
+}
+
+// ---------------------------------------------------------------------------
+void WindowModel::Refresh(HWND hwnd, DWORD winEvent, std::vector<WindowDelta>& out)
+{
+    WindowInfo info;
+    bool listable = (winEvent != EVENT_OBJECT_DESTROY)
+                 && IsWindow(hwnd) && QueryWindowInfo(hwnd, info);
+    Update(hwnd, listable, std::move(info), out);
+}
+
+// ---------------------------------------------------------------------------
+bool WindowModel::RetryPending(std::vector<WindowDelta>& out)
+{
+    std::vector<HWND> pending;
+    for (const auto& kv : windows_)
+        if (kv.second.isPending) pending.push_back(kv.first);
+
+    const ULONGLONG deadline = GetTickCount64() + WINDOW_ENUM_BUDGET_MS;
+    for (HWND hwnd : pending) {
+        ULONGLONG now     = GetTickCount64();
+        DWORD     timeout = (now < deadline)
+                          ? static_cast<DWORD>((std::min<ULONGLONG>)(deadline - now,
+                                                                     WINDOW_QUERY_TIMEOUT_MS))
+                          : 0;
+        if (!timeout) break;   // budget spent; the rest wait for the next retry
+        WindowInfo info;
+        bool listable = IsWindow(hwnd) && QueryWindowInfo(hwnd, info, timeout);
+        Update(hwnd, listable, std::move(info), out);
+    }
+    return HasPending();
+}
+
+bool WindowModel::HasPending() const
+{
+    for (const auto& kv : windows_)
+        if (kv.second.isPending) return true;
+    return false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "window_list.h"
+#include <unordered_map>
+#include <vector>
+
+/// One change to the set of listed windows.
+enum class WindowDeltaType { Added, Changed, Removed };
+struct WindowDelta {
+    WindowDeltaType type = WindowDeltaType::Added;
+    WindowInfo      info;           // Removed: only info.hwnd is meaningful
+};
+
+/// Persistent set of listed (visible, titled) top-level windows keyed by HWND.
+/// Kept current from WinEvents via Refresh(); Resync() is the full-enumeration
+/// consistency check.  Not thread-safe: owned by the injector thread.
+class WindowModel {
+public:
+    /// Re-enumerate every top-level window and append the differences to the
+    /// current state to `out`.  budgetMs bounds the time spent waiting on
+    /// other processes; 0 asks none of them (no icons, every new window is
+    /// pending), which is how the startup enumeration stays fast.
+    void Resync(std::vector<WindowDelta>& out, DWORD budgetMs = WINDOW_ENUM_BUDGET_MS);
+
+    /// Re-examine one window after a WinEvent (EVENT_OBJECT_*) and append at
+    /// most one delta to `out`.
+    void Refresh(HWND hwnd, DWORD winEvent, std::vector<WindowDelta>& out);
+
+    /// Re-query windows listed as pending (see WindowInfo::isPending) within
+    /// one WINDOW_ENUM_BUDGET_MS budget.  Returns true if any are still pending.
+    bool RetryPending(std::vector<WindowDelta>& out);
+
+    /// True if some listed window still lacks its metadata.
+    bool HasPending() const;
+
+    /// Number of windows currently listed.
+    size_t size() const { return windows_.size(); }
+
+private:
+    void Update(HWND hwnd, bool listable, WindowInfo&& info, std::vector<WindowDelta>& out);
+
+    std::unordered_map<HWND, WindowInfo> windows_;
+};
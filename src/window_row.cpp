@@ -0,0 +1,54 @@
+#include "window_row.h"
+
+#include <cwchar>
+
+void InitWindowListColumns(HWND hList)
+{
+    static const struct { const wchar_t* name; int cx; } cols[] = {
+        { L"Title",   200 },
+        { L"Process",  90 },
+        { L"TopMost",  60 },
+        { L"Hidden",   50 },
+        { L"Capture",  56 },
+    };
+    LVCOLUMNW lvc = {};
+    lvc.mask = LVCF_TEXT | LVCF_WIDTH | LVCF_SUBITEM;
+    for (int i = 0; i < static_cast<int>(sizeof(cols) / sizeof(cols[0])); ++i) {
+        lvc.cx       = cols[i].cx;
+        lvc.pszText  = const_cast<LPWSTR>(cols[i].name);
+        lvc.iSubItem = i;
+        ListView_InsertColumn(hList, i, &lvc);
+    }
+}
+
+void FillWindowRowDispInfo(LVITEMW& item, const WindowInfo& w, const WindowRowLookups& lookups)
+{
+    if (item.mask & LVIF_TEXT) {
+        const wchar_t* text = L"";
+        switch (item.iSubItem) {
+        case 0: text = w.title.c_str();                                break;
+        case 1: text = w.processName.c_str();                          break;
+        case 2: text = (!w.isHidden && w.isTopMost) ? L"\u2713" : L""; break;
+        case 3: text = w.isHidden ? L"\u25cf" : L"";                    break;
+        case 4: if (lookups.captureText) text = lookups.captureText(w.hwnd); break;
+        }
+        if (item.pszText && item.cchTextMax > 0) {
+            // Pending rows (metadata still being fetched) get a trailing ellipsis.
+            if (item.iSubItem == 0 && w.isPending)
+                _snwprintf_s(item.pszText, item.cchTextMax, _TRUNCATE, L"%s \u2026", text);
+            else
+                wcsncpy_s(item.pszText, item.cchTextMax, text, _TRUNCATE);
+        }
+    }
+    if ((item.mask & LVIF_IMAGE) && item.iSubItem == 0) {
+        int img = lookups.iconIndex ? lookups.iconIndex(w.hwnd) : -1;
+        item.iImage = (img >= 0) ? img : I_IMAGENONE;
+    }
+    if (item.mask & LVIF_STATE) {
+        // ExcludeCapture state = checkbox state (skip for hidden windows)
+        UINT img = (!w.isHidden && w.isExcluded) ? STATE_IMAGE_CHECKED
+                                                 : STATE_IMAGE_UNCHECKED;
+        item.state     = (item.state & ~LVIS_STATEIMAGEMASK) | INDEXTOSTATEIMAGEMASK(img);
+        item.stateMask |= LVIS_STATEIMAGEMASK;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <windows.h>
+#include <commctrl.h>
+
+#include "window_list.h"
+
+/// Rendering of the main window list (a virtual LVS_OWNERDATA list view),
+/// shared by window_mod and window_mod_bench's window_list case so the bench
+/// times exactly what the dialog does.
+
+/// LVS_EX_CHECKBOXES state-image index constants (LVIS_STATEIMAGEMASK >> 12).
+static const UINT STATE_IMAGE_SHIFT     = 12;
+static const UINT STATE_IMAGE_UNCHECKED = 1;
+static const UINT STATE_IMAGE_CHECKED   = 2;
+
+/// Insert the Title, Process, TopMost, Hidden and Capture columns.
+/// ExcludeCapture is represented by the LVS_EX_CHECKBOXES checkbox.
+void InitWindowListColumns(HWND hList);
+
+/// Per-row state FillWindowRowDispInfo cannot read from WindowInfo; either
+/// lookup may be null (empty Capture column, no icon).
+struct WindowRowLookups {
+    const wchar_t* (*captureText)(HWND hwnd) = nullptr;  // Capture column text
+    int            (*iconIndex)(HWND hwnd)   = nullptr;  // image list index, -1 = none
+};
+
+/// Fill one LVN_GETDISPINFO request for row `w`: column text (pending rows
+/// get a trailing ellipsis on the title), icon, and checkbox state.
+void FillWindowRowDispInfo(LVITEMW& item, const WindowInfo& w, const WindowRowLookups& lookups);